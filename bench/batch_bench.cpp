@@ -0,0 +1,101 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+// Per-access cost of Load/Store one at a time versus the batched entry
+// points, which prefetch simulator state kBatchPrefetchDistance ops ahead.
+//
+// The footprint is random over 256 MB, so nearly every access walks to the
+// last level and the tag/policy arrays of the big levels miss in the host
+// caches: the case batching is meant for.
+//
+// Usage: batch_bench [accesses]   (default: 1 << 23)
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "stratum/cache_sim.hpp"
+#include "stratum/trace_parser.hpp"
+
+using namespace stratum;
+
+namespace {
+
+template <typename Fn>
+void Measure(const char* label, size_t n, Fn&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  uint64_t sink = fn();
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count();
+  fmt::print("{:<36} {:>8.2f} ns/access   (checksum {:x})\n", label, ns / n,
+             sink & 0xFFFF);
+}
+
+template <typename CacheType>
+uint64_t ReplayScalar(const std::vector<TraceOp>& ops) {
+  auto cache = std::make_unique<CacheType>(100);
+  uint64_t sum = 0;
+  for (const auto& op : ops) {
+    sum += (op.type == 'L' ? cache->Load(op.addr) : cache->Store(op.addr))
+               .total_cycles;
+  }
+  return sum;
+}
+
+template <typename CacheType>
+uint64_t ReplayBatched(const std::vector<TraceOp>& ops) {
+  auto cache = std::make_unique<CacheType>(100);
+  std::vector<AccessResult> results(kTraceBatchSize);
+  uint64_t sum = 0;
+  for (size_t i = 0; i < ops.size(); i += kTraceBatchSize) {
+    const auto batch = std::span(ops).subspan(
+        i, std::min(kTraceBatchSize, ops.size() - i));
+    cache->AccessBatch(batch, results);
+    for (size_t j = 0; j < batch.size(); ++j) sum += results[j].total_cycles;
+  }
+  return sum;
+}
+
+template <typename Policy>
+using Hierarchy =
+    Cache<"L1",
+          Cache<"L2", Cache<"L3", MainMemory<"MainMemory">, 32768, 16, 64,
+                            Policy, 20>,
+                1024, 8, 64, Policy, 10>,
+          64, 8, 64, Policy, 4>;
+
+using BigL1 = Cache<"L1", MainMemory<"MainMemory">, 262144, 16, 64,
+                    SRRIPPolicy, 4>;
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (1u << 23);
+
+  std::mt19937_64 rng(42);
+  std::vector<TraceOp> ops(n);
+  for (auto& op : ops) {
+    op.type = (rng() & 3) ? 'L' : 'S';
+    op.addr = (rng() % (uint64_t{256} << 20)) & ~uint64_t{7};
+  }
+
+  fmt::print("=== Batched access ({} accesses, 256 MB footprint) ===\n", n);
+  Measure("3-level LRU, one at a time", n,
+          [&] { return ReplayScalar<Hierarchy<LRUPolicy>>(ops); });
+  Measure("3-level LRU, AccessBatch", n,
+          [&] { return ReplayBatched<Hierarchy<LRUPolicy>>(ops); });
+  Measure("3-level SRRIP, one at a time", n,
+          [&] { return ReplayScalar<Hierarchy<SRRIPPolicy>>(ops); });
+  Measure("3-level SRRIP, AccessBatch", n,
+          [&] { return ReplayBatched<Hierarchy<SRRIPPolicy>>(ops); });
+  Measure("32 MB SRRIP level, one at a time", n,
+          [&] { return ReplayScalar<BigL1>(ops); });
+  Measure("32 MB SRRIP level, AccessBatch", n,
+          [&] { return ReplayBatched<BigL1>(ops); });
+  return 0;
+}
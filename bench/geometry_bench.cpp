@@ -0,0 +1,104 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+// Per-access cost of set/tag computation.
+//
+// Compares the bit-sliced power-of-two mapping against the general
+// divide/modulo path (compile-time odd geometry) and a runtime divisor, then
+// the same geometries end to end through Cache::Load.
+//
+// Usage: geometry_bench [accesses]   (default: 1 << 24)
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "stratum/cache_sim.hpp"
+#include "stratum/geometry.hpp"
+
+using namespace stratum;
+
+namespace {
+
+template <typename Fn>
+void Measure(const char* label, size_t n, Fn&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  uint64_t sink = fn();
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count();
+  fmt::print("{:<36} {:>8.2f} ns/access   (checksum {:x})\n", label, ns / n,
+             sink & 0xFFFF);
+}
+
+template <size_t Sets, size_t BlockSize>
+uint64_t MapAll(const std::vector<uint64_t>& addrs) {
+  using M = AddressMapping<Sets, BlockSize>;
+  uint64_t sum = 0;
+  for (uint64_t a : addrs) {
+    uint64_t set = M::SetIndex(a);
+    uint64_t tag = M::Tag(a);
+    sum += M::BlockAddress(tag, set) ^ set;
+  }
+  return sum;
+}
+
+// Geometry only known at run time: what a non-templated simulator pays.
+uint64_t MapAllRuntime(const std::vector<uint64_t>& addrs, uint64_t sets,
+                       uint64_t block) {
+  uint64_t sum = 0;
+  for (uint64_t a : addrs) {
+    uint64_t set = (a / block) % sets;
+    uint64_t tag = a / (block * sets);
+    sum += ((tag * sets + set) * block) ^ set;
+  }
+  return sum;
+}
+
+template <typename CacheType>
+uint64_t ReplayLoads(const std::vector<uint64_t>& addrs) {
+  auto cache = std::make_unique<CacheType>(100);
+  uint64_t sum = 0;
+  for (uint64_t a : addrs) sum += cache->Load(a).total_cycles;
+  return sum;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (1u << 24);
+
+  // 1 MB footprint: misses an L1-sized cache often, stays in host L2/L3.
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> addrs(n);
+  for (auto& a : addrs) a = (rng() % (1u << 20)) & ~uint64_t{7};
+
+  // Keep the runtime divisor opaque to the optimizer.
+  volatile uint64_t sets = 64;
+  volatile uint64_t block = 64;
+
+  fmt::print("=== Address mapping ({} accesses) ===\n", n);
+  Measure("pow2 64x64 (shift/mask)", n, [&] { return MapAll<64, 64>(addrs); });
+#if !STRATUM_REQUIRE_POW2_GEOMETRY
+  Measure("odd 48x64 (div/mod by constant)", n,
+          [&] { return MapAll<48, 64>(addrs); });
+#endif
+  Measure("runtime 64x64 (hardware divide)", n,
+          [&] { return MapAllRuntime(addrs, sets, block); });
+
+  using Mem = MainMemory<"MainMemory">;
+  fmt::print("\n=== Cache::Load, 8-way ===\n");
+  Measure("Cache 64 sets (pow2)", n, [&] {
+    return ReplayLoads<Cache<"L1", Mem, 64, 8, 64, LRUPolicy, 4>>(addrs);
+  });
+#if !STRATUM_REQUIRE_POW2_GEOMETRY
+  Measure("Cache 48 sets (general path)", n, [&] {
+    return ReplayLoads<Cache<"L1", Mem, 48, 8, 64, LRUPolicy, 4>>(addrs);
+  });
+#endif
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+// Trace parser throughput: reference stringstream parser vs. the
+// memory-mapped zero-copy parser, on test/data traces scaled up.
+//
+// Usage: parser_bench [scale]   (default scale: 200 copies of test/data)
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "stratum/trace_parser.hpp"
+
+using namespace stratum;
+
+namespace {
+
+// Concatenates every test/data trace `scale` times into a temporary file.
+std::string BuildScaledTrace(size_t scale) {
+  const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+  std::string corpus;
+  for (const char* name : {"sequential.txt", "random.txt", "temporal.txt",
+                           "spatial.txt", "largeloop.txt", "gaussian.txt"}) {
+    std::ifstream in(data_dir + name);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    corpus += ss.str();
+  }
+
+  const std::string path = "parser_bench_trace.txt";
+  std::ofstream out(path, std::ios::binary);
+  for (size_t i = 0; i < scale; ++i) out << corpus;
+  return path;
+}
+
+template <typename Fn>
+void Measure(const char* label, size_t bytes, Fn&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  size_t ops = fn();
+  auto end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - start).count();
+  fmt::print("{:<28} {:>12} {:>10.3f} {:>12.1f} {:>10.1f}\n", label, ops, sec,
+             ops / sec / 1e6, bytes / sec / 1e6);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t scale = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200;
+  std::string path = BuildScaledTrace(scale);
+  size_t bytes = MappedFile(path).Size();
+
+  fmt::print("Trace: {} ({:.1f} MB, scale {})\n", path, bytes / 1e6, scale);
+  fmt::print("{:<28} {:>12} {:>10} {:>12} {:>10}\n", "Parser", "Ops", "Sec",
+             "Mops/s", "MB/s");
+
+  Measure("ParseTraceFile (sstream)", bytes,
+          [&] { return ParseTraceFile(path).size(); });
+  Measure("ParseTraceFileMapped", bytes,
+          [&] { return ParseTraceFileMapped(path).size(); });
+  Measure("MappedTraceReader batches", bytes, [&] {
+    MappedTraceReader reader(path);
+    std::vector<TraceOp> batch;
+    batch.reserve(kTraceBatchSize);
+    size_t ops = 0;
+    uint64_t checksum = 0;
+    while (reader.ReadBatch(batch) > 0) {
+      ops += batch.size();
+      for (const auto& op : batch) checksum += op.addr;
+    }
+    if (checksum == 0) fmt::print("(empty trace)\n");
+    return ops;
+  });
+
+  std::remove(path.c_str());
+  return 0;
+}
@@ -0,0 +1,372 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+// Throughput suite for the simulator core (Google Benchmark).
+//
+// Every benchmark reports items_per_second = simulated (or parsed) accesses
+// per second, so runs can be compared to gate performance regressions:
+//
+//   Parse/<pattern>                 zero-copy text parser on an in-memory
+//                                   buffer
+//   Access/<case>/<pattern>         Load/Store hot path on ops already in
+//                                   memory, per config.rkt geometry and policy
+//   AccessBatch/<case>/<pattern>    the same through Cache::AccessBatch
+//   Timed/<case>/<pattern>          Access plus TimingModel (timing.hpp)
+//   Dynamic/<case>/<pattern>        Access on the DynamicCache built from
+//                                   the same config (dynamic_cache.hpp)
+//   RunTraceSimulation/<fmt>/<pattern>
+//                                   end to end from a trace file
+//
+// Traces come from in-memory generators equivalent to
+// scripts/gen_test_data.py, so parser cost never mixes with simulation cost.
+//
+// Usage: stratum_bench [--ops=N] [--file-ops=N] [benchmark flags]
+//   --ops=N        Ops per simulated trace (default: 100000000)
+//   --file-ops=N   Ops per parsed or file-backed trace (default: 16777216)
+//   e.g. --benchmark_filter='Access/case_001' --benchmark_format=json
+
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/cache_sim.hpp"
+#include "stratum/dynamic_cache.hpp"
+#include "stratum/simulation.hpp"
+#include "stratum/timing.hpp"
+#include "stratum/trace_parser.hpp"
+
+using namespace stratum;
+
+namespace {
+
+// --- Synthetic traces (scripts/gen_test_data.py) ---------------------------
+
+enum class Pattern {
+  kSequential,
+  kRandom,
+  kTemporal,
+  kSpatial,
+  kLargeLoop,
+  kGaussian
+};
+
+constexpr Pattern kPatterns[] = {Pattern::kSequential, Pattern::kRandom,
+                                 Pattern::kTemporal,   Pattern::kSpatial,
+                                 Pattern::kLargeLoop,  Pattern::kGaussian};
+
+std::string_view PatternName(Pattern p) {
+  constexpr std::string_view kNames[] = {"Sequential", "Random", "Temporal",
+                                         "Spatial",    "LargeLoop",
+                                         "Gaussian"};
+  return kNames[static_cast<size_t>(p)];
+}
+
+std::vector<TraceOp> Generate(Pattern pattern, size_t count) {
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+  std::normal_distribution<double> gauss(0x80000, 1000 * 64);
+  std::vector<TraceOp> ops(count);
+  for (size_t i = 0; i < count; ++i) {
+    TraceOp& op = ops[i];
+    op.type = 'L';
+    switch (pattern) {
+      case Pattern::kSequential:  // stride = block size
+        op.type = coin(rng) < 0.2 ? 'S' : 'L';
+        op.addr = 0x1000 + i * 0x40;
+        break;
+      case Pattern::kRandom:  // uniform over 64 MB
+        op.type = coin(rng) < 0.3 ? 'S' : 'L';
+        op.addr = (rng() % 0x100000) * 0x40;
+        break;
+      case Pattern::kTemporal:  // 5 hot blocks
+        op.addr = 0x1000 + (rng() % 5) * 0x1000;
+        break;
+      case Pattern::kSpatial:  // 8 words per block
+        op.addr = 0x50000 + (i / 8) * 64 + (i % 8) * 8;
+        break;
+      case Pattern::kLargeLoop:  // 64 KB loop
+        op.addr = 0x20000 + (i % 1024) * 64;
+        break;
+      case Pattern::kGaussian: {  // sigma ~ 1000 blocks around 0x80000
+        op.type = coin(rng) < 0.2 ? 'S' : 'L';
+        const double v = std::max(gauss(rng), 0.0);
+        op.addr = static_cast<uint64_t>(v) / 64 * 64;
+        break;
+      }
+    }
+  }
+  return ops;
+}
+
+// Holds the most recently generated trace. Benchmarks are registered
+// pattern-major, so each 10^8-op trace is built once and only one is alive.
+const std::vector<TraceOp>& Trace(Pattern pattern, size_t count) {
+  static Pattern cached_pattern;
+  static std::vector<TraceOp> cached;
+  if (cached.size() != count || cached_pattern != pattern) {
+    cached.clear();
+    cached.shrink_to_fit();
+    cached = Generate(pattern, count);
+    cached_pattern = pattern;
+  }
+  return cached;
+}
+
+std::string RenderText(const std::vector<TraceOp>& ops) {
+  std::string text = "# Type  Addr\n";
+  text.reserve(ops.size() * 16);
+  for (const auto& op : ops) {
+    text += fmt::format("{}       0x{:X}\n", op.type, op.addr);
+  }
+  return text;
+}
+
+// Silences stdout (RunTraceSimulation's report) for its lifetime.
+class QuietStdout {
+  int saved_;
+
+ public:
+  QuietStdout() {
+    std::fflush(stdout);
+    saved_ = ::dup(STDOUT_FILENO);
+    const int null = ::open("/dev/null", O_WRONLY);
+    ::dup2(null, STDOUT_FILENO);
+    ::close(null);
+  }
+  ~QuietStdout() {
+    std::fflush(stdout);
+    ::dup2(saved_, STDOUT_FILENO);
+    ::close(saved_);
+  }
+};
+
+// --- Configurations (scripts/config.rkt) -----------------------------------
+
+using MemType = MainMemory<"MainMemory">;
+
+template <typename Policy>
+using ThreeLevel =
+    Cache<"L1",
+          Cache<"L2", Cache<"L3", MemType, 8192, 16, 64, Policy, 64>, 512, 8,
+                64, Policy, 64>,
+          64, 8, 64, Policy, 4>;
+
+template <typename Policy>
+using TwoLevel =
+    Cache<"L1", Cache<"L2", MemType, 512, 8, 64, Policy, 64>, 64, 8, 64,
+          Policy, 4>;
+
+// --- Benchmarks ------------------------------------------------------------
+
+void BM_Parse(benchmark::State& state, Pattern pattern, size_t count) {
+  const std::string text = RenderText(Generate(pattern, count));
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    ForEachTraceOp(text, [&](const TraceOp& op) { sum += op.addr; });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+template <typename System>
+void BM_Access(benchmark::State& state, Pattern pattern, size_t count) {
+  const auto& ops = Trace(pattern, count);
+  for (auto _ : state) {
+    auto system = std::make_unique<System>(100);
+    uint64_t cycles = 0;
+    for (const auto& op : ops) {
+      cycles += (op.type == 'L' ? system->Load(op.addr)
+                                : system->Store(op.addr))
+                    .total_cycles;
+    }
+    benchmark::DoNotOptimize(cycles);
+  }
+  state.SetItemsProcessed(state.iterations() * ops.size());
+}
+
+template <typename System>
+void BM_AccessBatch(benchmark::State& state, Pattern pattern, size_t count) {
+  const auto& ops = Trace(pattern, count);
+  std::vector<AccessResult> results(kTraceBatchSize);
+  for (auto _ : state) {
+    auto system = std::make_unique<System>(100);
+    uint64_t cycles = 0;
+    for (size_t i = 0; i < ops.size(); i += kTraceBatchSize) {
+      const auto batch = std::span(ops).subspan(
+          i, std::min(kTraceBatchSize, ops.size() - i));
+      system->AccessBatch(batch, results);
+      for (size_t j = 0; j < batch.size(); ++j) {
+        cycles += results[j].total_cycles;
+      }
+    }
+    benchmark::DoNotOptimize(cycles);
+  }
+  state.SetItemsProcessed(state.iterations() * ops.size());
+}
+
+template <typename System>
+void BM_Timed(benchmark::State& state, Pattern pattern, size_t count) {
+  const auto& ops = Trace(pattern, count);
+  for (auto _ : state) {
+    auto system = std::make_unique<System>(100);
+    TimingModel<System> timing;
+    uint64_t cycles = 0;
+    for (const auto& op : ops) {
+      cycles += timing
+                    .Time(op, op.type == 'L' ? system->Load(op.addr)
+                                             : system->Store(op.addr))
+                    .total_cycles;
+    }
+    benchmark::DoNotOptimize(cycles);
+  }
+  state.SetItemsProcessed(state.iterations() * ops.size());
+}
+
+void BM_Dynamic(benchmark::State& state, std::string_view config,
+                Pattern pattern, size_t count) {
+  const auto& ops = Trace(pattern, count);
+  const auto configs = ParseHierarchyConfigs(config);
+  for (auto _ : state) {
+    DynamicCache system(configs.front(), 100);
+    uint64_t cycles = 0;
+    for (const auto& op : ops) {
+      cycles += (op.type == 'L' ? system.Load(op.addr)
+                                : system.Store(op.addr))
+                    .total_cycles;
+    }
+    benchmark::DoNotOptimize(cycles);
+  }
+  state.SetItemsProcessed(state.iterations() * ops.size());
+}
+
+// case_001 of config.rkt, for DynamicCache.
+constexpr std::string_view kDynamicCase001 =
+    "(case_001 (L1 64 8 4 LRUPolicy L2) (L2 512 8 64 LRUPolicy L3)"
+    "          (L3 8192 16 64 LRUPolicy MainMemory))";
+
+// Trace files written so far, removed when the suite exits.
+std::vector<std::string>& WrittenFiles() {
+  static std::vector<std::string> files;
+  return files;
+}
+
+// Path of `pattern` as a text or binary trace file, written on first use so
+// filtered-out benchmarks cost nothing.
+std::string TraceFile(Pattern pattern, bool binary, size_t count) {
+  const std::string path = fmt::format(
+      "stratum_bench_{}_{}.{}", PatternName(pattern), count,
+      binary ? "bin" : "txt");
+  if (std::find(WrittenFiles().begin(), WrittenFiles().end(), path) !=
+      WrittenFiles().end()) {
+    return path;
+  }
+  const auto ops = Generate(pattern, count);
+  if (binary) {
+    BinaryTraceWriter writer(path, 1, TraceEncoding::kDeltaVarint);
+    for (const auto& op : ops) writer.Append(op);
+  } else {
+    const std::string text = RenderText(ops);
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file != nullptr) {
+      std::fwrite(text.data(), 1, text.size(), file);
+      std::fclose(file);
+    }
+  }
+  WrittenFiles().push_back(path);
+  return path;
+}
+
+void BM_RunTraceSimulation(benchmark::State& state, Pattern pattern,
+                           bool binary, size_t count) {
+  const std::string path = TraceFile(pattern, binary, count);
+  for (auto _ : state) {
+    QuietStdout quiet;
+    RunTraceSimulation<ThreeLevel<LRUPolicy>>("bench", path);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename System>
+void RegisterAccess(std::string_view name, Pattern pattern, size_t ops) {
+  const auto suffix = fmt::format("{}/{}", name, PatternName(pattern));
+  benchmark::RegisterBenchmark(("Access/" + suffix).c_str(),
+                               BM_Access<System>, pattern, ops)
+      ->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark(("AccessBatch/" + suffix).c_str(),
+                               BM_AccessBatch<System>, pattern, ops)
+      ->Unit(benchmark::kMillisecond);
+}
+
+size_t ParseCount(std::string_view arg, std::string_view prefix) {
+  return std::strtoull(arg.data() + prefix.size(), nullptr, 10);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  size_t ops = 100'000'000;
+  size_t file_ops = size_t{1} << 24;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg.starts_with("--ops=")) {
+      ops = ParseCount(arg, "--ops=");
+    } else if (arg.starts_with("--file-ops=")) {
+      file_ops = ParseCount(arg, "--file-ops=");
+    } else {
+      fmt::print(stderr, "Unknown argument: {}\n", arg);
+      return 1;
+    }
+  }
+  if (ops == 0 || file_ops == 0) return 1;
+
+  for (Pattern pattern : kPatterns) {
+    benchmark::RegisterBenchmark(
+        fmt::format("Parse/{}", PatternName(pattern)).c_str(), BM_Parse,
+        pattern, file_ops)
+        ->Unit(benchmark::kMillisecond);
+  }
+  for (Pattern pattern : kPatterns) {
+    RegisterAccess<ThreeLevel<LRUPolicy>>("case_001", pattern, ops);
+    RegisterAccess<TwoLevel<LRUPolicy>>("case_002", pattern, ops);
+    RegisterAccess<ThreeLevel<FIFOPolicy>>("case_003_fifo", pattern, ops);
+    RegisterAccess<TwoLevel<RandomPolicy>>("case_004_random", pattern, ops);
+    benchmark::RegisterBenchmark(
+        fmt::format("Timed/case_001/{}", PatternName(pattern)).c_str(),
+        BM_Timed<ThreeLevel<LRUPolicy>>, pattern, ops)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(
+        fmt::format("Dynamic/case_001/{}", PatternName(pattern)).c_str(),
+        BM_Dynamic, kDynamicCase001, pattern, ops)
+        ->Unit(benchmark::kMillisecond);
+  }
+  for (Pattern pattern : kPatterns) {
+    for (bool binary : {false, true}) {
+      benchmark::RegisterBenchmark(
+          fmt::format("RunTraceSimulation/{}/{}", binary ? "Binary" : "Text",
+                      PatternName(pattern))
+              .c_str(),
+          BM_RunTraceSimulation, pattern, binary, file_ops)
+          ->Unit(benchmark::kMillisecond);
+    }
+  }
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  for (const auto& path : WrittenFiles()) std::remove(path.c_str());
+  return 0;
+}
@@ -0,0 +1,126 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+namespace stratum {
+
+// Build with -DSTRATUM_HUGE_PAGES=0 (CMake option of the same name) to keep
+// hierarchy arenas on regular pages. By default arenas of at least one huge
+// page ask the kernel for transparent huge pages.
+#ifndef STRATUM_HUGE_PAGES
+#define STRATUM_HUGE_PAGES 1
+#endif
+
+inline constexpr bool kArenaHugePages = STRATUM_HUGE_PAGES;
+
+// Every arena allocation starts on its own host cache line.
+inline constexpr size_t kArenaAlign = 64;
+
+inline constexpr size_t kHugePageSize = size_t{2} << 20;
+
+// Bytes an arena reserves for `count` objects of type T.
+template <typename T>
+constexpr size_t ArenaBytes(size_t count) {
+  static_assert(alignof(T) <= kArenaAlign);
+  return (count * sizeof(T) + kArenaAlign - 1) / kArenaAlign * kArenaAlign;
+}
+
+// One zero-filled, page-aligned anonymous mapping carved up by a bump
+// pointer. A hierarchy sizes it from its compile-time geometry (see
+// Cache::kArenaBytes), so all tag, dirty and policy arrays of every level
+// share a single allocation and a handful of (huge) pages.
+class Arena {
+  std::byte* base_ = nullptr;
+  size_t size_ = 0;
+  size_t used_ = 0;
+
+ public:
+  Arena() = default;
+
+  explicit Arena(size_t bytes) : size_(bytes) {
+    if (bytes == 0) return;
+    void* ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+    if (kArenaHugePages && bytes >= kHugePageSize) {
+      ::madvise(ptr, bytes, MADV_HUGEPAGE);
+    }
+#endif
+    base_ = static_cast<std::byte*>(ptr);
+  }
+
+  ~Arena() {
+    if (base_ != nullptr) ::munmap(base_, size_);
+  }
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Returns storage for `count` uninitialized objects of type T.
+  template <typename T>
+  T* Allocate(size_t count) {
+    const size_t bytes = ArenaBytes<T>(count);
+    if (used_ + bytes > size_) {
+      // Sizes come from constexpr geometry; running out is a layout bug.
+      std::fprintf(stderr, "Error: Arena overflow (%zu + %zu > %zu bytes)\n",
+                   used_, bytes, size_);
+      std::abort();
+    }
+    T* p = reinterpret_cast<T*>(base_ + used_);
+    used_ += bytes;
+    return p;
+  }
+
+  [[nodiscard]] size_t Size() const { return size_; }
+  [[nodiscard]] size_t Used() const { return used_; }
+};
+
+// Fixed-size array that lives in an Arena when given one and on the heap
+// otherwise, so a policy works both inside a hierarchy and standalone.
+template <typename T>
+class ArenaArray {
+  std::unique_ptr<T[]> owned_;
+  T* data_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  ArenaArray(size_t count, T init, Arena* arena) : size_(count) {
+    if (arena != nullptr) {
+      data_ = arena->Allocate<T>(count);
+    } else {
+      owned_ = std::make_unique<T[]>(count);
+      data_ = owned_.get();
+    }
+    std::fill_n(data_, count, init);
+  }
+
+  void Fill(T value) noexcept { std::fill_n(data_, size_, value); }
+
+  T& operator[](size_t i) noexcept { return data_[i]; }
+  const T& operator[](size_t i) const noexcept { return data_[i]; }
+
+  [[nodiscard]] T* data() noexcept { return data_; }
+  [[nodiscard]] const T* data() const noexcept { return data_; }
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+
+  T* begin() noexcept { return data_; }
+  T* end() noexcept { return data_ + size_; }
+  const T* begin() const noexcept { return data_; }
+  const T* end() const noexcept { return data_ + size_; }
+};
+
+}  // namespace stratum
+
+#endif  // ARENA_HPP
@@ -0,0 +1,355 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef BINARY_TRACE_HPP
+#define BINARY_TRACE_HPP
+
+#include <fmt/core.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stratum/mapped_file.hpp"
+#include "stratum/trace_parser.hpp"
+
+namespace stratum {
+
+// ============================================================================
+// Binary Trace Format (version 1)
+// ============================================================================
+// Layout: [BinaryTraceHeader][records...], all integers little-endian.
+//
+// Addresses are stored as block numbers (addr / block_size), so a trace
+// converted with block_size 64 replays identically on any hierarchy whose
+// block sizes are multiples of 64. Use block_size 1 to keep exact addresses.
+//
+// Record encodings:
+//   kPacked:      one uint64 per op: (block << 1) | is_store
+//   kDeltaVarint: LEB128 varint of (zigzag(block - prev_block) << 1) | is_store
+//                 Sequential and looping traces shrink to 1-2 bytes per op.
+//
+// Block numbers are limited to 63 bits (the L/S flag takes the 64th).
+
+enum class TraceEncoding : uint16_t { kPacked = 0, kDeltaVarint = 1 };
+
+struct BinaryTraceHeader {
+  char magic[4] = {'S', 'T', 'R', 'T'};
+  uint16_t version = 1;
+  TraceEncoding encoding = TraceEncoding::kDeltaVarint;
+  uint32_t block_size = 64;
+  uint32_t reserved = 0;
+  uint64_t op_count = 0;
+};
+static_assert(sizeof(BinaryTraceHeader) == 24, "header layout is on-disk ABI");
+
+inline constexpr uint16_t kBinaryTraceVersion = 1;
+inline constexpr uint64_t kBlockNumberMask = ~0ULL >> 1;
+
+// True if the file starts with the binary trace magic.
+inline bool IsBinaryTraceFile(const std::string& filename) {
+  char magic[4] = {};
+  std::FILE* f = std::fopen(filename.c_str(), "rb");
+  if (f == nullptr) return false;
+  size_t n = std::fread(magic, 1, sizeof(magic), f);
+  std::fclose(f);
+  return n == sizeof(magic) && std::memcmp(magic, "STRT", 4) == 0;
+}
+
+namespace detail {
+
+// Zigzag over 63-bit two's complement deltas (see kBlockNumberMask).
+constexpr uint64_t ZigZag63(uint64_t delta) {
+  int64_t s = static_cast<int64_t>(delta << 1) >> 1;  // sign-extend bit 62
+  return ((static_cast<uint64_t>(s) << 1) ^ static_cast<uint64_t>(s >> 63)) &
+         kBlockNumberMask;
+}
+
+constexpr uint64_t UnZigZag63(uint64_t zz) {
+  return ((zz >> 1) ^ (0 - (zz & 1))) & kBlockNumberMask;
+}
+
+// Little-endian `bytes`-byte integer at `p`.
+inline void StoreLE(uint8_t* p, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    p[i] = static_cast<uint8_t>(value >> 8 * i);
+  }
+}
+
+inline uint64_t LoadLE(const uint8_t* p, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) value |= uint64_t{p[i]} << 8 * i;
+  return value;
+}
+
+// The on-disk bytes of a header, independent of the host byte order.
+using HeaderBytes = std::array<uint8_t, sizeof(BinaryTraceHeader)>;
+
+inline HeaderBytes EncodeHeader(const BinaryTraceHeader& h) {
+  HeaderBytes out{};
+  std::memcpy(out.data(), h.magic, 4);
+  StoreLE(&out[4], h.version, 2);
+  StoreLE(&out[6], static_cast<uint16_t>(h.encoding), 2);
+  StoreLE(&out[8], h.block_size, 4);
+  StoreLE(&out[12], h.reserved, 4);
+  StoreLE(&out[16], h.op_count, 8);
+  return out;
+}
+
+inline BinaryTraceHeader DecodeHeader(const uint8_t* in) {
+  BinaryTraceHeader h;
+  std::memcpy(h.magic, in, 4);
+  h.version = static_cast<uint16_t>(LoadLE(&in[4], 2));
+  h.encoding = static_cast<TraceEncoding>(LoadLE(&in[6], 2));
+  h.block_size = static_cast<uint32_t>(LoadLE(&in[8], 4));
+  h.reserved = static_cast<uint32_t>(LoadLE(&in[12], 4));
+  h.op_count = LoadLE(&in[16], 8);
+  return h;
+}
+
+}  // namespace detail
+
+// Streaming writer. The op count is patched into the header on Close().
+// A failed write (e.g. a full disk) stops further writes and leaves the
+// header's op count at 0, so the partial file never reads as complete;
+// Close() and Ok() report it.
+//
+// Example:
+//   BinaryTraceWriter writer("trace.bin", 64);
+//   writer.Append({'L', 0x1000});
+//   if (!writer.Close()) { /* trace.bin is incomplete */ }
+//
+// Constructed from a std::string instead of a path, the writer encodes into
+// that string, which BinaryTraceReader can then decode in place.
+class BinaryTraceWriter {
+  std::FILE* file_ = nullptr;
+  std::string* sink_ = nullptr;
+  BinaryTraceHeader header_;
+  uint64_t prev_block_ = 0;
+  std::vector<uint8_t> buffer_;
+  bool failed_ = false;
+
+  static constexpr size_t kFlushBytes = 1 << 20;
+
+ public:
+  BinaryTraceWriter(const std::string& filename, uint32_t block_size = 64,
+                    TraceEncoding encoding = TraceEncoding::kDeltaVarint) {
+    header_.block_size = block_size == 0 ? 1 : block_size;
+    header_.encoding = encoding;
+    file_ = std::fopen(filename.c_str(), "wb");
+    if (file_ == nullptr) {
+      fmt::print(stderr, "Error: Could not create trace file {}\n", filename);
+      failed_ = true;
+      return;
+    }
+    buffer_.reserve(kFlushBytes + 16);
+    WriteHeader();
+  }
+
+  // Replaces the contents of `sink`, which must outlive the writer.
+  explicit BinaryTraceWriter(
+      std::string& sink, uint32_t block_size = 64,
+      TraceEncoding encoding = TraceEncoding::kDeltaVarint)
+      : sink_(&sink) {
+    header_.block_size = block_size == 0 ? 1 : block_size;
+    header_.encoding = encoding;
+    buffer_.reserve(kFlushBytes + 16);
+    const detail::HeaderBytes bytes = detail::EncodeHeader(header_);
+    sink_->assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  }
+
+  ~BinaryTraceWriter() { Close(); }
+
+  BinaryTraceWriter(const BinaryTraceWriter&) = delete;
+  BinaryTraceWriter& operator=(const BinaryTraceWriter&) = delete;
+
+  [[nodiscard]] bool IsOpen() const {
+    return file_ != nullptr || sink_ != nullptr;
+  }
+  [[nodiscard]] uint64_t OpCount() const { return header_.op_count; }
+
+  // False if the file could not be created or a write to it failed.
+  [[nodiscard]] bool Ok() const { return !failed_; }
+
+  // No-op unless IsOpen().
+  void Append(const TraceOp& op) {
+    if (!IsOpen()) return;
+    const uint64_t block = (op.addr / header_.block_size) & kBlockNumberMask;
+    const uint64_t store = op.type == 'S' ? 1 : 0;
+
+    if (header_.encoding == TraceEncoding::kPacked) {
+      uint8_t bytes[8];
+      detail::StoreLE(bytes, (block << 1) | store, 8);
+      buffer_.insert(buffer_.end(), bytes, bytes + 8);
+    } else {
+      uint64_t v =
+          (detail::ZigZag63((block - prev_block_) & kBlockNumberMask) << 1) |
+          store;
+      while (v >= 0x80) {
+        buffer_.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+      }
+      buffer_.push_back(static_cast<uint8_t>(v));
+      prev_block_ = block;
+    }
+
+    header_.op_count++;
+    if (buffer_.size() >= kFlushBytes) Flush();
+  }
+
+  // Flushes pending records and finalizes the header. Idempotent. Returns
+  // Ok().
+  bool Close() {
+    if (sink_ != nullptr) {
+      Flush();
+      const detail::HeaderBytes bytes = detail::EncodeHeader(header_);
+      sink_->replace(0, bytes.size(),
+                     reinterpret_cast<const char*>(bytes.data()), bytes.size());
+      sink_ = nullptr;
+      return Ok();
+    }
+    if (file_ == nullptr) return Ok();
+    Flush();
+    if (!failed_) {
+      // Only a complete trace gets its op count.
+      failed_ = std::fseek(file_, 0, SEEK_SET) != 0;
+      WriteHeader();
+    }
+    failed_ |= std::fclose(file_) != 0;
+    file_ = nullptr;
+    return Ok();
+  }
+
+ private:
+  // No-op unless IsOpen().
+  void Flush() {
+    if (buffer_.empty() || !IsOpen()) return;
+    if (sink_ != nullptr) {
+      sink_->append(reinterpret_cast<const char*>(buffer_.data()),
+                    buffer_.size());
+    } else {
+      Write(buffer_.data(), buffer_.size());
+    }
+    buffer_.clear();
+  }
+
+  void WriteHeader() {
+    const detail::HeaderBytes bytes = detail::EncodeHeader(header_);
+    Write(bytes.data(), bytes.size());
+  }
+
+  // Writes to file_ unless a write already failed.
+  void Write(const void* data, size_t size) {
+    failed_ = failed_ || std::fwrite(data, 1, size, file_) != size;
+  }
+};
+
+// Memory-mapped binary trace reader with the same ReadBatch contract as
+// MappedTraceReader, so RunTraceSimulation can consume either.
+//
+// The reader can also decode a buffer it does not own (e.g. one MappedFile
+// shared read-only by several sweep workers, each with its own cursor).
+class BinaryTraceReader {
+  std::optional<MappedFile> file_;
+  BinaryTraceHeader header_;
+  const uint8_t* cursor_ = nullptr;
+  const uint8_t* end_ = nullptr;
+  uint64_t prev_block_ = 0;
+  uint64_t remaining_ = 0;
+  bool valid_ = false;
+
+ public:
+  explicit BinaryTraceReader(const std::string& filename)
+      : file_(std::in_place, filename) {
+    if (file_->IsOpen()) Open(file_->View(), filename);
+  }
+
+  // Decodes `data` in place; the caller keeps it alive for the reader's
+  // lifetime.
+  explicit BinaryTraceReader(std::string_view data) {
+    Open(data, "<buffer>");
+  }
+
+  [[nodiscard]] bool IsOpen() const { return valid_; }
+  [[nodiscard]] const BinaryTraceHeader& Header() const { return header_; }
+
+  [[nodiscard]] TraceProgress Progress() const {
+    return {header_.op_count - remaining_, header_.op_count};
+  }
+
+  // Replaces the contents of `batch` with up to `max_ops` operations.
+  // Returns the number of operations read; 0 means end of trace.
+  size_t ReadBatch(std::vector<TraceOp>& batch,
+                   size_t max_ops = kTraceBatchSize) {
+    batch.clear();
+    if (!valid_) return 0;
+
+    const uint64_t block_size = header_.block_size;
+    while (batch.size() < max_ops && remaining_ > 0) {
+      uint64_t rec;
+      if (header_.encoding == TraceEncoding::kPacked) {
+        if (end_ - cursor_ < 8) break;
+        rec = detail::LoadLE(cursor_, 8);
+        cursor_ += 8;
+        prev_block_ = rec >> 1;
+      } else {
+        if (!ReadVarint(rec)) break;
+        prev_block_ =
+            (prev_block_ + detail::UnZigZag63(rec >> 1)) & kBlockNumberMask;
+      }
+      batch.push_back({(rec & 1) ? 'S' : 'L', prev_block_ * block_size});
+      remaining_--;
+    }
+
+    if (batch.size() < max_ops && remaining_ > 0) {
+      fmt::print(stderr, "Warning: Binary trace truncated, {} ops missing\n",
+                 remaining_);
+      remaining_ = 0;
+    }
+    return batch.size();
+  }
+
+ private:
+  void Open(std::string_view data, const std::string& name) {
+    if (data.size() < sizeof(header_)) {
+      fmt::print(stderr, "Error: Truncated binary trace {}\n", name);
+      return;
+    }
+    header_ =
+        detail::DecodeHeader(reinterpret_cast<const uint8_t*>(data.data()));
+    if (std::memcmp(header_.magic, "STRT", 4) != 0 ||
+        header_.version != kBinaryTraceVersion || header_.block_size == 0 ||
+        (header_.encoding != TraceEncoding::kPacked &&
+         header_.encoding != TraceEncoding::kDeltaVarint)) {
+      fmt::print(stderr, "Error: Unsupported binary trace {}\n", name);
+      return;
+    }
+
+    cursor_ = reinterpret_cast<const uint8_t*>(data.data()) + sizeof(header_);
+    end_ = reinterpret_cast<const uint8_t*>(data.data()) + data.size();
+    remaining_ = header_.op_count;
+    valid_ = true;
+  }
+
+  bool ReadVarint(uint64_t& value) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && cursor_ < end_; shift += 7) {
+      const uint8_t byte = *cursor_++;
+      v |= uint64_t{byte & 0x7Fu} << shift;
+      if ((byte & 0x80) == 0) {
+        value = v;
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+}  // namespace stratum
+
+#endif  // BINARY_TRACE_HPP
@@ -6,75 +6,203 @@
 #include <fmt/core.h>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
-#include <map>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "stratum/arena.hpp"
+#include "stratum/geometry.hpp"
+#include "stratum/histogram.hpp"
+#include "stratum/instrumentation.hpp"
+#include "stratum/level_policies.hpp"
 #include "stratum/policies.hpp"
+#include "stratum/prefetch.hpp"
+#include "stratum/prefetchers.hpp"
+#include "stratum/set_sampling.hpp"
+#include "stratum/snapshot.hpp"
+#include "stratum/tag_match.hpp"
+#include "stratum/trace_parser.hpp"
 
 namespace stratum {
 
+// Result of a single access.
+//
+// hit_level is the index of the level that served the access, counted from
+// the level the access entered (0 = L1 when issued at the top). Each Cache
+// on the miss path adds one on the way back up, so no names or strings are
+// touched per access; names are resolved only when a report is printed.
 struct AccessResult {
-  std::string hit_level;
+  uint32_t hit_level;
   size_t total_cycles;
 };
 
+// Outcome of a coherence probe (Cache::Invalidate / Cache::Clean) over a
+// level and the levels below it.
+struct ProbeResult {
+  bool present = false;  // some level held the block
+  bool dirty = false;    // some copy was dirty; the caller now owns the data
+
+  ProbeResult& operator|=(const ProbeResult& other) {
+    present |= other.present;
+    dirty |= other.dirty;
+    return *this;
+  }
+};
+
 struct CacheStats {
   size_t hits = 0;
   size_t misses = 0;
   size_t total_latency = 0;
 };
 
-inline void PrintSimulationStats(const std::vector<AccessResult>& history,
-                                 const std::vector<std::string>& hierarchy) {
-  std::map<std::string, CacheStats> stats_db;
-
-  for (const auto& res : history) {
-    bool hit_found = false;
-    for (const auto& level_name : hierarchy) {
-      if (level_name == res.hit_level) {
-        stats_db[level_name].hits++;
-        stats_db[level_name].total_latency += res.total_cycles;
-        hit_found = true;
-        break;
-      } else {
-        stats_db[level_name].misses++;
-      }
+// Compile-time description of one level of a hierarchy.
+// MainMemory reports sets/ways/block_size as 0; its latency is a runtime
+// constructor argument, so hit_latency is 0 there as well.
+struct LevelInfo {
+  std::string_view name;
+  size_t sets = 0;
+  size_t ways = 0;
+  size_t block_size = 0;
+  size_t hit_latency = 0;
+  bool is_memory = false;
+};
+
+enum class AccessType { kLoad, kStore };
+
+// Incremental per-level statistics over a hierarchy of `Levels` levels.
+//
+// Only hits and latency are counted per access, in plain arrays indexed by
+// hit level. An access that hit at level i missed every level above it, so
+// misses are derived when the report is built.
+//
+// The distribution of total_cycles is kept in fixed-size log-linear
+// histograms per hit level and per operation type, so tail percentiles
+// need neither per-access history nor a post-pass over it.
+template <size_t Levels>
+class SimulationStats {
+ public:
+  using Histogram = LogLinearHistogram<>;
+
+ private:
+  std::array<size_t, Levels> hits_{};
+  std::array<size_t, Levels> total_latency_{};
+  size_t accesses_ = 0;
+  std::array<Histogram, Levels> level_latency_{};
+  std::array<Histogram, 2> type_latency_{};  // indexed by AccessType
+
+ public:
+  void Record(const TraceOp& op, const AccessResult& res) noexcept {
+    accesses_++;
+    hits_[res.hit_level]++;
+    total_latency_[res.hit_level] += res.total_cycles;
+    level_latency_[res.hit_level].Record(res.total_cycles);
+    type_latency_[op.type == 'L' ? 0 : 1].Record(res.total_cycles);
+  }
+
+  // Adds the counts of a run over a disjoint part of the same trace.
+  void Merge(const SimulationStats& other) noexcept {
+    accesses_ += other.accesses_;
+    for (size_t i = 0; i < Levels; ++i) {
+      hits_[i] += other.hits_[i];
+      total_latency_[i] += other.total_latency_[i];
+      level_latency_[i].Merge(other.level_latency_[i]);
     }
-    if (!hit_found) {
-      fmt::print(stderr, "Error: Hit level {} not in hierarchy def!\n",
-                 res.hit_level);
+    for (size_t t = 0; t < type_latency_.size(); ++t) {
+      type_latency_[t].Merge(other.type_latency_[t]);
     }
   }
 
-  fmt::print("\n=== Simulation Results (Aggregated) ===\n");
-  fmt::print("{:<15} {:>10} {:>10} {:>20}\n", "Level", "Hits", "Misses",
-             "Avg Latency (cyc)");
+  [[nodiscard]] size_t Accesses() const { return accesses_; }
 
-  for (const auto& level_name : hierarchy) {
-    const auto& s = stats_db[level_name];
-    double avg_lat = 0.0;
-    if (s.hits > 0) avg_lat = (double)s.total_latency / s.hits;
+  // Latency of the accesses served by `level`.
+  [[nodiscard]] const Histogram& LevelLatency(size_t level) const {
+    return level_latency_[level];
+  }
 
-    fmt::print("{:<15} {:>10} {:>10} {:>20.0f}\n", level_name, s.hits, s.misses,
-               avg_lat);
+  [[nodiscard]] const Histogram& TypeLatency(AccessType type) const {
+    return type_latency_[static_cast<size_t>(type)];
+  }
+
+  // Latency of every access.
+  [[nodiscard]] Histogram Latency() const {
+    Histogram all = type_latency_[0];
+    all.Merge(type_latency_[1]);
+    return all;
   }
-}
 
-inline void PrintAccessLog(const std::vector<AccessResult>& history,
-                           const std::vector<uint64_t>& trace_addrs) {
+  [[nodiscard]] CacheStats Level(size_t level) const {
+    CacheStats s;
+    s.hits = hits_[level];
+    s.total_latency = total_latency_[level];
+    for (size_t below = level + 1; below < Levels; ++below) {
+      s.misses += hits_[below];
+    }
+    return s;
+  }
+
+  void Print(const std::array<std::string_view, Levels>& names) const {
+    fmt::print("\n=== Simulation Results (Aggregated) ===\n");
+    fmt::print("{:<15} {:>10} {:>10} {:>20}\n", "Level", "Hits", "Misses",
+               "Avg Latency (cyc)");
+
+    for (size_t i = 0; i < Levels; ++i) {
+      const auto s = Level(i);
+      double avg_lat = 0.0;
+      if (s.hits > 0) avg_lat = (double)s.total_latency / s.hits;
+
+      fmt::print("{:<15} {:>10} {:>10} {:>20.0f}\n", names[i], s.hits,
+                 s.misses, avg_lat);
+    }
+  }
+
+  // Percentiles of total_cycles per operation type and per serving level.
+  void PrintLatencyDistribution(
+      const std::array<std::string_view, Levels>& names) const {
+    fmt::print("\n=== Latency Distribution (cycles) ===\n");
+    fmt::print("{:<15} {:>10} {:>8} {:>7} {:>7} {:>7} {:>7} {:>7}\n",
+               "Accesses", "Count", "Mean", "p50", "p90", "p99", "p99.9",
+               "Max");
+    auto row = [](std::string_view label, const Histogram& h) {
+      if (h.Count() == 0) return;
+      fmt::print("{:<15} {:>10} {:>8.1f} {:>7} {:>7} {:>7} {:>7} {:>7}\n",
+                 label, h.Count(), h.Mean(), h.Percentile(50),
+                 h.Percentile(90), h.Percentile(99), h.Percentile(99.9),
+                 h.Max());
+    };
+    row("All", Latency());
+    row("Loads", TypeLatency(AccessType::kLoad));
+    row("Stores", TypeLatency(AccessType::kStore));
+    for (size_t i = 0; i < Levels; ++i) {
+      row(fmt::format("{} hits", names[i]), level_latency_[i]);
+    }
+  }
+};
+
+template <size_t Levels>
+void PrintAccessLog(const std::vector<AccessResult>& history,
+                    const std::vector<uint64_t>& trace_addrs,
+                    const std::array<std::string_view, Levels>& names) {
   fmt::print("\n=== Detailed History ===\n");
   for (size_t i = 0; i < history.size(); ++i) {
     fmt::print("Access[{:>4}] Addr=0x{:08x} Hit={:<15} Cyc={:>6}\n", i,
-               trace_addrs[i], history[i].hit_level, history[i].total_cycles);
+               trace_addrs[i], names[history[i].hit_level],
+               history[i].total_cycles);
   }
 }
 
-enum class AccessType { kLoad, kStore };
+// How many operations ahead of the one being simulated AccessBatch and
+// LoadBatch prefetch simulator state. Far enough to cover a host DRAM miss
+// at a few tens of nanoseconds per access, small enough to stay in L1d.
+inline constexpr size_t kBatchPrefetchDistance = 16;
 
 // C++20 Fixed String for Non-Type Template Parameters
 template <size_t N>
@@ -89,169 +217,964 @@ class MainMemory {
   size_t latency_;
 
  public:
+  // Topology traits (see HierarchyInfo). MainMemory is always the last level.
+  static constexpr std::string_view kName{Name.value};
+  static constexpr size_t kLevels = 1;
+  static constexpr LevelInfo kInfo{kName, 0, 0, 0, 0, true};
+
+  // Stateless, so every shard of a sharded hierarchy is the same memory.
+  template <size_t Shards>
+  using Sharded = MainMemory;
+
   MainMemory(size_t lat = 100) : latency_(lat) {}
 
   AccessResult Load(uint64_t addr) {
-    return {Name.value, latency_};  // Always hits
+    return {0, latency_};  // Always hits
   }
 
-  AccessResult Store(uint64_t addr) { return {Name.value, latency_}; }
+  AccessResult Store(uint64_t addr) { return {0, latency_}; }
+
+  AccessResult Writeback(uint64_t addr) { return Store(addr); }
+
+  // Memory holds no simulated state; the hooks end the Cache chain.
+  static constexpr uint64_t Signature() {
+    return SignatureMix(kSignatureSeed, kName);
+  }
+  void Reset() {}
+  void SaveState(SnapshotWriter&) const {}
+  void LoadState(SnapshotReader&) {}
 };
 
+// Passed down the chain so every level below the top one carves its arrays
+// from the top level's Arena instead of allocating its own.
+struct ArenaSlot {
+  Arena* arena;
+};
+
+// Arena bytes the hierarchy rooted at `Level` needs (0 for levels that
+// manage their own storage, e.g. MainMemory or a test double).
+template <typename Level>
+constexpr size_t LevelArenaBytes() {
+  if constexpr (requires { Level::kArenaBytes; }) {
+    return Level::kArenaBytes;
+  } else {
+    return 0;
+  }
+}
+
+// Where a level sends back-invalidations: the level directly above it
+// (see InclusivePolicy). Set by that level when it is constructed.
+struct UpperLink {
+  void* level = nullptr;
+  ProbeResult (*back_invalidate)(void* level, uint64_t addr,
+                                 size_t bytes) = nullptr;
+};
+
+// Stands in for members of features a level does not use.
+struct Unused {};
+
 // Cache Template
 // Usage: Cache<"L1", NextLayer, ...>
 template <FixedString Name,
           typename NextLayer,  // potentially another Cache<...> or MainMemory
           size_t Sets, size_t Ways, size_t BlockSize,
           typename ReplacePolicy = LRUPolicy,
-          size_t HitLatency = 1  // Default hit latency
-          >
+          size_t HitLatency = 1,  // Default hit latency
+          typename HwPrefetcher = NoPrefetcher,  // see prefetchers.hpp
+          typename WritePolicy = WriteBackPolicy,  // see level_policies.hpp
+          typename InclusionPolicy = NonInclusivePolicy,
+          typename SetSampler = NoSetSampling>  // see set_sampling.hpp
 class Cache {
-  struct Line {
-    bool valid = false;
-    bool dirty = false;
-    uint64_t tag = 0;
-  };
+  using Mapping = AddressMapping<Sets, BlockSize>;
+  static_assert(Mapping::kPowerOfTwo || !kRequirePow2Geometry,
+                "Cache geometry must be a power of two "
+                "(STRATUM_REQUIRE_POW2_GEOMETRY is enabled)");
+  static_assert(Sets * BlockSize > 1, "kInvalidTag must not be a real tag");
+
+  using BoundReplacePolicy = BoundPolicy<ReplacePolicy, Ways>;
+  static constexpr bool kHasPrefetcher = HwPrefetcher::kEnabled;
+  static constexpr bool kWriteThrough = WritePolicy::kWriteThrough;
+  static constexpr bool kInclusive = InclusionPolicy::kInclusive;
+  static constexpr bool kExclusive = InclusionPolicy::kExclusive;
+  // The level below is a victim cache of this one (ExclusivePolicy).
+  static constexpr bool kNextExclusive =
+      requires { requires NextLayer::kExclusiveLevel; };
+  // Some level below is inclusive, so back-invalidations reach this one.
+  static constexpr bool kBelowNotifies =
+      requires { requires NextLayer::kNotifiesUpper; };
+  // Sets this level keeps state for: all of them, or the sampled ones.
+  static constexpr bool kSetSampled = SetSampler::kEnabled;
+  static constexpr size_t kStoredSets =
+      SetSampler::template SampledSets<Sets>();
 
-  std::unique_ptr<NextLayer> next_;  // OWNS the next layer
+  // Backing store for every array of this level and all levels below.
+  // Only the top level allocates it; lower levels leave it empty.
+  Arena owned_arena_;
 
-  // Cache State
-  // Flattened layout: [Set0_Way0, Set0_Way1... | Set1_Way0, Set1_Way1...]
-  std::vector<Line> sets_;
-  ReplacePolicy policy_;
+  // Cache State (structure of arrays, in the arena)
+  // Tags: [Set0_Way0, Set0_Way1... | Set1_Way0, Set1_Way1...], invalid ways
+  // hold kInvalidTag so one SIMD compare finds hits (see MatchTags).
+  // Dirty: one WayMask per set.
+  // Prefetched: one WayMask per set of lines a prefetch filled that no
+  // demand access has used yet (null without a prefetcher).
+  // A set-sampled level stores its sampled sets only, indexed by slot (see
+  // SetSlot), plus their access and miss counts (null otherwise).
+  uint64_t* tags_;
+  WayMask* dirty_;
+  WayMask* prefetched_;
+  SampledSetCounts* set_counts_;
+  BoundReplacePolicy policy_;
+  [[no_unique_address]] HwPrefetcher prefetcher_;
 
-  // Stats
-  size_t hits_ = 0;
-  size_t misses_ = 0;
-  size_t evictions_ = 0;
+  NextLayer next_;  // Stored inline: no pointer chase on the miss path
+
+  // Stats (compiled out with STRATUM_INSTRUMENTATION=0)
+  [[no_unique_address]] LevelCounters<> counters_;
+
+  // Inclusion state, only in levels that use it: the link up for
+  // back-invalidations, and (exclusive levels) whether the line the last
+  // Load moved up was dirty.
+  [[no_unique_address]] std::conditional_t<kInclusive || kBelowNotifies,
+                                           UpperLink, Unused>
+      upper_{};
+  [[no_unique_address]] std::conditional_t<kExclusive, bool, Unused>
+      moved_dirty_{};
 
  public:
-  // Variadic Constructor: Recursively creates the next layer
+  // Topology traits (see HierarchyInfo).
+  using Next = NextLayer;
+  using Policy = ReplacePolicy;
+  using Prefetcher = HwPrefetcher;
+  using Write = WritePolicy;
+  using Inclusion = InclusionPolicy;
+  using Sampler = SetSampler;
+  static constexpr bool kExclusiveLevel = kExclusive;
+  static constexpr bool kNotifiesUpper = kInclusive || kBelowNotifies;
+  static constexpr std::string_view kName{Name.value};
+  static constexpr size_t kSets = Sets;
+  static constexpr size_t kWays = Ways;
+  static constexpr size_t kBlockSize = BlockSize;
+  static constexpr size_t kHitLatency = HitLatency;
+  static constexpr bool kPowerOfTwoGeometry = Mapping::kPowerOfTwo;
+  // Number of levels from here down, including MainMemory.
+  static constexpr size_t kLevels = NextLayer::kLevels + 1;
+  static constexpr LevelInfo kInfo{kName, Sets, Ways, BlockSize, HitLatency,
+                                   false};
+  // Size of the single Arena the top level allocates for the whole chain.
+  static constexpr size_t kArenaBytes =
+      ArenaBytes<uint64_t>(kStoredSets * Ways) +
+      ArenaBytes<WayMask>(kStoredSets) +
+      ArenaBytes<WayMask>(kHasPrefetcher ? kStoredSets : 0) +
+      ArenaBytes<SampledSetCounts>(kSetSampled ? kStoredSets : 0) +
+      PolicyArenaBytes<BoundReplacePolicy>(kStoredSets, Ways) +
+      LevelArenaBytes<NextLayer>();
+
+  // This chain with every level holding Sets / Shards sets: the hierarchy
+  // one worker of a set-sharded simulation owns (see sharded.hpp). Resolved
+  // lazily, so only sharded hierarchies need NextLayer::Sharded.
+  template <size_t Shards>
+  struct ShardedChain {
+    static_assert(Shards == 1 || !kSetSampled,
+                  "Set-sampled levels cannot be set-sharded");
+    using type =
+        Cache<Name, typename NextLayer::template Sharded<Shards>,
+              Sets / Shards, Ways, BlockSize, ReplacePolicy, HitLatency,
+              HwPrefetcher, WritePolicy, InclusionPolicy>;
+  };
+  template <size_t Shards>
+  using Sharded = typename ShardedChain<Shards>::type;
+
+  // This level with the same geometry and policy on top of `Below`, e.g.
+  // the filter stage of prefilter.hpp, which puts a recorder under an L1.
+  template <typename Below>
+  using Rebind =
+      Cache<Name, Below, Sets, Ways, BlockSize, ReplacePolicy, HitLatency,
+            HwPrefetcher, WritePolicy, InclusionPolicy, SetSampler>;
+
+  // Variadic Constructor: Recursively creates the next layer in place.
+  // The top level allocates one Arena of kArenaBytes for every level.
   template <typename... Args>
+    requires(!(std::is_same_v<std::remove_cvref_t<Args>, ArenaSlot> || ...))
   Cache(Args&&... args)
-      : next_(std::make_unique<NextLayer>(std::forward<Args>(args)...)),
-        sets_(Sets * Ways),  // Pre-allocate all cache lines
-        policy_(Sets, Ways) {}
+      : Cache(ArenaSlot{nullptr}, std::forward<Args>(args)...) {}
+
+  // Builds this level inside `slot.arena`, or inside its own arena if null.
+  template <typename... Args>
+  explicit Cache(ArenaSlot slot, Args&&... args)
+      : owned_arena_(slot.arena != nullptr ? 0 : kArenaBytes),
+        tags_(NewArray<uint64_t>(Storage(slot), kStoredSets * Ways,
+                                 kInvalidTag)),
+        dirty_(NewArray<WayMask>(Storage(slot), kStoredSets, 0)),
+        prefetched_(kHasPrefetcher
+                        ? NewArray<WayMask>(Storage(slot), kStoredSets, 0)
+                        : nullptr),
+        set_counts_(kSetSampled ? NewArray<SampledSetCounts>(
+                                      Storage(slot), kStoredSets, {})
+                                : nullptr),
+        policy_(MakePolicy(Storage(slot))),
+        next_(MakeNext(Storage(slot), std::forward<Args>(args)...)) {
+    if constexpr (kBelowNotifies) {
+      next_.AttachUpper({this, [](void* self, uint64_t addr, size_t bytes) {
+                           return static_cast<Cache*>(self)->BackInvalidate(
+                               addr, bytes);
+                         }});
+    }
+  }
+
+  Cache(const Cache&) = delete;
+  Cache& operator=(const Cache&) = delete;
 
   AccessResult Load(uint64_t addr) {
-    // -------------------------------------------------------
-    // |       Tag       |    Set Index    |  Block Offset   |
-    // -------------------------------------------------------
-    uint64_t set_idx = (addr / BlockSize) % Sets;
-    uint64_t tag = addr / (BlockSize * Sets);
-
-    // 1. Tag Lookup
-    size_t base_idx = set_idx * Ways;
-    for (size_t way_idx = 0; way_idx < Ways; ++way_idx) {
-      size_t flat_idx = base_idx + way_idx;
-      if (sets_[flat_idx].valid && sets_[flat_idx].tag == tag) {
-        // HIT
-        StatsHit();
-        policy_.OnHit(set_idx, way_idx);
-        return {Name.value, HitLatency};
-      }
+    // Shift/mask for power-of-two geometries (see AddressMapping)
+    uint64_t set_idx = SetSlot(addr);
+    if (Skipped(set_idx)) return SkipLoad(addr);
+    uint64_t tag = Mapping::Tag(addr);
+
+    // 1. Tag Lookup (also collects free ways for the miss path)
+    TagLookup lookup = LookupTags<Ways>(&tags_[set_idx * Ways], tag);
+    if (lookup.hit != 0) {
+      // HIT
+      StatsHit(set_idx);
+      policy_.OnHit(set_idx, FirstWay(lookup.hit));
+      TrainPrefetcher(addr, set_idx, lookup.hit);
+      if constexpr (kExclusive) moved_dirty_ = Probe(addr, true).dirty;
+      counters_.Latency(HitLatency);
+      return {0, HitLatency};
     }
 
     // 2. MISS - Fetch from next level
-    StatsMiss();
-    AccessResult res = next_->Load(addr);
+    StatsMiss(set_idx);
+    AccessResult res = next_.Load(addr);
 
-    // 3. Accumulate Latency
+    // 3. Accumulate Latency; the hit level is one further down from here
+    res.hit_level++;
     res.total_cycles += HitLatency;
 
-    // 4. Update Cache (fill)
-    Fill(set_idx, tag);
+    // 4. Update Cache (fill); a victim cache passes the block straight up
+    if constexpr (kExclusive) {
+      moved_dirty_ = TakeNextMovedDirty();
+    } else {
+      Fill(set_idx, tag, FreeWays(set_idx, lookup.free), FetchedDirty(addr));
+    }
+    TrainPrefetcher(addr, set_idx, 0);
 
+    counters_.Latency(res.total_cycles);
     return res;
   }
 
   AccessResult Store(uint64_t addr) {
-    uint64_t set_idx = (addr / BlockSize) % Sets;
-    uint64_t tag = addr / (BlockSize * Sets);
-
-    // 1. Tag Lookup
-    size_t base_idx = set_idx * Ways;
-    for (size_t way_idx = 0; way_idx < Ways; ++way_idx) {
-      size_t flat_idx = base_idx + way_idx;
-      if (sets_[flat_idx].valid && sets_[flat_idx].tag == tag) {
-        // HIT
-        StatsHit();
-        sets_[flat_idx].dirty = true;
-        policy_.OnHit(set_idx, way_idx);
-        return {Name.value, HitLatency};
+    uint64_t set_idx = SetSlot(addr);
+    if (Skipped(set_idx)) return PassDown(next_.Store(addr));
+    uint64_t tag = Mapping::Tag(addr);
+
+    // 1. Tag Lookup (also collects free ways for the miss path)
+    TagLookup lookup = LookupTags<Ways>(&tags_[set_idx * Ways], tag);
+    if (lookup.hit != 0) {
+      // HIT
+      StatsHit(set_idx);
+      if constexpr (kWriteThrough) {
+        PostStore(addr);
+      } else {
+        dirty_[set_idx] |= lookup.hit;
       }
+      policy_.OnHit(set_idx, FirstWay(lookup.hit));
+      TrainPrefetcher(addr, set_idx, lookup.hit);
+      counters_.Latency(HitLatency);
+      return {0, HitLatency};
+    }
+
+    StatsMiss(set_idx);
+    if constexpr (!WritePolicy::kWriteAllocate || kExclusive) {
+      // 2. Write Miss -> No Write Allocate: the store goes down instead
+      AccessResult res = PassDown(next_.Store(addr));
+      TrainPrefetcher(addr, set_idx, 0);
+      counters_.Latency(res.total_cycles);
+      return res;
     }
 
     // 2. Write Miss -> Write Allocate
-    StatsMiss();
-    AccessResult res = next_->Load(addr);
+    AccessResult res = next_.Load(addr);
+    res.hit_level++;
     res.total_cycles += HitLatency;
 
-    // 3. Fill and mark dirty
-    Fill(set_idx, tag);
+    // 3. Fill, born dirty (or written through)
+    FetchedDirty(addr);
+    Fill(set_idx, tag, FreeWays(set_idx, lookup.free), !kWriteThrough);
+    if constexpr (kWriteThrough) PostStore(addr);
+    TrainPrefetcher(addr, set_idx, 0);
+
+    counters_.Latency(res.total_cycles);
+    return res;
+  }
 
-    // Mark the newly filled line as dirty
-    for (size_t way_idx = 0; way_idx < Ways; ++way_idx) {
-      size_t flat_idx = base_idx + way_idx;
-      if (sets_[flat_idx].valid && sets_[flat_idx].tag == tag) {
-        sets_[flat_idx].dirty = true;
-        break;
+  // A dirty line written back by the level above: a Store that is also
+  // counted as a received writeback. A victim cache inserts it instead.
+  AccessResult Writeback(uint64_t addr) {
+    if constexpr (kExclusive) {
+      InsertVictim(addr, true);
+      return {0, HitLatency};
+    } else {
+      if (Skipped(SetSlot(addr))) {
+        WriteBackDown(addr);
+        return {0, HitLatency};
       }
+      counters_.Writeback();
+      return Store(addr);
     }
+  }
+
+  // Brings the block of `addr` into this level, and into every level below
+  // that misses on it, for a prefetch issued here or above. It is not a
+  // demand access: no hit, miss or latency is counted and no prefetcher
+  // is trained. A dirty victim is still written back. Untimed.
+  void PrefetchFill(uint64_t addr) { FillWithoutDemand(addr, false); }
+
+  // --- Coherence probes (see coherence.hpp) -----------------------------
+  //
+  // A directory calls these on a private stack; they walk this level and
+  // every level below that has them. Neither is an access: nothing is
+  // counted except prefetched lines dropped unused, and no writeback is
+  // sent down, since the caller takes over any dirty data.
+  //
+  // Invalidate drops the block of `addr`; Clean keeps it but clears its
+  // dirty bit (a downgrade to shared).
+  ProbeResult Invalidate(uint64_t addr) {
+    ProbeResult res = Probe(addr, /*drop=*/true);
+    if constexpr (requires { next_.Invalidate(addr); }) {
+      res |= next_.Invalidate(addr);
+    }
+    return res;
+  }
 
+  ProbeResult Clean(uint64_t addr) {
+    ProbeResult res = Probe(addr, /*drop=*/false);
+    if constexpr (requires { next_.Clean(addr); }) {
+      res |= next_.Clean(addr);
+    }
     return res;
   }
 
+  // --- Inclusion (see level_policies.hpp) --------------------------------
+  //
+  // Exclusive levels: takes a line the level above evicted, clean or
+  // dirty. Not a demand access; dirty ones count as received writebacks.
+  void InsertVictim(uint64_t addr, bool dirty)
+    requires(kExclusive)
+  {
+    const uint64_t set_idx = SetSlot(addr);
+    if (Skipped(set_idx)) {
+      if (dirty) WriteBackDown(addr);
+      return;
+    }
+    if (dirty) counters_.Writeback();
+    if constexpr (kWriteThrough) {
+      if (dirty) PostStore(addr);
+      dirty = false;
+    }
+    const uint64_t tag = Mapping::Tag(addr);
+    const TagLookup lookup = LookupTags<Ways>(&tags_[set_idx * Ways], tag);
+    if (lookup.hit != 0) {
+      if (dirty) dirty_[set_idx] |= lookup.hit;
+      policy_.OnHit(set_idx, FirstWay(lookup.hit));
+      return;
+    }
+    Fill(set_idx, tag, lookup.free, dirty);
+  }
+
+  // Exclusive levels: whether the line the last Load moved up was dirty
+  // (the level above takes over the data). Clears the flag.
+  bool TakeMovedDirty()
+    requires(kExclusive)
+  {
+    return std::exchange(moved_dirty_, false);
+  }
+
+  // Called by the level above when it is constructed on top of this one.
+  void AttachUpper(UpperLink upper)
+    requires(kNotifiesUpper)
+  {
+    upper_ = upper;
+  }
+
+  // Batched entry points: process ops strictly in order, writing
+  // results[i] for ops[i] (results.size() >= ops.size()). Before simulating
+  // op i they prefetch the state op i + kBatchPrefetchDistance will touch,
+  // so host cache misses on large tag and policy arrays overlap instead of
+  // stalling one access at a time. Results are identical to calling
+  // Load/Store in a loop.
+  void AccessBatch(std::span<const TraceOp> ops,
+                   std::span<AccessResult> results) {
+    RunBatch(ops.size(), [&](size_t i) { return ops[i].addr; },
+             [&](size_t i) {
+               results[i] = ops[i].type == 'L' ? Load(ops[i].addr)
+                                               : Store(ops[i].addr);
+             });
+  }
+
+  void LoadBatch(std::span<const uint64_t> addrs,
+                 std::span<AccessResult> results) {
+    RunBatch(addrs.size(), [&](size_t i) { return addrs[i]; },
+             [&](size_t i) { results[i] = Load(addrs[i]); });
+  }
+
+  // Host-prefetches what an access to `addr` reads at this level and,
+  // along the miss path, every level below: the set's tags, its dirty mask
+  // and the policy's per-set state.
+  STRATUM_ALWAYS_INLINE void Prefetch(uint64_t addr) const noexcept {
+    const uint64_t set_idx = SetSlot(addr);
+    if (!Skipped(set_idx)) {
+      PrefetchRange(&tags_[set_idx * Ways], Ways * sizeof(uint64_t));
+      PrefetchRange(&dirty_[set_idx], sizeof(WayMask));
+      if constexpr (requires { policy_.Prefetch(set_idx); }) {
+        policy_.Prefetch(set_idx);
+      }
+    }
+    if constexpr (requires { next_.Prefetch(addr); }) {
+      next_.Prefetch(addr);
+    }
+  }
+
+  // --- Instrumentation --------------------------------------------------
+  //
+  // Per-level counters (see LevelCounters); all zero when built with
+  // STRATUM_INSTRUMENTATION=0.
+  [[nodiscard]] LevelStats Stats() const { return counters_.Stats(kName); }
+
+  // Set-sampled levels: whole-cache estimates from the sampled sets (see
+  // set_sampling.hpp). Kept with STRATUM_INSTRUMENTATION=0 as well; Stats()
+  // counts the sampled sets only, and SetSampledStats::scale scales it up.
+  [[nodiscard]] SetSampledStats SampledStats() const
+    requires(kSetSampled)
+  {
+    return EstimateSetSample(kName, {set_counts_, kStoredSets}, Sets);
+  }
+
+  // Calls fn(level) for this level and every Cache level below it, top to
+  // bottom. Levels without ForEachLevel (MainMemory, custom layers) end
+  // the walk.
+  template <typename Fn>
+  void ForEachLevel(Fn&& fn) const {
+    fn(*this);
+    if constexpr (requires { next_.ForEachLevel(fn); }) {
+      next_.ForEachLevel(fn);
+    }
+  }
+
   // Helper to print stats
   void PrintStats() const {
-    fmt::print("Cache {}: Hits={}, Misses={}, Evictions={}\n", Name.value,
-               hits_, misses_, evictions_);
+    const LevelStats s = Stats();
+    fmt::print(
+        "Cache {}: Hits={}, Misses={}, Evictions={}, Writebacks={}, "
+        "AvgLatency={:.2f}\n",
+        Name.value, s.hits, s.misses, s.evictions, s.writebacks,
+        s.latency.Mean());
+    if constexpr (kHasPrefetcher) {
+      fmt::print(
+          "  Prefetcher {}: Prefetches={}, Useful={}, Unused={}, "
+          "Accuracy={:.1f}%, Coverage={:.1f}%\n",
+          HwPrefetcher::kName, s.prefetches, s.prefetch_hits,
+          s.prefetch_unused, s.PrefetchAccuracy() * 100.0,
+          s.PrefetchCoverage() * 100.0);
+    }
+    if constexpr (kInclusive) {
+      fmt::print("  Inclusive: BackInvalidations={}\n",
+                 s.back_invalidations);
+    }
+    if constexpr (kSetSampled) {
+      fmt::print("  Sampled {}: Sets={} of {} (counts above are theirs)\n",
+                 SetSampler::kName, kStoredSets, Sets);
+    }
   }
 
   void PrintAllStats() const {
-    PrintStats();
-    // next_->PrintAllStats(); // Requires generic interface or SFINAE
+    ForEachLevel([](const auto& level) { level.PrintStats(); });
   }
 
-  NextLayer* GetNext() const { return next_.get(); }
+  NextLayer* GetNext() { return &next_; }
+  const NextLayer* GetNext() const { return &next_; }
 
- private:
-  void Fill(size_t set_idx, uint64_t tag) {
-    size_t victim_way_idx = Ways;
-    size_t base_idx = set_idx * Ways;
-
-    // Find invalid line first
-    for (size_t way_idx = 0; way_idx < Ways; ++way_idx) {
-      if (!sets_[base_idx + way_idx].valid) {
-        victim_way_idx = way_idx;
-        break;
-      }
+  // --- Reset and snapshot/restore ---------------------------------------
+  //
+  // Reset() returns this level and every level below to the state of a
+  // freshly constructed hierarchy (all lines invalid, policy state and
+  // counters cleared) without freeing or re-faulting the arena, so a
+  // simulator object can be reused across traces or configurations.
+  //
+  // Snapshot() captures the full state of the chain; Restore() puts it back.
+  // Warm a hierarchy once, snapshot it, then restore before each experiment
+  // instead of replaying the warmup trace again. Snapshots can be written
+  // to disk with SaveSnapshot/LoadSnapshot (snapshot.hpp).
+  //
+  // Every level below must provide Reset/SaveState/LoadState (Cache and
+  // MainMemory do); they are only instantiated when used.
+
+  void Reset() {
+    std::fill_n(tags_, kStoredSets * Ways, kInvalidTag);
+    std::fill_n(dirty_, kStoredSets, WayMask{0});
+    if constexpr (kHasPrefetcher) {
+      std::fill_n(prefetched_, kStoredSets, WayMask{0});
+    }
+    if constexpr (kSetSampled) {
+      std::fill_n(set_counts_, kStoredSets, SampledSetCounts{});
+    }
+    policy_.Reset();
+    prefetcher_.Reset();
+    counters_.Reset();
+    if constexpr (kExclusive) moved_dirty_ = false;
+    next_.Reset();
+  }
+
+  // Identifies the configuration of the chain rooted here, so a snapshot
+  // is never restored into a different hierarchy type.
+  static constexpr uint64_t Signature() {
+    uint64_t h = SignatureMix(NextLayer::Signature(), kName);
+    h = SignatureMix(h, Sets);
+    h = SignatureMix(h, Ways);
+    h = SignatureMix(h, BlockSize);
+    h = SignatureMix(h, HitLatency);
+    h = SignatureMix(h, uint64_t{kInstrumentation});
+    h = SignatureMix(h, ReplacePolicy::kName);
+    h = SignatureMix(h, HwPrefetcher::kName);
+    h = SignatureMix(h, WritePolicy::kName);
+    h = SignatureMix(h, InclusionPolicy::kName);
+    h = SignatureMix(h, SetSampler::kName);
+    h = SignatureMix(h, SetSampler::kRatio);
+    h = SignatureMix(h, SetSampler::kOffset);
+    return SignatureMix(
+        h, PolicyArenaBytes<BoundReplacePolicy>(kStoredSets, Ways));
+  }
+
+  void SaveState(SnapshotWriter& out) const {
+    out.Array(tags_, kStoredSets * Ways);
+    out.Array(dirty_, kStoredSets);
+    if constexpr (kHasPrefetcher) out.Array(prefetched_, kStoredSets);
+    if constexpr (kSetSampled) out.Array(set_counts_, kStoredSets);
+    policy_.SaveState(out);
+    prefetcher_.SaveState(out);
+    counters_.SaveState(out);
+    next_.SaveState(out);
+  }
+
+  void LoadState(SnapshotReader& in) {
+    in.Array(tags_, kStoredSets * Ways);
+    in.Array(dirty_, kStoredSets);
+    if constexpr (kHasPrefetcher) in.Array(prefetched_, kStoredSets);
+    if constexpr (kSetSampled) in.Array(set_counts_, kStoredSets);
+    policy_.LoadState(in);
+    prefetcher_.LoadState(in);
+    counters_.LoadState(in);
+    next_.LoadState(in);
+  }
+
+  [[nodiscard]] CacheSnapshot Snapshot() const {
+    CacheSnapshot snapshot{Signature(), {}};
+    snapshot.payload.reserve(kArenaBytes);
+    SnapshotWriter out(snapshot.payload);
+    SaveState(out);
+    return snapshot;
+  }
+
+  // Returns false (leaving the hierarchy Reset) if `snapshot` was taken
+  // from a different configuration or is truncated.
+  bool Restore(const CacheSnapshot& snapshot) {
+    if (snapshot.signature != Signature()) {
+      fmt::print(stderr, "Error: Snapshot does not match hierarchy {}\n",
+                 kName);
+      Reset();
+      return false;
     }
+    SnapshotReader in(snapshot.payload);
+    LoadState(in);
+    if (!in.Ok() || !in.AtEnd()) {
+      fmt::print(stderr, "Error: Corrupt snapshot for hierarchy {}\n", kName);
+      Reset();
+      return false;
+    }
+    return true;
+  }
 
-    // If no invalid line, evict using replacement policy
-    if (victim_way_idx == Ways) {
+ private:
+  // Installs `tag` into a free way (from the lookup mask) or the policy's
+  // victim, writing back a dirty victim first. Returns the filled way.
+  size_t Fill(size_t set_idx, uint64_t tag, WayMask free, bool dirty,
+              bool prefetched = false) {
+    uint64_t* set_tags = &tags_[set_idx * Ways];
+    size_t victim_way_idx;
+
+    if (free != 0) {
+      victim_way_idx = FirstWay(free);
+    } else {
+      // If no invalid line, evict using replacement policy
       victim_way_idx = policy_.GetVictim(set_idx);
-      size_t victim_flat_idx = base_idx + victim_way_idx;
-      Line& victim = sets_[victim_flat_idx];
-      if (victim.valid && victim.dirty) {
-        uint64_t evict_addr = (victim.tag * Sets + set_idx) * BlockSize;
-        next_->Store(evict_addr);
-        evictions_++;
-      }
+      Evict(set_idx, victim_way_idx);
     }
 
     // Fill the line
-    size_t fill_idx = base_idx + victim_way_idx;
-    sets_[fill_idx].valid = true;
-    sets_[fill_idx].tag = tag;
-    sets_[fill_idx].dirty = false;
+    const WayMask bit = WayMask{1} << victim_way_idx;
+    set_tags[victim_way_idx] = tag;
+    dirty_[set_idx] = (dirty_[set_idx] & ~bit) | (dirty ? bit : 0);
+    if constexpr (kHasPrefetcher) {
+      if (prefetched_[set_idx] & bit) counters_.PrefetchUnused();
+      prefetched_[set_idx] =
+          (prefetched_[set_idx] & ~bit) | (prefetched ? bit : 0);
+    }
     policy_.OnFill(set_idx, victim_way_idx);
+    return victim_way_idx;
+  }
+
+  // Sends the valid line in `way` out before it is replaced: to the level
+  // below if dirty (a victim cache below takes clean ones too), after
+  // taking it back from the levels above if this level is inclusive.
+  void Evict(size_t set_idx, size_t way) {
+    const uint64_t victim_tag = tags_[set_idx * Ways + way];
+    bool dirty = (dirty_[set_idx] & (WayMask{1} << way)) != 0;
+    if constexpr (kInclusive || kNextExclusive) {
+      if (victim_tag == kInvalidTag) return;
+    } else {
+      if (!dirty) return;
+    }
+    const uint64_t evict_addr = Mapping::BlockAddress(
+        victim_tag, SetSampler::template SetOf<Sets>(set_idx));
+    if constexpr (kInclusive) {
+      const ProbeResult above = NotifyUpper(evict_addr, BlockSize);
+      if (above.present) counters_.BackInvalidation();
+      dirty |= above.dirty;
+    }
+    if constexpr (kNextExclusive) {
+      next_.InsertVictim(evict_addr, dirty);
+    } else if (dirty) {
+      WriteBackDown(evict_addr);
+    }
+    if (dirty) counters_.Eviction();
+  }
+
+  // Sends dirty data for the block of `addr` to the level below.
+  void WriteBackDown(uint64_t addr) {
+    if constexpr (requires { next_.Writeback(addr); }) {
+      next_.Writeback(addr);
+    } else {
+      next_.Store(addr);
+    }
+  }
+
+  // The set of `addr`'s slot in this level's arrays: its set index, or for
+  // a set-sampled level its compact index (kUnsampledSet if not sampled).
+  static uint64_t SetSlot(uint64_t addr) noexcept {
+    return SetSampler::template Slot<Sets>(Mapping::SetIndex(addr));
+  }
+
+  // Whether an access to `slot` skips this level (always false without
+  // set sampling, so the check compiles out).
+  static bool Skipped(uint64_t slot) noexcept {
+    return kSetSampled && slot == kUnsampledSet;
+  }
+
+  // A demand access that missed here, or skipped it, and was served below.
+  static AccessResult PassDown(AccessResult res) noexcept {
+    res.hit_level++;
+    res.total_cycles += HitLatency;
+    return res;
+  }
+
+  // Load of a set the sampler skips: served below without tag work. A
+  // dirty line a victim cache below moves up is taken over by an exclusive
+  // level's caller, and otherwise handed back.
+  AccessResult SkipLoad(uint64_t addr) {
+    const AccessResult res = PassDown(next_.Load(addr));
+    if constexpr (kExclusive) {
+      moved_dirty_ = TakeNextMovedDirty();
+    } else if constexpr (kNextExclusive) {
+      if (TakeNextMovedDirty()) next_.InsertVictim(addr, true);
+    }
+    return res;
+  }
+
+  // Free ways of a set for a fill after fetching from below. A
+  // back-invalidation during the fetch may have freed more than the lookup
+  // saw.
+  WayMask FreeWays(size_t set_idx, WayMask free) const {
+    if constexpr (kBelowNotifies) {
+      return MatchTags<Ways>(&tags_[set_idx * Ways], kInvalidTag);
+    } else {
+      return free;
+    }
+  }
+
+  bool TakeNextMovedDirty() {
+    if constexpr (kNextExclusive) {
+      return next_.TakeMovedDirty();
+    } else {
+      return false;
+    }
+  }
+
+  // Dirty state of a block just fetched: a victim cache below hands dirty
+  // lines up. A write-through level writes such data on instead.
+  bool FetchedDirty(uint64_t addr) {
+    const bool dirty = TakeNextMovedDirty();
+    if constexpr (kWriteThrough) {
+      if (dirty) PostStore(addr);
+      return false;
+    } else {
+      return dirty;
+    }
+  }
+
+  // Write-through: sends a store on to the next level. Posted, so its
+  // latency is not charged to the access.
+  void PostStore(uint64_t addr) { next_.Store(addr); }
+
+  ProbeResult NotifyUpper(uint64_t addr, size_t bytes) {
+    if constexpr (kNotifiesUpper) {
+      if (upper_.level != nullptr) {
+        return upper_.back_invalidate(upper_.level, addr, bytes);
+      }
+    }
+    return {};
+  }
+
+  // Drops the `bytes`-byte block at `addr`, evicted by an inclusive level
+  // below, from this level and the levels above it.
+  ProbeResult BackInvalidate(uint64_t addr, size_t bytes) {
+    const uint64_t base = addr - addr % bytes;
+    ProbeResult res;
+    for (uint64_t a = base; a < base + bytes; a += BlockSize) {
+      res |= Probe(a, /*drop=*/true);
+    }
+    res |= NotifyUpper(base, bytes);
+    return res;
+  }
+
+  // Lets the prefetcher observe a demand access to `addr` that hit the ways
+  // in `hit` (0 on a miss, after the fill), and issues its prefetches.
+  void TrainPrefetcher(uint64_t addr, size_t set_idx, WayMask hit) {
+    if constexpr (kHasPrefetcher) {
+      const bool first_use = (prefetched_[set_idx] & hit) != 0;
+      if (first_use) {
+        prefetched_[set_idx] &= ~hit;
+        counters_.PrefetchHit();
+      }
+      prefetcher_.OnAccess(addr / BlockSize, hit != 0, first_use,
+                           [this](uint64_t block) {
+                             if (FillWithoutDemand(block * BlockSize, true)) {
+                               counters_.Prefetch();
+                             }
+                           });
+    }
+  }
+
+  // Prefetch fill path (see PrefetchFill); `own` marks the line as brought
+  // in by this level's prefetcher. Returns false if the block was present.
+  bool FillWithoutDemand(uint64_t addr, bool own) {
+    const uint64_t set_idx = SetSlot(addr);
+    if (Skipped(set_idx)) {
+      if constexpr (requires { next_.PrefetchFill(addr); }) {
+        next_.PrefetchFill(addr);
+      }
+      return false;
+    }
+    const uint64_t tag = Mapping::Tag(addr);
+    const TagLookup lookup = LookupTags<Ways>(&tags_[set_idx * Ways], tag);
+    if (lookup.hit != 0) return false;
+    if constexpr (requires { next_.PrefetchFill(addr); }) {
+      next_.PrefetchFill(addr);
+    }
+    // A victim cache does not keep blocks prefetched into the levels above.
+    if constexpr (kExclusive) {
+      if (!own) return true;
+    }
+    Fill(set_idx, tag, FreeWays(set_idx, lookup.free), /*dirty=*/false, own);
+    return true;
+  }
+
+  ProbeResult Probe(uint64_t addr, bool drop) {
+    const uint64_t set_idx = SetSlot(addr);
+    if (Skipped(set_idx)) return {};
+    const WayMask hit =
+        MatchTags<Ways>(&tags_[set_idx * Ways], Mapping::Tag(addr));
+    if (hit == 0) return {};
+    const ProbeResult res{true, (dirty_[set_idx] & hit) != 0};
+    dirty_[set_idx] &= ~hit;
+    if (drop) {
+      tags_[set_idx * Ways + FirstWay(hit)] = kInvalidTag;
+      if constexpr (kHasPrefetcher) {
+        if (prefetched_[set_idx] & hit) counters_.PrefetchUnused();
+        prefetched_[set_idx] &= ~hit;
+      }
+    }
+    return res;
+  }
+
+  Arena& Storage(ArenaSlot slot) {
+    return slot.arena != nullptr ? *slot.arena : owned_arena_;
+  }
+
+  template <typename T>
+  static T* NewArray(Arena& arena, size_t count, T value) {
+    T* data = arena.template Allocate<T>(count);
+    std::fill_n(data, count, value);
+    return data;
+  }
+
+  static BoundReplacePolicy MakePolicy(Arena& arena) {
+    if constexpr (std::is_constructible_v<BoundReplacePolicy, size_t, size_t,
+                                          Arena*>) {
+      return BoundReplacePolicy(kStoredSets, Ways, &arena);
+    } else {
+      return BoundReplacePolicy(kStoredSets, Ways);
+    }
+  }
+
+  // Arena-aware levels below share this arena; anything else (MainMemory,
+  // custom layers) is constructed from the forwarded arguments alone.
+  template <typename... Args>
+  static NextLayer MakeNext(Arena& arena, Args&&... args) {
+    if constexpr (std::is_constructible_v<NextLayer, ArenaSlot, Args...>) {
+      return NextLayer(ArenaSlot{&arena}, std::forward<Args>(args)...);
+    } else {
+      return NextLayer(std::forward<Args>(args)...);
+    }
+  }
+
+  template <typename AddrOf, typename Access>
+  void RunBatch(size_t n, AddrOf addr_of, Access access) {
+    const size_t warmup = std::min(n, kBatchPrefetchDistance);
+    for (size_t i = 0; i < warmup; ++i) Prefetch(addr_of(i));
+    for (size_t i = 0; i < n; ++i) {
+      if (i + kBatchPrefetchDistance < n) {
+        Prefetch(addr_of(i + kBatchPrefetchDistance));
+      }
+      access(i);
+    }
   }
 
-  void StatsHit() { hits_++; }
-  void StatsMiss() { misses_++; }
+  void StatsHit(size_t set_idx) {
+    counters_.Hit();
+    if constexpr (kSetSampled) ++set_counts_[set_idx].accesses;
+  }
+  void StatsMiss(size_t set_idx) {
+    counters_.Miss();
+    if constexpr (kSetSampled) {
+      ++set_counts_[set_idx].accesses;
+      ++set_counts_[set_idx].misses;
+    }
+    // Optional policy hook (e.g. DRRIP set dueling)
+    if constexpr (requires { policy_.OnMiss(set_idx); }) {
+      policy_.OnMiss(set_idx);
+    }
+  }
 };
 
+// Topology of the hierarchy rooted at `Level`, top to bottom.
+//
+// Example:
+//   constexpr auto info = HierarchyInfo<L1Type>();
+//   static_assert(info[1].name == "L2");
+template <typename Level>
+constexpr std::array<LevelInfo, Level::kLevels> HierarchyInfo() {
+  std::array<LevelInfo, Level::kLevels> info{};
+  info[0] = Level::kInfo;
+  if constexpr (Level::kLevels > 1) {
+    constexpr auto rest = HierarchyInfo<typename Level::Next>();
+    for (size_t i = 0; i < rest.size(); ++i) info[i + 1] = rest[i];
+  }
+  return info;
+}
+
+// Level names of the hierarchy rooted at `Level`, top to bottom.
+template <typename Level>
+constexpr std::array<std::string_view, Level::kLevels> HierarchyNames() {
+  constexpr auto info = HierarchyInfo<Level>();
+  std::array<std::string_view, Level::kLevels> names{};
+  for (size_t i = 0; i < info.size(); ++i) names[i] = info[i].name;
+  return names;
+}
+
+// True when every replacement policy in the hierarchy rooted at `Level` is
+// set-local (see IsSetLocalPolicy) and no level has a prefetcher.
+template <typename Level>
+constexpr bool HierarchyIsSetLocal() {
+  if constexpr (requires { typename Level::Policy; }) {
+    return IsSetLocalPolicy<
+               BoundPolicy<typename Level::Policy, Level::kWays>>() &&
+           IsSetLocalPolicy<typename Level::Prefetcher>() &&
+           HierarchyIsSetLocal<typename Level::Next>();
+  } else {
+    return true;
+  }
+}
+
+// True when some level of the hierarchy rooted at `Level` has a prefetcher.
+template <typename Level>
+constexpr bool HierarchyHasPrefetcher() {
+  if constexpr (requires { typename Level::Prefetcher; }) {
+    return Level::Prefetcher::kEnabled ||
+           HierarchyHasPrefetcher<typename Level::Next>();
+  } else {
+    return false;
+  }
+}
+
+// True when some level of the hierarchy rooted at `Level` is set-sampled.
+template <typename Level>
+constexpr bool HierarchyHasSetSampling() {
+  if constexpr (requires { typename Level::Sampler; }) {
+    return Level::Sampler::kEnabled ||
+           HierarchyHasSetSampling<typename Level::Next>();
+  } else {
+    return false;
+  }
+}
+
+// Whole-cache estimates, with 95% confidence intervals, for every
+// set-sampled level of `system` (see set_sampling.hpp).
+template <typename CacheSystem>
+void PrintSetSamplingReport(const CacheSystem& system) {
+  auto format = [](const SetSampleEstimate& e, double scale, int digits) {
+    if (std::isnan(e.half_width)) {
+      return fmt::format("{:.{}f}", e.value * scale, digits);
+    }
+    return fmt::format("{:.{}f} +/- {:.{}f}", e.value * scale, digits,
+                       e.half_width * scale, digits);
+  };
+
+  fmt::print("\n=== Set Sampling (estimated whole-cache figures) ===\n");
+  fmt::print("{:<10} {:<8} {:>12} {:>24} {:>24} {:>20}\n", "Level",
+             "Sampler", "Sets", "Accesses", "Misses", "Miss Rate %");
+  system.ForEachLevel([&](const auto& level) {
+    using Level = std::remove_cvref_t<decltype(level)>;
+    if constexpr (Level::Sampler::kEnabled) {
+      const SetSampledStats s = level.SampledStats();
+      fmt::print("{:<10} {:<8} {:>12} {:>24} {:>24} {:>20}\n", s.name,
+                 Level::Sampler::kName,
+                 fmt::format("{}/{}", s.sampled_sets, s.sets),
+                 format(s.accesses, 1.0, 0), format(s.misses, 1.0, 0),
+                 format(s.miss_ratio, 100.0, 2));
+    }
+  });
+}
+
+// Prefetch usefulness of every level of `system` that has a prefetcher.
+// Prefetch hits are demand hits on a line a prefetch brought in; coverage
+// is the share of would-be misses they turned into hits.
+template <typename CacheSystem>
+void PrintPrefetchReport(const CacheSystem& system) {
+  fmt::print("\n=== Prefetching ===\n");
+  fmt::print("{:<10} {:<10} {:>10} {:>10} {:>10} {:>9} {:>9}\n", "Level",
+             "Prefetcher", "Issued", "Useful", "Unused", "Accuracy",
+             "Coverage");
+  system.ForEachLevel([](const auto& level) {
+    using Level = std::remove_cvref_t<decltype(level)>;
+    if constexpr (Level::Prefetcher::kEnabled) {
+      const LevelStats s = level.Stats();
+      fmt::print("{:<10} {:<10} {:>10} {:>10} {:>10} {:>8.1f}% {:>8.1f}%\n",
+                 s.name, Level::Prefetcher::kName, s.prefetches,
+                 s.prefetch_hits, s.prefetch_unused,
+                 s.PrefetchAccuracy() * 100.0, s.PrefetchCoverage() * 100.0);
+    }
+  });
+}
+
 }  // namespace stratum
 
 #endif  // CACHE_HPP
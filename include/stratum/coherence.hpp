@@ -0,0 +1,246 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef COHERENCE_HPP
+#define COHERENCE_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "stratum/cache_sim.hpp"
+#include "stratum/geometry.hpp"
+#include "stratum/policies.hpp"
+#include "stratum/tag_match.hpp"
+
+namespace stratum {
+
+// ============================================================================
+// Coherence directory for MultiCoreSystem (see multicore.hpp)
+// ============================================================================
+// A sparse directory (snoop filter) at the shared level: a set-associative
+// array of entries, each a tag, a sharer bit vector (one bit per core, so
+// up to 64 cores), an MSI/MESI state and the cores that lost their copy to
+// an invalidation. Entries live in parallel arrays like Cache's, so a
+// lookup is one set-index computation and one SIMD tag compare.
+//
+// MultiCoreSystem consults it on the accesses that need permission:
+//
+//   Load missing every private level   Read: the owner of an M/E copy is
+//                                      downgraded to S (flushing M data)
+//   Store missing every private level  Write: every other sharer is
+//                                      invalidated (flushing M data)
+//   Store hitting a private S copy     Write: an upgrade, same as above
+//   Prefetch fill sent to the shared   Read
+//
+// Loads that hit privately (and, in M or under MESI also in E, stores
+// that do) need no directory access. Clean private evictions are silent,
+// so sharer bits are a superset of the real copies; probing a stale one
+// finds nothing and is not counted. Evicting a directory entry
+// back-invalidates its sharers, which keeps the superset property.
+//
+// Flushed dirty data is written back into the shared level before the
+// request that caused it is served there. Probes are untimed.
+
+enum class CoherenceProtocol : uint8_t { kMSI, kMESI };
+
+// Coherence events, a category of their own next to the per-level stats.
+struct CoherenceStats {
+  uint64_t upgrades = 0;        // store hits on S copies (S -> M)
+  uint64_t downgrades = 0;      // M/E copies demoted by another core's read
+  uint64_t invalidations = 0;   // copies dropped by another core's write
+  uint64_t back_invalidations = 0;  // copies dropped on directory eviction
+  uint64_t flushes = 0;         // dirty copies written back by a probe
+  uint64_t coherence_misses = 0;  // fetches of a block lost to invalidation
+};
+
+// Default: no coherence. MultiCoreSystem compiles all of it out.
+struct NoCoherence {
+  static constexpr bool kEnabled = false;
+  static constexpr size_t kBlockSize = 0;
+};
+
+template <size_t Sets, size_t Ways, size_t BlockSize,
+          CoherenceProtocol Protocol = CoherenceProtocol::kMESI,
+          typename ReplacePolicy = LRUPolicy>
+class CoherenceDirectory {
+  using Mapping = AddressMapping<Sets, BlockSize>;
+  using BoundReplacePolicy = BoundPolicy<ReplacePolicy, Ways>;
+
+  enum State : uint8_t { kShared, kExclusive, kModified };
+
+  std::vector<uint64_t> tags_;     // kInvalidTag marks a free entry
+  std::vector<uint64_t> sharers_;  // bit c: core c may hold a copy
+  std::vector<uint64_t> lost_;     // bit c: core c lost it to a write
+  std::vector<uint8_t> state_;
+  BoundReplacePolicy policy_;
+  CoherenceStats stats_;
+
+ public:
+  static constexpr bool kEnabled = true;
+  static constexpr size_t kMaxCores = 64;
+  static constexpr size_t kBlockSize = BlockSize;
+  static constexpr CoherenceProtocol kProtocol = Protocol;
+
+  CoherenceDirectory()
+      : tags_(Sets * Ways, kInvalidTag),
+        sharers_(Sets * Ways, 0),
+        lost_(Sets * Ways, 0),
+        state_(Sets * Ways, kShared),
+        policy_(Sets, Ways) {}
+
+  // Core `core` reads the block of `addr`, which it is fetching into its
+  // private stack. probe(core, addr, drop) performs Invalidate (drop) or
+  // Clean on that core's stack and flushes dirty data; it returns the
+  // ProbeResult. `demand` is false for prefetch fills, which are never
+  // counted as coherence misses.
+  template <typename Probe>
+  void Read(size_t core, uint64_t addr, bool demand, Probe&& probe) {
+    const uint64_t bit = uint64_t{1} << core;
+    const size_t e = Find(addr);
+    if (e == kNone) {
+      Allocate(addr, bit, Protocol == CoherenceProtocol::kMESI ? kExclusive
+                                                              : kShared,
+               probe);
+      return;
+    }
+    CountLost(e, bit, demand);
+    const uint64_t others = sharers_[e] & ~bit;
+    if (state_[e] != kShared && others != 0) {
+      // `others` is the single owner of the E/M copy.
+      if (Count(probe(FirstWay(others), addr, /*drop=*/false))) {
+        stats_.downgrades++;
+      }
+      state_[e] = kShared;
+    } else if (others == 0 && state_[e] == kShared &&
+               Protocol == CoherenceProtocol::kMESI) {
+      state_[e] = kExclusive;
+    }
+    sharers_[e] |= bit;
+  }
+
+  // Core `core` writes the block of `addr`. `fetched` says whether the
+  // store missed every private level (otherwise it hit a private copy).
+  template <typename Probe>
+  void Write(size_t core, uint64_t addr, bool fetched, Probe&& probe) {
+    const uint64_t bit = uint64_t{1} << core;
+    const size_t e = Find(addr);
+    if (e == kNone) {
+      Allocate(addr, bit, kModified, probe);
+      return;
+    }
+    if (state_[e] == kModified && sharers_[e] == bit) return;
+    if (fetched) {
+      CountLost(e, bit, true);
+    } else if (state_[e] == kShared) {
+      stats_.upgrades++;
+    }
+    uint64_t others = sharers_[e] & ~bit;
+    while (others != 0) {
+      const size_t c = FirstWay(others);
+      others &= others - 1;
+      if (Count(probe(c, addr, /*drop=*/true))) {
+        stats_.invalidations++;
+        lost_[e] |= uint64_t{1} << c;
+      }
+    }
+    sharers_[e] = bit;
+    state_[e] = kModified;
+  }
+
+  // True when a store hit by `core` needs no directory access: the core
+  // already owns the block in M (or in E under MESI, which becomes M).
+  [[nodiscard]] bool OwnsForWrite(size_t core, uint64_t addr) {
+    const size_t e = Lookup(addr);
+    if (e == kNone || sharers_[e] != uint64_t{1} << core) return false;
+    if (state_[e] == kExclusive) state_[e] = kModified;
+    return state_[e] == kModified;
+  }
+
+  [[nodiscard]] const CoherenceStats& Stats() const { return stats_; }
+
+  void Reset() {
+    std::fill(tags_.begin(), tags_.end(), kInvalidTag);
+    std::fill(sharers_.begin(), sharers_.end(), 0);
+    std::fill(lost_.begin(), lost_.end(), 0);
+    std::fill(state_.begin(), state_.end(), kShared);
+    policy_.Reset();
+    stats_ = {};
+  }
+
+ private:
+  static constexpr size_t kNone = ~size_t{0};
+
+  size_t Lookup(uint64_t addr) const {
+    const uint64_t set_idx = Mapping::SetIndex(addr);
+    const WayMask hit =
+        MatchTags<Ways>(&tags_[set_idx * Ways], Mapping::Tag(addr));
+    return hit == 0 ? kNone : set_idx * Ways + FirstWay(hit);
+  }
+
+  size_t Find(uint64_t addr) {
+    const size_t e = Lookup(addr);
+    if (e != kNone) policy_.OnHit(e / Ways, e % Ways);
+    return e;
+  }
+
+  // Installs an entry for `addr` owned by the cores in `sharers`, evicting
+  // (and back-invalidating) the policy's victim if the set is full.
+  template <typename Probe>
+  void Allocate(uint64_t addr, uint64_t sharers, State state,
+                Probe& probe) {
+    const uint64_t set_idx = Mapping::SetIndex(addr);
+    const uint64_t* set_tags = &tags_[set_idx * Ways];
+    const WayMask free = MatchTags<Ways>(set_tags, kInvalidTag);
+    const size_t way =
+        free != 0 ? FirstWay(free) : policy_.GetVictim(set_idx);
+    const size_t e = set_idx * Ways + way;
+    if (free == 0) {
+      const uint64_t victim = Mapping::BlockAddress(tags_[e], set_idx);
+      for (uint64_t v = sharers_[e]; v != 0; v &= v - 1) {
+        if (Count(probe(FirstWay(v), victim, /*drop=*/true))) {
+          stats_.back_invalidations++;
+        }
+      }
+    }
+    tags_[e] = Mapping::Tag(addr);
+    sharers_[e] = sharers;
+    lost_[e] = 0;
+    state_[e] = state;
+    policy_.OnFill(set_idx, way);
+  }
+
+  // Counts a flush; true if the probe found a copy.
+  bool Count(const ProbeResult& res) {
+    if (res.dirty) stats_.flushes++;
+    return res.present;
+  }
+
+  void CountLost(size_t e, uint64_t bit, bool demand) {
+    if ((lost_[e] & bit) == 0) return;
+    lost_[e] &= ~bit;
+    if (demand) stats_.coherence_misses++;
+  }
+};
+
+// Directory with the geometry of the hierarchy level `Level` (typically
+// the shared LLC), i.e. one entry per LLC line.
+template <typename Level,
+          CoherenceProtocol Protocol = CoherenceProtocol::kMESI>
+using DirectoryFor = CoherenceDirectory<Level::kSets, Level::kWays,
+                                        Level::kBlockSize, Protocol>;
+
+inline void PrintCoherenceStats(const CoherenceStats& s) {
+  fmt::print(
+      "Coherence: Upgrades={}, Downgrades={}, Invalidations={}, "
+      "BackInvalidations={}, Flushes={}, CoherenceMisses={}\n",
+      s.upgrades, s.downgrades, s.invalidations, s.back_invalidations,
+      s.flushes, s.coherence_misses);
+}
+
+}  // namespace stratum
+
+#endif  // COHERENCE_HPP
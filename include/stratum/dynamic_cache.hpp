@@ -0,0 +1,613 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef DYNAMIC_CACHE_HPP
+#define DYNAMIC_CACHE_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stratum/cache_sim.hpp"
+#include "stratum/geometry.hpp"
+#include "stratum/parallel.hpp"
+#include "stratum/policies.hpp"
+#include "stratum/prefetch.hpp"
+#include "stratum/simulation.hpp"
+#include "stratum/sweep.hpp"
+#include "stratum/tag_match.hpp"
+
+namespace stratum {
+
+// ============================================================================
+// Runtime-configured hierarchies
+// ============================================================================
+// Cache<...> resolves a hierarchy at compile time, so every geometry of a
+// config.rkt sweep costs a code generation and a C++ build. DynamicCache
+// builds one from a config read at run time, in the DSL's syntax:
+//
+//   (case_001
+//    (L1      64   8    4   LRUPolicy   L2)
+//    (L2      512  8    64  LRUPolicy   MainMemory))
+//
+// A level has the DSL's fields (name sets ways latency policy next) and an
+// optional seventh, the block size in bytes (default 64, as the DSL emits).
+// Levels are listed top first. A file holds any number of experiments,
+// either at top level or inside one enclosing list; `;` starts a comment,
+// [ ] work like ( ) and quote characters are ignored, so the experiments
+// list of config.rkt can be copied in as is.
+//
+// Each level's access path is a kernel specialized on its associativity
+// (one of kDynamicWays) and replacement policy, chosen once when the level
+// is built and called through a function pointer: one indirect call per
+// level an access reaches, and the same tag compare and policy code as
+// Cache. Set index and tag use shifts for power-of-two geometries and
+// division otherwise. Levels are write-back, write-allocate and
+// non-inclusive, and memory has a fixed latency, like the hierarchies the
+// DSL generates, so results match them access for access.
+
+struct DynamicLevelConfig {
+  std::string name;
+  size_t sets = 0;
+  size_t ways = 0;
+  size_t latency = 0;
+  std::string policy;
+  std::string next;  // a later level or "MainMemory"
+  size_t block_size = 64;
+};
+
+struct DynamicHierarchyConfig {
+  std::string name;
+  std::vector<DynamicLevelConfig> levels;  // top first
+};
+
+// Associativities and policies with a precompiled kernel. TreePLRUPolicy
+// needs a power of two and PackedLRUPolicy at most 16 ways.
+inline constexpr std::array<size_t, 8> kDynamicWays{1,  2,  4,  8,
+                                                    12, 16, 20, 32};
+using DynamicPolicies =
+    std::tuple<LRUPolicy, FIFOPolicy, RandomPolicy, TreePLRUPolicy,
+               PackedLRUPolicy, SRRIPPolicy, BRRIPPolicy, DRRIPPolicy>;
+inline constexpr std::array<std::string_view, 8> kDynamicPolicyNames{
+    "LRUPolicy",       "FIFOPolicy",  "RandomPolicy", "TreePLRUPolicy",
+    "PackedLRUPolicy", "SRRIPPolicy", "BRRIPPolicy",  "DRRIPPolicy"};
+
+// Most levels a dynamic hierarchy can have, memory included.
+inline constexpr size_t kMaxDynamicLevels = 8;
+
+namespace detail {
+
+template <typename Policy, size_t Ways>
+constexpr bool DynamicKernelExists() {
+  if constexpr (std::is_same_v<Policy, TreePLRUPolicy>) {
+    return IsPowerOfTwo(Ways);
+  } else if constexpr (std::is_same_v<Policy, PackedLRUPolicy>) {
+    return Ways <= 16;
+  } else {
+    return true;
+  }
+}
+
+constexpr size_t kNoDynamicKernel = ~size_t{0};
+
+// Index of the kernel for `policy` and `ways` (policy-major), whether or
+// not that combination exists, or kNoDynamicKernel if either is unknown.
+inline size_t DynamicKernelIndex(std::string_view policy, size_t ways) {
+  const auto* p = std::find(kDynamicPolicyNames.begin(),
+                            kDynamicPolicyNames.end(), policy);
+  const auto* w = std::find(kDynamicWays.begin(), kDynamicWays.end(), ways);
+  if (p == kDynamicPolicyNames.end() || w == kDynamicWays.end()) {
+    return kNoDynamicKernel;
+  }
+  return (p - kDynamicPolicyNames.begin()) * kDynamicWays.size() +
+         (w - kDynamicWays.begin());
+}
+
+inline constexpr size_t kDynamicKernels =
+    std::tuple_size_v<DynamicPolicies> * kDynamicWays.size();
+
+inline constexpr auto kDynamicKernelExists =
+    []<size_t... I>(std::index_sequence<I...>) {
+      constexpr size_t kWays = kDynamicWays.size();
+      return std::array<bool, sizeof...(I)>{
+          DynamicKernelExists<std::tuple_element_t<I / kWays, DynamicPolicies>,
+                              kDynamicWays[I % kWays]>()...};
+    }(std::make_index_sequence<kDynamicKernels>{});
+
+// Minimal s-expression reader for hierarchy configs.
+struct SExpr {
+  bool is_list = false;
+  std::string_view atom;
+  std::vector<SExpr> items;
+  size_t line = 0;
+};
+
+class SExprReader {
+  std::string_view text_;
+  size_t pos_ = 0;
+  size_t line_ = 1;
+
+ public:
+  explicit SExprReader(std::string_view text) : text_(text) {}
+
+  // Reads the next top-level expression; false at the end of the text.
+  bool Next(SExpr& out) {
+    SkipSpace();
+    if (pos_ == text_.size()) return false;
+    out = Read();
+    return true;
+  }
+
+ private:
+  [[noreturn]] void Fail(std::string_view what) const {
+    throw std::invalid_argument(fmt::format("line {}: {}", line_, what));
+  }
+
+  void SkipSpace() {
+    while (pos_ < text_.size()) {
+      const char c = text_[pos_];
+      if (c == '\n') {
+        line_++;
+        pos_++;
+      } else if (c == ';') {
+        while (pos_ < text_.size() && text_[pos_] != '\n') pos_++;
+      } else if (c == ' ' || c == '\t' || c == '\r' || c == '\'' ||
+                 c == '`') {
+        pos_++;
+      } else {
+        return;
+      }
+    }
+  }
+
+  SExpr Read() {
+    SExpr expr;
+    expr.line = line_;
+    const char c = text_[pos_];
+    if (c == ')' || c == ']') Fail("unexpected closing bracket");
+    if (c == '(' || c == '[') {
+      const char close = c == '(' ? ')' : ']';
+      expr.is_list = true;
+      pos_++;
+      while (true) {
+        SkipSpace();
+        if (pos_ == text_.size()) Fail("unterminated list");
+        if (text_[pos_] == close) break;
+        expr.items.push_back(Read());
+      }
+      pos_++;
+      return expr;
+    }
+    const size_t start = pos_;
+    while (pos_ < text_.size() &&
+           std::string_view(" \t\r\n;()[]").find(text_[pos_]) ==
+               std::string_view::npos) {
+      pos_++;
+    }
+    expr.atom = text_.substr(start, pos_ - start);
+    return expr;
+  }
+};
+
+inline bool IsLevelForm(const SExpr& e) {
+  return e.is_list && !e.items.empty() &&
+         std::all_of(e.items.begin(), e.items.end(),
+                     [](const SExpr& item) { return !item.is_list; });
+}
+
+inline size_t ParseField(const SExpr& e, std::string_view field) {
+  size_t value = 0;
+  const char* end = e.atom.data() + e.atom.size();
+  const auto [ptr, ec] = std::from_chars(e.atom.data(), end, value);
+  if (e.is_list || ec != std::errc() || ptr != end) {
+    throw std::invalid_argument(
+        fmt::format("line {}: {} must be a number", e.line, field));
+  }
+  return value;
+}
+
+inline DynamicHierarchyConfig ParseExperiment(const SExpr& e) {
+  if (e.items.size() < 2 || e.items[0].is_list) {
+    throw std::invalid_argument(fmt::format(
+        "line {}: expected (experiment-name (level ...) ...)", e.line));
+  }
+  DynamicHierarchyConfig config{std::string(e.items[0].atom), {}};
+  for (size_t i = 1; i < e.items.size(); ++i) {
+    const SExpr& level = e.items[i];
+    if (!IsLevelForm(level) ||
+        (level.items.size() != 6 && level.items.size() != 7)) {
+      throw std::invalid_argument(fmt::format(
+          "line {}: expected (name sets ways latency policy next "
+          "[block-size])",
+          level.line));
+    }
+    const auto& f = level.items;
+    config.levels.push_back(
+        {std::string(f[0].atom), ParseField(f[1], "sets"),
+         ParseField(f[2], "ways"), ParseField(f[3], "latency"),
+         std::string(f[4].atom), std::string(f[5].atom),
+         f.size() == 7 ? ParseField(f[6], "block size") : 64});
+  }
+  return config;
+}
+
+}  // namespace detail
+
+// Checks that `config` describes a hierarchy DynamicCache can build: every
+// level is reached once along the `next` chain from the first one, which
+// ends in MainMemory, and every geometry and policy has a kernel. Throws
+// std::invalid_argument naming the first problem.
+inline void ValidateHierarchyConfig(const DynamicHierarchyConfig& config) {
+  auto fail = [&](std::string_view what) {
+    throw std::invalid_argument(fmt::format("{}: {}", config.name, what));
+  };
+  if (config.levels.empty()) fail("no cache levels");
+  if (config.levels.size() >= kMaxDynamicLevels) {
+    fail(fmt::format("more than {} cache levels", kMaxDynamicLevels - 1));
+  }
+  for (size_t i = 0; i < config.levels.size(); ++i) {
+    const DynamicLevelConfig& level = config.levels[i];
+    const std::string_view expected =
+        i + 1 < config.levels.size()
+            ? std::string_view(config.levels[i + 1].name)
+            : "MainMemory";
+    if (level.next != expected) {
+      fail(fmt::format("{} must be followed by {}, not {}", level.name,
+                       expected, level.next));
+    }
+    if (level.sets == 0 || level.block_size == 0 ||
+        level.sets * level.block_size < 2) {
+      fail(fmt::format("{} has an empty geometry", level.name));
+    }
+    if (kRequirePow2Geometry &&
+        !(IsPowerOfTwo(level.sets) && IsPowerOfTwo(level.block_size))) {
+      fail(fmt::format("{} geometry must be a power of two "
+                       "(STRATUM_REQUIRE_POW2_GEOMETRY is enabled)",
+                       level.name));
+    }
+    if (std::find(kDynamicPolicyNames.begin(), kDynamicPolicyNames.end(),
+                  level.policy) == kDynamicPolicyNames.end()) {
+      fail(fmt::format("{}: unknown policy {}", level.name, level.policy));
+    }
+    const size_t kernel = detail::DynamicKernelIndex(level.policy, level.ways);
+    if (kernel == detail::kNoDynamicKernel ||
+        !detail::kDynamicKernelExists[kernel]) {
+      fail(fmt::format("{}: no {}-way {} kernel (see kDynamicWays)",
+                       level.name, level.ways, level.policy));
+    }
+  }
+}
+
+// Parses every experiment in `text`, validated. Throws
+// std::invalid_argument with the line or experiment of the first error.
+inline std::vector<DynamicHierarchyConfig> ParseHierarchyConfigs(
+    std::string_view text) {
+  std::vector<DynamicHierarchyConfig> configs;
+  detail::SExprReader reader(text);
+  detail::SExpr form;
+  while (reader.Next(form)) {
+    if (!form.is_list || form.items.empty()) {
+      throw std::invalid_argument(
+          fmt::format("line {}: expected an experiment", form.line));
+    }
+    // Either one experiment or a list of them.
+    if (form.items[0].is_list) {
+      for (const auto& e : form.items) {
+        configs.push_back(detail::ParseExperiment(e));
+      }
+    } else {
+      configs.push_back(detail::ParseExperiment(form));
+    }
+  }
+  for (const auto& config : configs) ValidateHierarchyConfig(config);
+  return configs;
+}
+
+inline std::vector<DynamicHierarchyConfig> LoadHierarchyConfigs(
+    const std::string& path) {
+  std::ifstream file(path);
+  if (!file) throw std::invalid_argument(fmt::format("cannot read {}", path));
+  std::stringstream text;
+  text << file.rdbuf();
+  try {
+    return ParseHierarchyConfigs(text.str());
+  } catch (const std::invalid_argument& e) {
+    throw std::invalid_argument(fmt::format("{}: {}", path, e.what()));
+  }
+}
+
+// A hierarchy built at run time from a DynamicHierarchyConfig. Has the
+// Load/Store/AccessBatch interface of Cache, so ReplayTrace drives it.
+//
+// Example:
+//   const auto configs = LoadHierarchyConfigs("sweep.sexp");
+//   DynamicCache system(configs[0], 100);
+//   system.Load(0x1000);
+class DynamicCache {
+  using Access = AccessResult (*)(DynamicCache&, size_t, uint64_t, bool);
+
+  struct Level {
+    std::string name;
+    size_t sets;
+    size_t ways;
+    size_t block_size;
+    size_t latency;
+    bool pow2;
+    unsigned offset_bits;
+    unsigned set_bits;
+    std::vector<uint64_t> tags;
+    std::vector<WayMask> dirty;
+    std::unique_ptr<void, void (*)(void*)> policy{nullptr, nullptr};
+    Access access;
+    void (*reset_policy)(void*);
+
+    uint64_t SetIndex(uint64_t addr) const {
+      return pow2 ? (addr >> offset_bits) & (sets - 1)
+                  : (addr / block_size) % sets;
+    }
+    uint64_t Tag(uint64_t addr) const {
+      return pow2 ? addr >> (offset_bits + set_bits)
+                  : addr / (block_size * sets);
+    }
+    uint64_t BlockAddress(uint64_t tag, uint64_t set_idx) const {
+      return pow2 ? (tag << (offset_bits + set_bits)) |
+                        (set_idx << offset_bits)
+                  : (tag * sets + set_idx) * block_size;
+    }
+  };
+
+  // What a level needs from its (Ways, policy) specialization.
+  struct Kernel {
+    Access access = nullptr;
+    void* (*make_policy)(size_t sets) = nullptr;
+    void (*destroy_policy)(void*) = nullptr;
+    void (*reset_policy)(void*) = nullptr;
+  };
+
+  std::vector<Level> levels_;
+  size_t mem_latency_;
+
+ public:
+  // Throws std::invalid_argument if `config` is invalid (see
+  // ValidateHierarchyConfig).
+  explicit DynamicCache(const DynamicHierarchyConfig& config,
+                        size_t mem_latency = 100)
+      : mem_latency_(mem_latency) {
+    ValidateHierarchyConfig(config);
+    levels_.reserve(config.levels.size());
+    for (const DynamicLevelConfig& c : config.levels) {
+      const Kernel& kernel =
+          KernelAt(detail::DynamicKernelIndex(c.policy, c.ways));
+      Level& level = levels_.emplace_back();
+      level.name = c.name;
+      level.sets = c.sets;
+      level.ways = c.ways;
+      level.block_size = c.block_size;
+      level.latency = c.latency;
+      level.pow2 = IsPowerOfTwo(c.sets) && IsPowerOfTwo(c.block_size);
+      level.offset_bits = level.pow2 ? Log2(c.block_size) : 0;
+      level.set_bits = level.pow2 ? Log2(c.sets) : 0;
+      level.tags.assign(c.sets * c.ways, kInvalidTag);
+      level.dirty.assign(c.sets, 0);
+      level.policy = {kernel.make_policy(c.sets), kernel.destroy_policy};
+      level.access = kernel.access;
+      level.reset_policy = kernel.reset_policy;
+    }
+  }
+
+  DynamicCache(const DynamicCache&) = delete;
+  DynamicCache& operator=(const DynamicCache&) = delete;
+
+  AccessResult Load(uint64_t addr) { return AccessLevel(0, addr, false); }
+  AccessResult Store(uint64_t addr) { return AccessLevel(0, addr, true); }
+
+  void AccessBatch(std::span<const TraceOp> ops,
+                   std::span<AccessResult> results) {
+    const Level& top = levels_.front();
+    for (size_t i = 0; i < ops.size(); ++i) {
+      if (i + kBatchPrefetchDistance < ops.size()) {
+        const uint64_t set = top.SetIndex(ops[i + kBatchPrefetchDistance].addr);
+        PrefetchRange(&top.tags[set * top.ways], top.ways * sizeof(uint64_t));
+      }
+      results[i] = AccessLevel(0, ops[i].addr, ops[i].type != 'L');
+    }
+  }
+
+  // Number of levels, MainMemory included.
+  [[nodiscard]] size_t Levels() const { return levels_.size() + 1; }
+
+  [[nodiscard]] std::string_view LevelName(size_t level) const {
+    return level < levels_.size() ? std::string_view(levels_[level].name)
+                                  : "MainMemory";
+  }
+
+  void Reset() {
+    for (Level& level : levels_) {
+      std::fill(level.tags.begin(), level.tags.end(), kInvalidTag);
+      std::fill(level.dirty.begin(), level.dirty.end(), 0);
+      level.reset_policy(level.policy.get());
+    }
+  }
+
+ private:
+  AccessResult AccessLevel(size_t i, uint64_t addr, bool store) {
+    if (i == levels_.size()) return {0, mem_latency_};
+    return levels_[i].access(*this, i, addr, store);
+  }
+
+  // Cache::Load and Cache::Store of level `i`, for one (Ways, policy).
+  template <size_t Ways, typename Policy>
+  static AccessResult LevelAccess(DynamicCache& self, size_t i,
+                                  uint64_t addr, bool store) {
+    using Bound = BoundPolicy<Policy, Ways>;
+    Level& level = self.levels_[i];
+    Bound& policy = *static_cast<Bound*>(level.policy.get());
+    const uint64_t set_idx = level.SetIndex(addr);
+    const uint64_t tag = level.Tag(addr);
+    uint64_t* set_tags = &level.tags[set_idx * Ways];
+
+    const TagLookup lookup = LookupTags<Ways>(set_tags, tag);
+    if (lookup.hit != 0) {
+      if (store) level.dirty[set_idx] |= lookup.hit;
+      policy.OnHit(set_idx, FirstWay(lookup.hit));
+      return {0, level.latency};
+    }
+
+    if constexpr (requires { policy.OnMiss(set_idx); }) {
+      policy.OnMiss(set_idx);
+    }
+    AccessResult res = self.AccessLevel(i + 1, addr, false);
+    res.hit_level++;
+    res.total_cycles += level.latency;
+
+    // Fill, born dirty on a store; a dirty victim is written back first.
+    size_t way;
+    if (lookup.free != 0) {
+      way = FirstWay(lookup.free);
+    } else {
+      way = policy.GetVictim(set_idx);
+      if (level.dirty[set_idx] & (WayMask{1} << way)) {
+        self.AccessLevel(i + 1, level.BlockAddress(set_tags[way], set_idx),
+                         true);
+      }
+    }
+    const WayMask bit = WayMask{1} << way;
+    set_tags[way] = tag;
+    level.dirty[set_idx] = (level.dirty[set_idx] & ~bit) | (store ? bit : 0);
+    policy.OnFill(set_idx, way);
+    return res;
+  }
+
+  template <size_t Ways, typename Policy>
+  static constexpr Kernel MakeKernel() {
+    using Bound = BoundPolicy<Policy, Ways>;
+    if constexpr (!detail::DynamicKernelExists<Policy, Ways>()) {
+      return {};
+    } else {
+      return {
+          &LevelAccess<Ways, Policy>,
+          [](size_t sets) -> void* {
+            if constexpr (std::is_constructible_v<Bound, size_t, size_t,
+                                                  Arena*>) {
+              return new Bound(sets, Ways, nullptr);
+            } else {
+              return new Bound(sets, Ways);
+            }
+          },
+          [](void* p) { delete static_cast<Bound*>(p); },
+          [](void* p) { static_cast<Bound*>(p)->Reset(); }};
+    }
+  }
+
+  // The kernel at detail::DynamicKernelIndex `index`.
+  static const Kernel& KernelAt(size_t index) {
+    static constexpr auto kKernels =
+        []<size_t... I>(std::index_sequence<I...>) {
+          constexpr size_t kWays = kDynamicWays.size();
+          return std::array<Kernel, sizeof...(I)>{
+              MakeKernel<kDynamicWays[I % kWays],
+                         std::tuple_element_t<I / kWays,
+                                              DynamicPolicies>>()...};
+        }(std::make_index_sequence<detail::kDynamicKernels>{});
+    return kKernels[index];
+  }
+};
+
+namespace detail {
+
+inline SweepResult RunDynamicSweepJob(const DynamicHierarchyConfig& config,
+                                      const LoadedTrace& trace,
+                                      size_t mem_latency) {
+  const auto start = std::chrono::steady_clock::now();
+
+  DynamicCache system(config, mem_latency);
+  SimulationStats<kMaxDynamicLevels> stats;
+  trace.WithReader([&](auto& reader) {
+    ReplayTrace(reader, system,
+                [&](const TraceOp& op, const AccessResult& res) {
+                  stats.Record(op, res);
+                });
+  });
+
+  SweepResult result;
+  result.config = config.name;
+  result.accesses = stats.Accesses();
+  for (size_t i = 0; i < system.Levels(); ++i) {
+    const std::string_view name =
+        i < config.levels.size() ? std::string_view(config.levels[i].name)
+                                 : "MainMemory";
+    result.levels.push_back({name, stats.Level(i)});
+    result.total_cycles += result.levels.back().stats.total_latency;
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+}  // namespace detail
+
+// RunSweep over runtime configurations: every hierarchy of `configs` on
+// every trace, with the same scheduling and result order (trace-major, in
+// config order). Results refer to the names in `configs`, which must
+// outlive them. Throws std::invalid_argument before running anything if a
+// config is invalid.
+//
+// Example:
+//   const auto configs = LoadHierarchyConfigs("sweep.sexp");
+//   PrintSweepTable(RunDynamicSweep(configs, traces));
+inline std::vector<SweepResult> RunDynamicSweep(
+    const std::vector<DynamicHierarchyConfig>& configs,
+    const std::vector<SweepTrace>& traces, size_t threads = 0,
+    size_t mem_latency = 100) {
+  for (const auto& config : configs) ValidateHierarchyConfig(config);
+  const size_t num_configs = configs.size();
+
+  std::vector<std::unique_ptr<LoadedTrace>> loaded(traces.size());
+  ParallelFor(traces.size(), threads, [&](size_t t) {
+    loaded[t] = std::make_unique<LoadedTrace>(traces[t].path);
+  });
+
+  std::vector<size_t> order(traces.size() * num_configs);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return loaded[a / num_configs]->OpCount() >
+           loaded[b / num_configs]->OpCount();
+  });
+
+  std::vector<SweepResult> results(order.size());
+  ParallelFor(order.size(), threads, [&](size_t i) {
+    const size_t slot = order[i];
+    const size_t t = slot / num_configs;
+    results[slot] = detail::RunDynamicSweepJob(configs[slot % num_configs],
+                                               *loaded[t], mem_latency);
+    results[slot].trace = traces[t].name;
+  });
+  return results;
+}
+
+// The results would refer to the names of a temporary.
+std::vector<SweepResult> RunDynamicSweep(
+    std::vector<DynamicHierarchyConfig>&& configs,
+    const std::vector<SweepTrace>& traces, size_t threads = 0,
+    size_t mem_latency = 100) = delete;
+
+}  // namespace stratum
+
+#endif  // DYNAMIC_CACHE_HPP
@@ -0,0 +1,76 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef GEOMETRY_HPP
+#define GEOMETRY_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace stratum {
+
+// Build with -DSTRATUM_REQUIRE_POW2_GEOMETRY=1 (CMake option of the same
+// name) to make Cache reject non-power-of-two Sets/BlockSize at compile time.
+#ifndef STRATUM_REQUIRE_POW2_GEOMETRY
+#define STRATUM_REQUIRE_POW2_GEOMETRY 0
+#endif
+
+inline constexpr bool kRequirePow2Geometry = STRATUM_REQUIRE_POW2_GEOMETRY;
+
+constexpr bool IsPowerOfTwo(uint64_t x) { return std::has_single_bit(x); }
+
+// floor(log2(x)) for x > 0.
+constexpr unsigned Log2(uint64_t x) {
+  return static_cast<unsigned>(std::bit_width(x)) - 1;
+}
+
+// Address decomposition for a cache with `Sets` sets of `BlockSize` bytes.
+//
+// -------------------------------------------------------
+// |       Tag       |    Set Index    |  Block Offset   |
+// -------------------------------------------------------
+//
+// Power-of-two geometries (the common case) are bit-sliced with shifts and
+// masks; anything else falls back to division and modulo. The choice is made
+// at compile time, so neither path costs anything when not used.
+template <size_t Sets, size_t BlockSize>
+struct AddressMapping {
+  static_assert(Sets > 0 && BlockSize > 0, "Sets and BlockSize must be > 0");
+
+  static constexpr bool kPowerOfTwo =
+      IsPowerOfTwo(Sets) && IsPowerOfTwo(BlockSize);
+
+  static constexpr unsigned kOffsetBits = kPowerOfTwo ? Log2(BlockSize) : 0;
+  static constexpr unsigned kSetBits = kPowerOfTwo ? Log2(Sets) : 0;
+  static constexpr uint64_t kSetMask = Sets - 1;
+
+  static constexpr uint64_t SetIndex(uint64_t addr) noexcept {
+    if constexpr (kPowerOfTwo) {
+      return (addr >> kOffsetBits) & kSetMask;
+    } else {
+      return (addr / BlockSize) % Sets;
+    }
+  }
+
+  static constexpr uint64_t Tag(uint64_t addr) noexcept {
+    if constexpr (kPowerOfTwo) {
+      return addr >> (kOffsetBits + kSetBits);
+    } else {
+      return addr / (BlockSize * Sets);
+    }
+  }
+
+  // Inverse of (Tag, SetIndex): first byte address of the block.
+  static constexpr uint64_t BlockAddress(uint64_t tag,
+                                         uint64_t set_idx) noexcept {
+    if constexpr (kPowerOfTwo) {
+      return (tag << (kOffsetBits + kSetBits)) | (set_idx << kOffsetBits);
+    } else {
+      return (tag * Sets + set_idx) * BlockSize;
+    }
+  }
+};
+
+}  // namespace stratum
+
+#endif  // GEOMETRY_HPP
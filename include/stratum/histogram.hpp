@@ -0,0 +1,126 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace stratum {
+
+// Constant-memory log-linear histogram of unsigned values (HdrHistogram
+// style), cheap enough to update inline for every simulated access.
+//
+// Values below 2^SubBucketBits get one bucket each and are exact. Above
+// that, every power-of-two range is split into 2^(SubBucketBits - 1)
+// linear buckets, so a bucket is never wider than 1 / 2^(SubBucketBits - 1)
+// of the values it holds (about 3% with the default 6 bits). Values of
+// 2^MaxBits and up share the last bucket; Count/Total/Min/Max stay exact.
+//
+// The layout is fixed at compile time, so histograms of the same type
+// merge bucket by bucket, e.g. across the workers of a parallel run.
+template <unsigned SubBucketBits = 6, unsigned MaxBits = 32>
+class LogLinearHistogram {
+  static_assert(SubBucketBits >= 1 && SubBucketBits < MaxBits &&
+                MaxBits <= 64);
+
+  static constexpr uint64_t kLinear = uint64_t{1} << SubBucketBits;
+  static constexpr uint64_t kHalf = kLinear / 2;
+
+ public:
+  static constexpr size_t kBuckets =
+      (MaxBits - SubBucketBits) * kHalf + kLinear;
+
+  static constexpr size_t BucketIndex(uint64_t value) {
+    if (value < kLinear) return value;
+    const unsigned shift = std::bit_width(value) - SubBucketBits;
+    const size_t index = size_t{shift} * kHalf + (value >> shift);
+    return std::min(index, kBuckets - 1);
+  }
+
+  // Smallest value counted in `index`.
+  static constexpr uint64_t BucketFloor(size_t index) {
+    if (index < kLinear) return index;
+    const unsigned shift = static_cast<unsigned>(index / kHalf) - 1;
+    return (index - shift * kHalf) << shift;
+  }
+
+  // Largest value counted in `index` (the last bucket is open-ended).
+  static constexpr uint64_t BucketCeil(size_t index) {
+    if (index == kBuckets - 1) return std::numeric_limits<uint64_t>::max();
+    return BucketFloor(index + 1) - 1;
+  }
+
+  void Record(uint64_t value) noexcept {
+    ++counts_[BucketIndex(value)];
+    ++count_;
+    total_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  void Merge(const LogLinearHistogram& other) noexcept {
+    for (size_t b = 0; b < kBuckets; ++b) counts_[b] += other.counts_[b];
+    count_ += other.count_;
+    total_ += other.total_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  // Counts recorded since `earlier` was taken from this histogram. Min and
+  // Max of the result are bucket bounds rather than exact values.
+  [[nodiscard]] LogLinearHistogram Since(
+      const LogLinearHistogram& earlier) const {
+    LogLinearHistogram delta;
+    for (size_t b = 0; b < kBuckets; ++b) {
+      delta.counts_[b] = counts_[b] - earlier.counts_[b];
+      if (delta.counts_[b] == 0) continue;
+      delta.min_ = std::min(delta.min_, std::max(BucketFloor(b), min_));
+      delta.max_ = std::max(delta.max_, std::min(BucketCeil(b), max_));
+    }
+    delta.count_ = count_ - earlier.count_;
+    delta.total_ = total_ - earlier.total_;
+    return delta;
+  }
+
+  [[nodiscard]] uint64_t Count() const { return count_; }
+  [[nodiscard]] uint64_t Total() const { return total_; }
+  [[nodiscard]] uint64_t Bucket(size_t index) const { return counts_[index]; }
+  [[nodiscard]] uint64_t Min() const { return count_ == 0 ? 0 : min_; }
+  [[nodiscard]] uint64_t Max() const { return max_; }
+  [[nodiscard]] double Mean() const {
+    return count_ == 0 ? 0.0 : static_cast<double>(total_) / count_;
+  }
+
+  // Value at or below which `percent` of the recorded values fall, to
+  // bucket precision (the highest value of the bucket holding that rank,
+  // clamped to the exact Min/Max). 0 when empty.
+  [[nodiscard]] uint64_t Percentile(double percent) const {
+    if (count_ == 0) return 0;
+    const double fraction = std::clamp(percent, 0.0, 100.0) / 100.0;
+    const uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(fraction * count_)));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+      seen += counts_[b];
+      if (seen >= rank) return std::clamp(BucketCeil(b), Min(), max_);
+    }
+    return max_;
+  }
+
+ private:
+  std::array<uint64_t, kBuckets> counts_{};
+  uint64_t count_ = 0;
+  uint64_t total_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+};
+
+}  // namespace stratum
+
+#endif  // HISTOGRAM_HPP
@@ -0,0 +1,255 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+#include <fmt/core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stratum/histogram.hpp"
+#include "stratum/snapshot.hpp"
+
+namespace stratum {
+
+// Build with -DSTRATUM_INSTRUMENTATION=0 (CMake option of the same name) to
+// compile the per-level counters out of every Cache. Hit/miss reports made
+// by the simulation driver (SimulationStats) are unaffected.
+#ifndef STRATUM_INSTRUMENTATION
+#define STRATUM_INSTRUMENTATION 1
+#endif
+
+inline constexpr bool kInstrumentation = STRATUM_INSTRUMENTATION;
+
+// Distribution of the latency of the requests a level serves.
+using LatencyHistogram = LogLinearHistogram<>;
+
+// Counters of one level, as returned by Cache::Stats().
+//
+// misses counts demand misses; writebacks counts the dirty lines the level
+// above wrote back into this one (each of which also counts as a Store
+// hit or miss here); latency covers every request the level served.
+//
+// The prefetch counters cover the level's own prefetcher (prefetchers.hpp):
+// prefetches counts lines it filled, prefetch_hits the demand hits that used
+// such a line for the first time (also counted in hits), and prefetch_unused
+// the prefetched lines evicted before any use.
+//
+// back_invalidations counts the lines an inclusive level dropped from the
+// levels above when it evicted their block (see level_policies.hpp).
+struct LevelStats {
+  std::string_view name;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;  // dirty victims written to the next level
+  uint64_t writebacks = 0;
+  LatencyHistogram latency;
+  uint64_t prefetches = 0;
+  uint64_t prefetch_hits = 0;
+  uint64_t prefetch_unused = 0;
+  uint64_t back_invalidations = 0;
+
+  // Fraction of prefetched lines that a demand access used.
+  [[nodiscard]] double PrefetchAccuracy() const {
+    return prefetches == 0 ? 0.0 : (double)prefetch_hits / prefetches;
+  }
+
+  // Fraction of the misses without prefetching that prefetches removed.
+  [[nodiscard]] double PrefetchCoverage() const {
+    const uint64_t would_miss = prefetch_hits + misses;
+    return would_miss == 0 ? 0.0 : (double)prefetch_hits / would_miss;
+  }
+
+  [[nodiscard]] LevelStats Since(const LevelStats& earlier) const {
+    return {name,
+            hits - earlier.hits,
+            misses - earlier.misses,
+            evictions - earlier.evictions,
+            writebacks - earlier.writebacks,
+            latency.Since(earlier.latency),
+            prefetches - earlier.prefetches,
+            prefetch_hits - earlier.prefetch_hits,
+            prefetch_unused - earlier.prefetch_unused,
+            back_invalidations - earlier.back_invalidations};
+  }
+};
+
+// Per-level counters kept by Cache on the access path. The disabled
+// specialization is empty and every hook is a no-op, so an uninstrumented
+// build pays nothing.
+template <bool Enabled = kInstrumentation>
+class LevelCounters {
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t evictions_ = 0;
+  uint64_t writebacks_ = 0;
+  LatencyHistogram latency_;
+  uint64_t prefetches_ = 0;
+  uint64_t prefetch_hits_ = 0;
+  uint64_t prefetch_unused_ = 0;
+  uint64_t back_invalidations_ = 0;
+
+ public:
+  static constexpr bool kEnabled = true;
+
+  void Hit() noexcept { ++hits_; }
+  void Miss() noexcept { ++misses_; }
+  void Eviction() noexcept { ++evictions_; }
+  void Writeback() noexcept { ++writebacks_; }
+  void Latency(uint64_t cycles) noexcept { latency_.Record(cycles); }
+  void Prefetch() noexcept { ++prefetches_; }
+  void PrefetchHit() noexcept { ++prefetch_hits_; }
+  void PrefetchUnused() noexcept { ++prefetch_unused_; }
+  void BackInvalidation() noexcept { ++back_invalidations_; }
+
+  [[nodiscard]] LevelStats Stats(std::string_view name) const {
+    return {name,        hits_,          misses_,
+            evictions_,  writebacks_,    latency_,
+            prefetches_, prefetch_hits_, prefetch_unused_,
+            back_invalidations_};
+  }
+
+  void Reset() noexcept { *this = LevelCounters(); }
+
+  void SaveState(SnapshotWriter& out) const {
+    out.Value(hits_);
+    out.Value(misses_);
+    out.Value(evictions_);
+    out.Value(writebacks_);
+    out.Value(latency_);
+    out.Value(prefetches_);
+    out.Value(prefetch_hits_);
+    out.Value(prefetch_unused_);
+    out.Value(back_invalidations_);
+  }
+
+  void LoadState(SnapshotReader& in) {
+    in.Value(hits_);
+    in.Value(misses_);
+    in.Value(evictions_);
+    in.Value(writebacks_);
+    in.Value(latency_);
+    in.Value(prefetches_);
+    in.Value(prefetch_hits_);
+    in.Value(prefetch_unused_);
+    in.Value(back_invalidations_);
+  }
+};
+
+template <>
+class LevelCounters<false> {
+ public:
+  static constexpr bool kEnabled = false;
+
+  void Hit() noexcept {}
+  void Miss() noexcept {}
+  void Eviction() noexcept {}
+  void Writeback() noexcept {}
+  void Latency(uint64_t) noexcept {}
+  void Prefetch() noexcept {}
+  void PrefetchHit() noexcept {}
+  void PrefetchUnused() noexcept {}
+  void BackInvalidation() noexcept {}
+  [[nodiscard]] LevelStats Stats(std::string_view name) const {
+    LevelStats s{};
+    s.name = name;
+    return s;
+  }
+  void Reset() noexcept {}
+  void SaveState(SnapshotWriter&) const {}
+  void LoadState(SnapshotReader&) {}
+};
+
+// Stats of every Cache level of `system`, top to bottom.
+template <typename CacheSystem>
+std::vector<LevelStats> CollectLevelStats(const CacheSystem& system) {
+  std::vector<LevelStats> stats;
+  system.ForEachLevel(
+      [&](const auto& level) { stats.push_back(level.Stats()); });
+  return stats;
+}
+
+enum class StatsDumpFormat { kCsv, kJson };
+
+// Writes the per-level counters of `system` accumulated over each interval
+// of `interval` accesses, so phase behavior is visible without keeping any
+// per-access history. CSV gets one row per level per interval; JSON gets
+// one object per interval per line (JSON Lines).
+//
+// Example:
+//   IntervalStatsDumper dump(*cache, file, 100'000, StatsDumpFormat::kCsv);
+//   ReplayTrace(reader, *cache, [&](const TraceOp&, const AccessResult&) {
+//     dump.Tick();
+//   });
+//   dump.Finish();
+template <typename CacheSystem>
+class IntervalStatsDumper {
+  const CacheSystem& system_;
+  std::FILE* out_;
+  uint64_t interval_;
+  StatsDumpFormat format_;
+  uint64_t accesses_ = 0;
+  uint64_t dumped_at_ = 0;
+  std::vector<LevelStats> last_;
+
+ public:
+  IntervalStatsDumper(const CacheSystem& system, std::FILE* out,
+                      uint64_t interval,
+                      StatsDumpFormat format = StatsDumpFormat::kCsv)
+      : system_(system),
+        out_(out),
+        interval_(interval == 0 ? 1 : interval),
+        format_(format),
+        last_(CollectLevelStats(system)) {
+    if (format_ == StatsDumpFormat::kCsv) {
+      fmt::print(out_,
+                 "accesses,level,hits,misses,evictions,writebacks,"
+                 "mean_latency\n");
+    }
+  }
+
+  // Call once per access, after it was simulated.
+  void Tick() {
+    if (++accesses_ - dumped_at_ == interval_) Dump();
+  }
+
+  // Dumps the final, partial interval (if any).
+  void Finish() {
+    if (accesses_ != dumped_at_) Dump();
+  }
+
+ private:
+  void Dump() {
+    auto now = CollectLevelStats(system_);
+    if (format_ == StatsDumpFormat::kJson) {
+      fmt::print(out_, "{{\"accesses\":{},\"levels\":[", accesses_);
+    }
+    for (size_t i = 0; i < now.size(); ++i) {
+      const LevelStats d = now[i].Since(last_[i]);
+      if (format_ == StatsDumpFormat::kCsv) {
+        fmt::print(out_, "{},{},{},{},{},{},{:.3f}\n", accesses_, d.name,
+                   d.hits, d.misses, d.evictions, d.writebacks,
+                   d.latency.Mean());
+      } else {
+        fmt::print(out_,
+                   "{}{{\"name\":\"{}\",\"hits\":{},\"misses\":{},"
+                   "\"evictions\":{},\"writebacks\":{},"
+                   "\"mean_latency\":{:.3f}}}",
+                   i == 0 ? "" : ",", d.name, d.hits, d.misses, d.evictions,
+                   d.writebacks, d.latency.Mean());
+      }
+    }
+    if (format_ == StatsDumpFormat::kJson) fmt::print(out_, "]}}\n");
+    last_ = std::move(now);
+    dumped_at_ = accesses_;
+  }
+};
+
+}  // namespace stratum
+
+#endif  // INSTRUMENTATION_HPP
@@ -0,0 +1,91 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef LEVEL_POLICIES_HPP
+#define LEVEL_POLICIES_HPP
+
+#include <string_view>
+
+namespace stratum {
+
+// Write and inclusion policies of one Cache level: the last two Cache
+// template parameters. Each is a tag type of compile-time flags, so a
+// level pays only for the behavior it selects.
+
+// ----------------------------------------------------------------------------
+// Write policies
+// ----------------------------------------------------------------------------
+//
+//   kWriteThrough    stores update the line and are also sent to the next
+//                    level at once (posted: the store's latency is still
+//                    this level's). Lines are never dirty.
+//   kWriteAllocate   a store miss fetches the block and fills it; without
+//                    it the store is sent to the next level instead and
+//                    nothing is filled.
+
+// Default: write-back, write-allocate.
+struct WriteBackPolicy {
+  static constexpr std::string_view kName{"wb-wa"};
+  static constexpr bool kWriteThrough = false;
+  static constexpr bool kWriteAllocate = true;
+};
+
+struct WriteBackNoAllocatePolicy {
+  static constexpr std::string_view kName{"wb-nwa"};
+  static constexpr bool kWriteThrough = false;
+  static constexpr bool kWriteAllocate = false;
+};
+
+struct WriteThroughPolicy {
+  static constexpr std::string_view kName{"wt-wa"};
+  static constexpr bool kWriteThrough = true;
+  static constexpr bool kWriteAllocate = true;
+};
+
+struct WriteThroughNoAllocatePolicy {
+  static constexpr std::string_view kName{"wt-nwa"};
+  static constexpr bool kWriteThrough = true;
+  static constexpr bool kWriteAllocate = false;
+};
+
+// ----------------------------------------------------------------------------
+// Inclusion policies
+// ----------------------------------------------------------------------------
+//
+// The policy of a level describes its contents relative to the levels
+// above it.
+//
+//   NonInclusivePolicy  (default, NINE) fills on every miss and never
+//                       touches the levels above.
+//   InclusivePolicy     also fills on every miss; evicting a block
+//                       back-invalidates it in every level above, whose
+//                       dirty data is written back with the victim.
+//   ExclusivePolicy     a victim cache of the level directly above: a hit
+//                       moves the line up (dropping it here, dirty state
+//                       included), a miss is not filled here, and the level
+//                       above sends it every victim, clean or dirty.
+//                       Stores from above (write-through or no-allocate
+//                       levels) are never allocated here. Prefetch fills
+//                       from above skip it; a block already here stays, so
+//                       a prefetched line can briefly be in both levels.
+
+struct NonInclusivePolicy {
+  static constexpr std::string_view kName{"nine"};
+  static constexpr bool kInclusive = false;
+  static constexpr bool kExclusive = false;
+};
+
+struct InclusivePolicy {
+  static constexpr std::string_view kName{"inclusive"};
+  static constexpr bool kInclusive = true;
+  static constexpr bool kExclusive = false;
+};
+
+struct ExclusivePolicy {
+  static constexpr std::string_view kName{"exclusive"};
+  static constexpr bool kInclusive = false;
+  static constexpr bool kExclusive = true;
+};
+
+}  // namespace stratum
+
+#endif  // LEVEL_POLICIES_HPP
@@ -0,0 +1,78 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace stratum {
+
+// Read-only memory mapping of a whole file (RAII).
+//
+// The file is mapped once and scanned in place; the kernel pages it in on
+// demand, so even multi-GB traces cost only the pages currently in use.
+class MappedFile {
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+
+ public:
+  explicit MappedFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      fmt::print(stderr, "Error: Could not open trace file {}\n", filename);
+      return;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      fmt::print(stderr, "Error: Could not stat trace file {}\n", filename);
+      ::close(fd);
+      return;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+      void* ptr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptr == MAP_FAILED) {
+        fmt::print(stderr, "Error: Could not map trace file {}\n", filename);
+        ::close(fd);
+        size_ = 0;
+        return;
+      }
+      // Traces are consumed front to back; let the kernel read ahead.
+      ::madvise(ptr, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(ptr);
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+    open_ = true;
+  }
+
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  [[nodiscard]] bool IsOpen() const { return open_; }
+  [[nodiscard]] const char* Data() const { return data_; }
+  [[nodiscard]] size_t Size() const { return size_; }
+  [[nodiscard]] std::string_view View() const { return {data_, size_}; }
+};
+
+}  // namespace stratum
+
+#endif  // MAPPED_FILE_HPP
@@ -0,0 +1,711 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef MULTICORE_HPP
+#define MULTICORE_HPP
+
+#include <fmt/core.h>
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/cache_sim.hpp"
+#include "stratum/coherence.hpp"
+#include "stratum/mapped_file.hpp"
+#include "stratum/parallel.hpp"
+#include "stratum/trace_parser.hpp"
+
+namespace stratum {
+
+// ============================================================================
+// Multi-core topologies: private upper levels over one shared hierarchy
+// ============================================================================
+// A core's private stack is an ordinary Cache chain whose bottom is
+// SharedLevel<Shared>, e.g. per-core L1/L2 over one L3:
+//
+//   using L3 = Cache<"L3", MainMemory<>, 8192, 16, 64, LRUPolicy, 64>;
+//   using Core = Cache<"L1", Cache<"L2", SharedLevel<L3>, 512, 8, 64,
+//                                  LRUPolicy, 12>,
+//                      64, 8, 64, LRUPolicy, 4>;
+//   MultiCoreSystem<Core> system(/*cores=*/4);
+//
+// Without a coherence directory (the default), private levels never see
+// each other's traffic, so a private stack evolves from its own core's
+// accesses alone. Only the
+// shared hierarchy depends on how the cores interleave. MultiCoreSystem
+// uses that to simulate the private stacks of a batch of interleaved
+// accesses on separate threads, each recording the requests its bottom
+// level sends down, and then replays those requests into the shared
+// hierarchy serially in interleaved order. The results are identical to
+// simulating the accesses one by one. MultiCoreSystem<Core, DirectoryFor<L3>>
+// adds MSI/MESI coherence (coherence.hpp) and simulates serially.
+
+namespace detail {
+
+// Lower::Next, or void for a last level such as MainMemory.
+template <typename Lower>
+struct LevelNext {
+  using type = void;
+};
+
+template <typename Lower>
+  requires requires { typename Lower::Next; }
+struct LevelNext<Lower> {
+  using type = typename Lower::Next;
+};
+
+}  // namespace detail
+
+// Whether Lower can be shared below private stacks. The exclusive protocol
+// (InsertVictim, TakeMovedDirty) and inclusive back-invalidations couple a
+// level to the one above it in a single chain, and a shared hierarchy has no
+// single level above it, so Lower must be non-inclusive non-exclusive and
+// have no inclusive level below it. Policies within the shared hierarchy
+// are otherwise free: an exclusive L4 below a NINE L3 stays inside it.
+template <typename Lower>
+inline constexpr bool kSharableLevel =
+    !requires { requires Lower::kExclusiveLevel; } &&
+    !requires { requires Lower::kNotifiesUpper; };
+
+// Bottom of a private stack that forwards to a hierarchy shared with other
+// stacks (not owned). Topology traits are those of the shared hierarchy, so
+// HierarchyInfo and reports see the full path down to memory.
+template <typename Lower>
+class SharedLevel {
+  static_assert(kSharableLevel<Lower>,
+                "SharedLevel: the shared level must be non-inclusive "
+                "non-exclusive and have no inclusive level below it");
+
+  Lower* shared_;
+
+ public:
+  using Shared = Lower;
+  using Next = typename detail::LevelNext<Lower>::type;
+  static constexpr std::string_view kName = Lower::kName;
+  static constexpr size_t kLevels = Lower::kLevels;
+  static constexpr LevelInfo kInfo = Lower::kInfo;
+
+  explicit SharedLevel(Lower& shared) : shared_(&shared) {}
+
+  AccessResult Load(uint64_t addr) { return shared_->Load(addr); }
+  AccessResult Store(uint64_t addr) { return shared_->Store(addr); }
+
+  AccessResult Writeback(uint64_t addr) {
+    if constexpr (requires { shared_->Writeback(addr); }) {
+      return shared_->Writeback(addr);
+    } else {
+      return shared_->Store(addr);
+    }
+  }
+
+  void PrefetchFill(uint64_t addr) {
+    if constexpr (requires { shared_->PrefetchFill(addr); }) {
+      shared_->PrefetchFill(addr);
+    }
+  }
+
+  // The shared state belongs to its owner, not to any one private stack.
+  static constexpr uint64_t Signature() {
+    return SignatureMix(Lower::Signature(), "shared");
+  }
+  void Reset() {}
+  void SaveState(SnapshotWriter&) const {}
+  void LoadState(SnapshotReader&) {}
+};
+
+// A request a private stack sent to the shared hierarchy.
+struct SharedRequest {
+  enum class Kind : uint8_t { kLoad, kStore, kWriteback, kPrefetch };
+  uint64_t addr;
+  Kind kind;
+};
+
+// Stand-in for SharedLevel<Lower> that only logs the requests; each one
+// completes in 0 cycles at hit level 0 (see MultiCoreSystem).
+template <typename Lower>
+class SharedRequestRecorder {
+  static_assert(kSharableLevel<Lower>,
+                "SharedRequestRecorder: the shared level must be "
+                "non-inclusive non-exclusive and have no inclusive level "
+                "below it");
+
+  std::vector<SharedRequest>* log_;
+
+ public:
+  using Shared = Lower;
+  using Next = typename detail::LevelNext<Lower>::type;
+  static constexpr std::string_view kName = Lower::kName;
+  static constexpr size_t kLevels = Lower::kLevels;
+  static constexpr LevelInfo kInfo = Lower::kInfo;
+
+  explicit SharedRequestRecorder(std::vector<SharedRequest>& log)
+      : log_(&log) {}
+
+  AccessResult Load(uint64_t addr) {
+    return Record(addr, SharedRequest::Kind::kLoad);
+  }
+  AccessResult Store(uint64_t addr) {
+    return Record(addr, SharedRequest::Kind::kStore);
+  }
+  AccessResult Writeback(uint64_t addr) {
+    return Record(addr, SharedRequest::Kind::kWriteback);
+  }
+  void PrefetchFill(uint64_t addr) {
+    Record(addr, SharedRequest::Kind::kPrefetch);
+  }
+
+  static constexpr uint64_t Signature() {
+    return SignatureMix(Lower::Signature(), "shared");
+  }
+  void Reset() {}
+  void SaveState(SnapshotWriter&) const {}
+  void LoadState(SnapshotReader&) {}
+
+ private:
+  AccessResult Record(uint64_t addr, SharedRequest::Kind kind) {
+    log_->push_back({addr, kind});
+    return {0, 0};
+  }
+};
+
+namespace detail {
+
+// The last layer of a Cache chain.
+template <typename Level>
+struct ChainBottom {
+  using type = Level;
+};
+
+template <typename Level>
+  requires requires { typename Level::template Rebind<Level>; }
+struct ChainBottom<Level> {
+  using type = typename ChainBottom<typename Level::Next>::type;
+};
+
+// `Level` with the last layer of its chain replaced by `Bottom`.
+template <typename Level, typename Bottom>
+struct RebindBottom {
+  using type = Bottom;
+};
+
+template <typename Level, typename Bottom>
+  requires requires { typename Level::template Rebind<Bottom>; }
+struct RebindBottom<Level, Bottom> {
+  using type = typename Level::template Rebind<
+      typename RebindBottom<typename Level::Next, Bottom>::type>;
+};
+
+// True if the first `Levels` levels of `Private` use blocks of
+// `BlockSize` bytes.
+template <typename Private, size_t Levels>
+constexpr bool PrivateBlockSizeIs(size_t block_size) {
+  constexpr auto info = HierarchyInfo<Private>();
+  for (size_t i = 0; i < Levels; ++i) {
+    if (info[i].block_size != block_size) return false;
+  }
+  return true;
+}
+
+}  // namespace detail
+
+// One access of an interleaved multi-core trace.
+struct CoreTraceOp {
+  TraceOp op;
+  uint32_t core;
+};
+
+// Accesses simulated per parallel step of MultiCoreSystem::AccessBatch.
+inline constexpr size_t kMultiCoreEpoch = size_t{1} << 16;
+
+// `cores` copies of the private stack `Private` (a Cache chain ending in
+// SharedLevel<Shared>) over one Shared hierarchy, all owned here.
+//
+// With a `Directory` (e.g. DirectoryFor<Shared>, see coherence.hpp) the
+// private stacks are kept coherent. Coherence couples them (one core's store
+// invalidates another's copy), so AccessBatch then simulates accesses one
+// at a time. Every private level must use the directory's block size.
+template <typename Private, typename Directory = NoCoherence>
+class MultiCoreSystem {
+ public:
+  using Shared = typename detail::ChainBottom<Private>::type::Shared;
+  using CoreStack = typename detail::RebindBottom<
+      Private, SharedRequestRecorder<Shared>>::type;
+
+  // Levels a core sees, private ones first; the same as Private::kLevels.
+  static constexpr size_t kLevels = Private::kLevels;
+  static constexpr size_t kPrivateLevels = kLevels - Shared::kLevels;
+  static_assert(!Directory::kEnabled ||
+                    detail::PrivateBlockSizeIs<Private, kPrivateLevels>(
+                        Directory::kBlockSize),
+                "Private levels must use the directory's block size");
+
+ private:
+  std::unique_ptr<Shared> shared_;
+  [[no_unique_address]] Directory directory_;
+  std::vector<std::vector<SharedRequest>> logs_;
+  std::vector<std::unique_ptr<CoreStack>> cores_;
+
+  // Scratch space of AccessBatch, kept across calls.
+  std::vector<std::vector<uint32_t>> core_ops_;
+  std::vector<AccessResult> private_results_;
+  std::vector<uint32_t> request_end_;
+
+ public:
+  explicit MultiCoreSystem(size_t cores, size_t mem_latency = 100)
+      : shared_(std::make_unique<Shared>(mem_latency)),
+        logs_(cores),
+        core_ops_(cores) {
+    if constexpr (Directory::kEnabled) {
+      if (cores > Directory::kMaxCores) {
+        throw std::invalid_argument("too many cores for the directory");
+      }
+    }
+    cores_.reserve(cores);
+    for (size_t c = 0; c < cores; ++c) {
+      cores_.push_back(std::make_unique<CoreStack>(logs_[c]));
+    }
+  }
+
+  [[nodiscard]] size_t Cores() const { return cores_.size(); }
+  [[nodiscard]] const CoreStack& Core(size_t core) const {
+    return *cores_[core];
+  }
+  [[nodiscard]] const Shared& SharedLevels() const { return *shared_; }
+  [[nodiscard]] const Directory& Coherence() const { return directory_; }
+
+  AccessResult Load(size_t core, uint64_t addr) {
+    return Access(core, {'L', addr});
+  }
+  AccessResult Store(size_t core, uint64_t addr) {
+    return Access(core, {'S', addr});
+  }
+
+  AccessResult Access(size_t core, const TraceOp& op) {
+    std::vector<SharedRequest>& log = logs_[core];
+    log.clear();
+    const AccessResult res = op.type == 'L' ? cores_[core]->Load(op.addr)
+                                            : cores_[core]->Store(op.addr);
+    return Complete(core, op, res, log.data(), log.data() + log.size());
+  }
+
+  // Simulates `ops` in order, writing results[i] for ops[i]
+  // (results.size() >= ops.size()). The private stacks of each epoch of
+  // kMultiCoreEpoch accesses run on up to `threads` workers (0 = one per
+  // hardware thread); the shared hierarchy then replays their requests in
+  // the order of `ops`. Identical to calling Access in a loop, which is
+  // what it does with a directory.
+  void AccessBatch(std::span<const CoreTraceOp> ops,
+                   std::span<AccessResult> results, size_t threads = 0) {
+    if constexpr (Directory::kEnabled) {
+      for (size_t i = 0; i < ops.size(); ++i) {
+        results[i] = Access(ops[i].core, ops[i].op);
+      }
+      return;
+    }
+    for (size_t begin = 0; begin < ops.size(); begin += kMultiCoreEpoch) {
+      const size_t n = std::min(kMultiCoreEpoch, ops.size() - begin);
+      RunEpoch(ops.subspan(begin, n), results.subspan(begin, n), threads);
+    }
+  }
+
+  void Reset() {
+    for (auto& core : cores_) core->Reset();
+    shared_->Reset();
+    if constexpr (Directory::kEnabled) directory_.Reset();
+  }
+
+ private:
+  void RunEpoch(std::span<const CoreTraceOp> ops,
+                std::span<AccessResult> results, size_t threads) {
+    for (auto& list : core_ops_) list.clear();
+    for (size_t i = 0; i < ops.size(); ++i) {
+      core_ops_[ops[i].core].push_back(static_cast<uint32_t>(i));
+    }
+    private_results_.resize(ops.size());
+    request_end_.resize(ops.size());
+
+    // 1. Private stacks, one core per task: each touches only its own
+    //    stack, log and slots of the scratch arrays.
+    ParallelFor(cores_.size(), threads, [&](size_t c) {
+      std::vector<SharedRequest>& log = logs_[c];
+      log.clear();
+      for (const uint32_t i : core_ops_[c]) {
+        const TraceOp& op = ops[i].op;
+        private_results_[i] = op.type == 'L' ? cores_[c]->Load(op.addr)
+                                             : cores_[c]->Store(op.addr);
+        request_end_[i] = static_cast<uint32_t>(log.size());
+      }
+    });
+
+    // 2. Shared hierarchy, in interleaved order.
+    std::vector<size_t> cursor(cores_.size(), 0);
+    for (size_t i = 0; i < ops.size(); ++i) {
+      const size_t c = ops[i].core;
+      const SharedRequest* log = logs_[c].data();
+      results[i] = Complete(c, ops[i].op, private_results_[i],
+                            log + cursor[c], log + request_end_[i]);
+      cursor[c] = request_end_[i];
+    }
+  }
+
+  // Replays the requests core `core`'s access `op` made and adds the
+  // shared result to it if the access missed every private level. That
+  // demand fetch is always the first request: writebacks and prefetches
+  // come after the fill that triggers them.
+  AccessResult Complete(size_t core, const TraceOp& op, AccessResult res,
+                        const SharedRequest* begin,
+                        const SharedRequest* end) {
+    const bool fetched = res.hit_level == kPrivateLevels;
+    if constexpr (Directory::kEnabled) {
+      if (op.type != 'L' && !fetched &&
+          !directory_.OwnsForWrite(core, op.addr)) {
+        directory_.Write(core, op.addr, false, ProbeFor());
+      }
+    }
+    for (const SharedRequest* r = begin; r != end; ++r) {
+      if constexpr (Directory::kEnabled) {
+        Register(core, op, fetched, *r, r == begin);
+      }
+      const AccessResult shared = Forward(*r);
+      if (r == begin && fetched) {
+        res.hit_level += shared.hit_level;
+        res.total_cycles += shared.total_cycles;
+      }
+    }
+    return res;
+  }
+
+  // Records in the directory that `core` is bringing a block in, before
+  // the request reaches the shared hierarchy.
+  void Register(size_t core, const TraceOp& op, bool fetched,
+                const SharedRequest& r, bool first) {
+    using Kind = SharedRequest::Kind;
+    if (r.kind != Kind::kLoad && r.kind != Kind::kPrefetch) return;
+    const bool demand = first && fetched;
+    if (demand && op.type != 'L') {
+      directory_.Write(core, r.addr, true, ProbeFor());
+    } else {
+      directory_.Read(core, r.addr, demand, ProbeFor());
+    }
+  }
+
+  // Probe callback for the directory: invalidates or cleans a core's copy
+  // and writes flushed dirty data into the shared hierarchy.
+  auto ProbeFor() {
+    return [this](size_t core, uint64_t addr, bool drop) {
+      const ProbeResult res =
+          drop ? cores_[core]->Invalidate(addr) : cores_[core]->Clean(addr);
+      if (res.dirty) SharedLevel<Shared>(*shared_).Writeback(addr);
+      return res;
+    };
+  }
+
+  AccessResult Forward(const SharedRequest& r) {
+    SharedLevel<Shared> shared(*shared_);
+    switch (r.kind) {
+      case SharedRequest::Kind::kLoad:
+        return shared.Load(r.addr);
+      case SharedRequest::Kind::kStore:
+        return shared.Store(r.addr);
+      case SharedRequest::Kind::kWriteback:
+        return shared.Writeback(r.addr);
+      case SharedRequest::Kind::kPrefetch:
+        shared.PrefetchFill(r.addr);
+        break;
+    }
+    return {0, 0};
+  }
+};
+
+// ----------------------------------------------------------------------------
+// Per-core trace streams
+// ----------------------------------------------------------------------------
+
+// Text or binary trace file (detected by magic) behind one ReadBatch.
+class CoreTraceReader {
+  std::optional<MappedTraceReader> text_;
+  std::optional<BinaryTraceReader> binary_;
+
+ public:
+  explicit CoreTraceReader(const std::string& path) {
+    if (IsBinaryTraceFile(path)) {
+      binary_.emplace(path);
+    } else {
+      text_.emplace(path);
+    }
+  }
+
+  [[nodiscard]] bool IsOpen() const {
+    return binary_ ? binary_->IsOpen() : text_->IsOpen();
+  }
+
+  size_t ReadBatch(std::vector<TraceOp>& batch,
+                   size_t max_ops = kTraceBatchSize) {
+    return binary_ ? binary_->ReadBatch(batch, max_ops)
+                   : text_->ReadBatch(batch, max_ops);
+  }
+};
+
+// Interleaves per-core traces by taking `quantum` operations from each
+// core in turn; cores whose trace has ended drop out.
+template <typename Reader = CoreTraceReader>
+class RoundRobinInterleaver {
+  struct Stream {
+    std::unique_ptr<Reader> reader;
+    std::vector<TraceOp> buffer;
+    size_t pos = 0;
+    bool done = false;
+  };
+
+  std::vector<Stream> streams_;
+  size_t quantum_;
+  size_t core_ = 0;
+  size_t taken_ = 0;  // ops taken from core_ in the current turn
+
+ public:
+  explicit RoundRobinInterleaver(std::vector<std::unique_ptr<Reader>> readers,
+                                 size_t quantum = 1)
+      : quantum_(quantum == 0 ? 1 : quantum) {
+    streams_.resize(readers.size());
+    for (size_t c = 0; c < readers.size(); ++c) {
+      streams_[c].reader = std::move(readers[c]);
+    }
+  }
+
+  [[nodiscard]] size_t Cores() const { return streams_.size(); }
+
+  // Replaces the contents of `batch` with up to `max_ops` operations.
+  // Returns the number of operations read; 0 means every trace has ended.
+  size_t ReadBatch(std::vector<CoreTraceOp>& batch,
+                   size_t max_ops = kTraceBatchSize) {
+    batch.clear();
+    size_t idle = 0;  // consecutive cores found exhausted
+    while (batch.size() < max_ops && idle < streams_.size()) {
+      Stream& s = streams_[core_];
+      if (s.pos == s.buffer.size() && !s.done) {
+        s.pos = 0;
+        s.done = s.reader->ReadBatch(s.buffer) == 0;
+      }
+      if (s.done) {
+        idle++;
+        NextCore();
+        continue;
+      }
+      idle = 0;
+      batch.push_back({s.buffer[s.pos++], static_cast<uint32_t>(core_)});
+      if (++taken_ == quantum_) NextCore();
+    }
+    return batch.size();
+  }
+
+ private:
+  void NextCore() {
+    core_ = (core_ + 1) % streams_.size();
+    taken_ = 0;
+  }
+};
+
+// An operation with the time it was issued (any monotonic unit).
+struct TimedTraceOp {
+  TraceOp op;
+  uint64_t timestamp;
+};
+
+// Text trace with a decimal timestamp after the address on every line
+// ("L 0x1000 1234"), e.g. per-thread logs annotated with a cycle or
+// nanosecond counter. A line without one repeats the previous timestamp.
+class TimestampedTraceReader {
+  MappedFile file_;
+  const char* cursor_;
+  const char* end_;
+  uint64_t last_ = 0;
+
+ public:
+  explicit TimestampedTraceReader(const std::string& filename)
+      : file_(filename),
+        cursor_(file_.Data()),
+        end_(file_.Data() + file_.Size()) {}
+
+  [[nodiscard]] bool IsOpen() const { return file_.IsOpen(); }
+
+  size_t ReadBatch(std::vector<TimedTraceOp>& batch,
+                   size_t max_ops = kTraceBatchSize) {
+    batch.clear();
+    TraceOp op;
+    std::string_view rest;
+    while (batch.size() < max_ops && NextTraceOp(cursor_, end_, op, rest)) {
+      const char* p = rest.data();
+      const char* end = p + rest.size();
+      while (p < end && detail::IsBlank(*p)) ++p;
+      std::from_chars(p, end, last_);
+      batch.push_back({op, last_});
+    }
+    return batch.size();
+  }
+};
+
+// Interleaves timestamped per-core traces in timestamp order (ties go to
+// the lower core), a k-way merge over one buffered batch per core.
+class TimestampInterleaver {
+  struct Stream {
+    std::unique_ptr<TimestampedTraceReader> reader;
+    std::vector<TimedTraceOp> buffer;
+    size_t pos = 0;
+  };
+  using Head = std::pair<uint64_t, uint32_t>;  // (timestamp, core)
+
+  std::vector<Stream> streams_;
+  std::priority_queue<Head, std::vector<Head>, std::greater<>> heads_;
+
+ public:
+  explicit TimestampInterleaver(
+      std::vector<std::unique_ptr<TimestampedTraceReader>> readers) {
+    streams_.resize(readers.size());
+    for (size_t c = 0; c < readers.size(); ++c) {
+      streams_[c].reader = std::move(readers[c]);
+    }
+    for (uint32_t c = 0; c < streams_.size(); ++c) Refill(c);
+  }
+
+  [[nodiscard]] size_t Cores() const { return streams_.size(); }
+
+  size_t ReadBatch(std::vector<CoreTraceOp>& batch,
+                   size_t max_ops = kTraceBatchSize) {
+    batch.clear();
+    while (batch.size() < max_ops && !heads_.empty()) {
+      const uint32_t c = heads_.top().second;
+      heads_.pop();
+      Stream& s = streams_[c];
+      batch.push_back({s.buffer[s.pos++].op, c});
+      Refill(c);
+    }
+    return batch.size();
+  }
+
+ private:
+  // Queues the next operation of core `c`, reading a batch if needed.
+  void Refill(uint32_t c) {
+    Stream& s = streams_[c];
+    if (s.pos == s.buffer.size()) {
+      s.pos = 0;
+      if (s.reader->ReadBatch(s.buffer) == 0) return;
+    }
+    heads_.push({s.buffer[s.pos].timestamp, c});
+  }
+};
+
+// ----------------------------------------------------------------------------
+// Driver
+// ----------------------------------------------------------------------------
+
+enum class InterleavePolicy { kRoundRobin, kTimestamp };
+
+// Statistics of a multi-core run, per core and over all cores.
+template <size_t Levels>
+struct MultiCoreRun {
+  std::vector<SimulationStats<Levels>> cores;
+  SimulationStats<Levels> total;
+};
+
+// Simulates every operation of `interleaver` through `system`.
+template <typename Private, typename Directory, typename Interleaver>
+MultiCoreRun<Private::kLevels> SimulateMultiCore(
+    Interleaver& interleaver, MultiCoreSystem<Private, Directory>& system,
+    size_t threads = 0) {
+  MultiCoreRun<Private::kLevels> run;
+  run.cores.resize(system.Cores());
+  std::vector<CoreTraceOp> batch;
+  std::vector<AccessResult> results;
+  while (interleaver.ReadBatch(batch, kMultiCoreEpoch) > 0) {
+    results.resize(batch.size());
+    system.AccessBatch(batch, results, threads);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      run.cores[batch[i].core].Record(batch[i].op, results[i]);
+    }
+  }
+  for (const auto& core : run.cores) run.total.Merge(core);
+  return run;
+}
+
+template <size_t Levels, typename Shared>
+void PrintMultiCoreReport(const MultiCoreRun<Levels>& run,
+                          const std::array<std::string_view, Levels>& names,
+                          const Shared& shared) {
+  for (size_t c = 0; c < run.cores.size(); ++c) {
+    fmt::print("\n--- Core {} ---", c);
+    run.cores[c].Print(names);
+  }
+  fmt::print("\n--- All {} cores ---", run.cores.size());
+  run.total.Print(names);
+  run.total.PrintLatencyDistribution(names);
+  if constexpr (kInstrumentation && requires { shared.PrintAllStats(); }) {
+    fmt::print("\n=== Shared Levels ===\n");
+    shared.PrintAllStats();
+  }
+}
+
+// Runs one trace per core through MultiCoreSystem<Private, Directory> and
+// prints the per-core and combined reports (and coherence events).
+// Round-robin interleaving takes `quantum` operations per turn from text
+// or binary traces (e.g. per-thread lackey logs converted with
+// stratum_convert); timestamp interleaving reads TimestampedTraceReader
+// files.
+//
+// Example:
+//   RunMultiCoreSimulation<CoreType>("Service", {"t0.bin", "t1.bin"},
+//                                    InterleavePolicy::kRoundRobin);
+template <typename Private, typename Directory = NoCoherence>
+void RunMultiCoreSimulation(
+    const std::string& name, const std::vector<std::string>& paths,
+    InterleavePolicy policy = InterleavePolicy::kRoundRobin,
+    size_t quantum = 1, size_t threads = 0, size_t mem_latency = 100) {
+  fmt::print("\n=========================================================\n");
+  fmt::print("Running Multi-Core Simulation: {} ({} cores, {})\n", name,
+             paths.size(),
+             policy == InterleavePolicy::kRoundRobin ? "round-robin"
+                                                     : "by timestamp");
+  fmt::print("=========================================================\n");
+
+  MultiCoreSystem<Private, Directory> system(paths.size(), mem_latency);
+  auto report = [&](auto& interleaver) {
+    const auto run = SimulateMultiCore(interleaver, system, threads);
+    PrintMultiCoreReport(run, HierarchyNames<Private>(),
+                         system.SharedLevels());
+    if constexpr (Directory::kEnabled) {
+      PrintCoherenceStats(system.Coherence().Stats());
+    }
+  };
+
+  if (policy == InterleavePolicy::kRoundRobin) {
+    std::vector<std::unique_ptr<CoreTraceReader>> readers;
+    for (const auto& path : paths) {
+      readers.push_back(std::make_unique<CoreTraceReader>(path));
+      if (!readers.back()->IsOpen()) return;
+    }
+    RoundRobinInterleaver<> interleaver(std::move(readers), quantum);
+    report(interleaver);
+  } else {
+    std::vector<std::unique_ptr<TimestampedTraceReader>> readers;
+    for (const auto& path : paths) {
+      readers.push_back(std::make_unique<TimestampedTraceReader>(path));
+      if (!readers.back()->IsOpen()) return;
+    }
+    TimestampInterleaver interleaver(std::move(readers));
+    report(interleaver);
+  }
+}
+
+}  // namespace stratum
+
+#endif  // MULTICORE_HPP
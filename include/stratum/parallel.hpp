@@ -0,0 +1,53 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace stratum {
+
+// Worker count used when a caller asks for 0 threads: one per hardware
+// thread, or 1 if the platform cannot tell.
+inline size_t DefaultThreadCount() {
+  const unsigned n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
+
+// Runs task(i) for every i in [0, count) on up to `threads` workers
+// (0 = DefaultThreadCount()) and returns once all of them have finished.
+//
+// Workers claim indices from one shared atomic counter, so long and short
+// tasks balance themselves without a queue. The calling thread is one of
+// the workers; `task` must be safe to call concurrently for distinct i.
+template <typename Task>
+void ParallelFor(size_t count, size_t threads, Task&& task) {
+  if (threads == 0) threads = DefaultThreadCount();
+  threads = std::min(threads, count);
+  if (threads <= 1) {
+    for (size_t i = 0; i < count; ++i) task(i);
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+         i = next.fetch_add(1, std::memory_order_relaxed)) {
+      task(i);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (size_t t = 1; t < threads; ++t) pool.emplace_back(worker);
+  worker();
+  for (auto& thread : pool) thread.join();
+}
+
+}  // namespace stratum
+
+#endif  // PARALLEL_HPP
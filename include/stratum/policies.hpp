@@ -3,30 +3,134 @@
 #ifndef POLICIES_HPP
 #define POLICIES_HPP
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <random>
-#include <vector>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "stratum/arena.hpp"
+#include "stratum/prefetch.hpp"
+#include "stratum/snapshot.hpp"
 
 namespace stratum {
 
+// Policy interface
+//
+//   static constexpr std::string_view kName;  // part of Cache::Signature
+//   void OnHit(size_t set, size_t way);    // demand hit
+//   void OnFill(size_t set, size_t way);   // line installed after a miss
+//   size_t GetVictim(size_t set);          // set is full, pick a way
+//   void OnMiss(size_t set);               // optional: demand miss observed
+//   void Prefetch(size_t set) const;       // optional: host-prefetch state
+//   void Reset();                          // back to the constructed state
+//   void SaveState(SnapshotWriter&) const; // see Cache::Snapshot
+//   void LoadState(SnapshotReader&);
+//
+// Storage
+//
+// A policy that declares
+//
+//   static constexpr size_t ArenaBytes(size_t sets, size_t ways);
+//   Policy(size_t sets, size_t ways, Arena* arena);
+//
+// has its per-set state placed in the hierarchy's single Arena (see
+// arena.hpp) and keeps using the heap when arena is null. Policies without
+// them are constructed with (sets, ways) and allocate for themselves.
+//
+// Reset/SaveState/LoadState are needed only by hierarchies that use
+// Cache::Reset, Snapshot or Restore. Cache calls the optional hooks only
+// when the policy declares them, so policies that do not need them pay
+// nothing. Prefetch should hint the host lines a following
+// OnHit/OnFill/GetVictim on `set` will touch (see Cache::AccessBatch);
+// declare it STRATUM_ALWAYS_INLINE (prefetch.hpp).
+//
+// A policy whose choices in one set depend on activity in other sets (a
+// shared RNG, counter or duel) declares `static constexpr bool kSetLocal =
+// false;`. Set-sharded simulation (sharded.hpp) is exact only for set-local
+// policies.
+//
+// Policy binding
+//
+// A policy is either a plain class constructed with (sets, ways), or a
+// family that exposes `template <size_t Ways> using ForWays = ...;` to get a
+// version specialized on the associativity. Cache instantiates
+// BoundPolicy<ReplacePolicy, Ways>, so both kinds are written the same way
+// in a Cache<...> declaration.
+template <typename Policy, size_t Ways>
+struct PolicyBinder {
+  using type = Policy;
+};
+
+template <typename Policy, size_t Ways>
+  requires requires { typename Policy::template ForWays<Ways>; }
+struct PolicyBinder<Policy, Ways> {
+  using type = typename Policy::template ForWays<Ways>;
+};
+
+template <typename Policy, size_t Ways>
+using BoundPolicy = typename PolicyBinder<Policy, Ways>::type;
+
+// True unless the policy opts out with kSetLocal = false.
+template <typename Policy>
+constexpr bool IsSetLocalPolicy() {
+  if constexpr (requires { Policy::kSetLocal; }) {
+    return Policy::kSetLocal;
+  } else {
+    return true;
+  }
+}
+
+// Arena bytes a policy asks for (0 for policies that allocate themselves).
+template <typename Policy>
+constexpr size_t PolicyArenaBytes(size_t sets, size_t ways) {
+  if constexpr (requires { Policy::ArenaBytes(sets, ways); }) {
+    return Policy::ArenaBytes(sets, ways);
+  } else {
+    return 0;
+  }
+}
+
+// Smallest unsigned integer holding `Bits` bits of per-set policy state.
+template <size_t Bits>
+using PackedState = std::conditional_t<
+    Bits <= 8, uint8_t,
+    std::conditional_t<Bits <= 16, uint16_t,
+                       std::conditional_t<Bits <= 32, uint32_t, uint64_t>>>;
+
 class LRUPolicy {
+ public:
+  static constexpr std::string_view kName{"lru"};
+
+ private:
   const size_t num_sets_;
   const size_t num_ways_;
 
   // Flattened timestamp array for cache locality
   // Layout: [Set0_Way0, Set0_Way1... | Set1_Way0, Set1_Way1...]
-  std::vector<uint64_t> timestamps_;
+  ArenaArray<uint64_t> timestamps_;
 
   // Logical clock per set (models hardware counter)
-  std::vector<uint64_t> set_counters_;
+  ArenaArray<uint64_t> set_counters_;
 
  public:
-  LRUPolicy(size_t sets, size_t ways)
+  static constexpr size_t ArenaBytes(size_t sets, size_t ways) {
+    return stratum::ArenaBytes<uint64_t>(sets * ways) +
+           stratum::ArenaBytes<uint64_t>(sets);
+  }
+
+  LRUPolicy(size_t sets, size_t ways, Arena* arena = nullptr)
       : num_sets_(sets),
         num_ways_(ways),
         // Pre-allocate all memory: size = sets * ways
-        timestamps_(sets * ways, 0),
-        set_counters_(sets, 0) {}
+        timestamps_(sets * ways, 0, arena),
+        set_counters_(sets, 0, arena) {}
 
   // Update timestamp on hit/fill
   void OnHit(size_t set_idx, size_t way_idx) noexcept {
@@ -42,6 +146,12 @@ class LRUPolicy {
     OnHit(set_idx, way_idx);
   }
 
+  STRATUM_ALWAYS_INLINE void Prefetch(size_t set_idx) const noexcept {
+    PrefetchRange(&timestamps_[set_idx * num_ways_],
+                  num_ways_ * sizeof(uint64_t));
+    PrefetchRange(&set_counters_[set_idx], sizeof(uint64_t));
+  }
+
   [[nodiscard]] size_t GetVictim(size_t set_idx) const noexcept {
     size_t victim_way = 0;
     uint64_t min_time = std::numeric_limits<uint64_t>::max();
@@ -58,19 +168,38 @@ class LRUPolicy {
     }
     return victim_way;
   }
+
+  void Reset() noexcept {
+    timestamps_.Fill(0);
+    set_counters_.Fill(0);
+  }
+
+  void SaveState(SnapshotWriter& out) const {
+    out.Array(timestamps_.data(), timestamps_.size());
+    out.Array(set_counters_.data(), set_counters_.size());
+  }
+
+  void LoadState(SnapshotReader& in) {
+    in.Array(timestamps_.data(), timestamps_.size());
+    in.Array(set_counters_.data(), set_counters_.size());
+  }
 };
 
 // 2. First-In, First-Out (FIFO)
 class FIFOPolicy {
   size_t num_sets_;
   size_t num_ways_;
-  std::vector<size_t> next_victim_;  // Circular buffer index per set
+  ArenaArray<size_t> next_victim_;  // Circular buffer index per set
 
  public:
-  FIFOPolicy(size_t sets, size_t ways) : num_sets_(sets), num_ways_(ways) {
-    next_victim_.resize(sets, 0);
+  static constexpr std::string_view kName{"fifo"};
+  static constexpr size_t ArenaBytes(size_t sets, size_t /*ways*/) {
+    return stratum::ArenaBytes<size_t>(sets);
   }
 
+  FIFOPolicy(size_t sets, size_t ways, Arena* arena = nullptr)
+      : num_sets_(sets), num_ways_(ways), next_victim_(sets, 0, arena) {}
+
   void OnHit(size_t, size_t) {
     // FIFO ignores hits
   }
@@ -80,7 +209,21 @@ class FIFOPolicy {
     next_victim_[set] = (next_victim_[set] + 1) % num_ways_;
   }
 
+  STRATUM_ALWAYS_INLINE void Prefetch(size_t set) const noexcept {
+    PrefetchRange(&next_victim_[set], sizeof(size_t));
+  }
+
   size_t GetVictim(size_t set) const { return next_victim_[set]; }
+
+  void Reset() noexcept { next_victim_.Fill(0); }
+
+  void SaveState(SnapshotWriter& out) const {
+    out.Array(next_victim_.data(), next_victim_.size());
+  }
+
+  void LoadState(SnapshotReader& in) {
+    in.Array(next_victim_.data(), next_victim_.size());
+  }
 };
 
 // 3. Random Policy
@@ -90,6 +233,9 @@ class RandomPolicy {
   mutable std::mt19937 search_rng_{std::random_device{}()};
 
  public:
+  static constexpr std::string_view kName{"random"};
+  static constexpr bool kSetLocal = false;  // one RNG stream for all sets
+
   RandomPolicy(size_t sets, size_t ways) : num_sets_(sets), num_ways_(ways) {}
 
   void OnHit(size_t, size_t) {}
@@ -99,6 +245,359 @@ class RandomPolicy {
     std::uniform_int_distribution<size_t> dist(0, num_ways_ - 1);
     return dist(search_rng_);
   }
+
+  void Reset() { search_rng_.seed(std::random_device{}()); }
+
+  // The engine state round-trips through its standard text form.
+  void SaveState(SnapshotWriter& out) const {
+    std::ostringstream os;
+    os << search_rng_;
+    out.String(os.str());
+  }
+
+  void LoadState(SnapshotReader& in) {
+    std::string state;
+    in.String(state);
+    if (!in.Ok()) return;
+    std::istringstream is(state);
+    is >> search_rng_;
+  }
+};
+
+// 4. Tree Pseudo-LRU
+//
+// Ways - 1 bits per set form a binary tree over the ways; each node points
+// to the half that was used less recently. A touch rewrites the nodes on the
+// way's root path with one precomputed mask (O(1)); victim selection follows
+// the pointers down from the root (O(log Ways)).
+template <size_t Ways>
+class TreePLRU {
+  static_assert(std::has_single_bit(Ways) && Ways <= 64,
+                "TreePLRU requires a power-of-two way count <= 64");
+
+  static constexpr size_t kLevels = std::bit_width(Ways) - 1;
+  using State = PackedState<(Ways > 1 ? Ways - 1 : 1)>;
+
+  // Node n (1-based heap order) lives in bit n - 1. For each way: the
+  // nodes on its root path, and their values pointing away from that way.
+  struct PathMasks {
+    std::array<State, Ways> mask{};
+    std::array<State, Ways> value{};
+  };
+
+  static constexpr PathMasks BuildPaths() {
+    PathMasks paths;
+    for (size_t way = 0; way < Ways; ++way) {
+      size_t node = 1;
+      for (size_t level = 0; level < kLevels; ++level) {
+        size_t dir = (way >> (kLevels - 1 - level)) & 1;
+        paths.mask[way] |= static_cast<State>(State{1} << (node - 1));
+        if (dir == 0) {
+          paths.value[way] |= static_cast<State>(State{1} << (node - 1));
+        }
+        node = 2 * node + dir;
+      }
+    }
+    return paths;
+  }
+
+  static constexpr PathMasks kPaths = BuildPaths();
+
+  ArenaArray<State> tree_;
+
+ public:
+  static constexpr size_t ArenaBytes(size_t sets, size_t /*ways*/) {
+    return stratum::ArenaBytes<State>(sets);
+  }
+
+  TreePLRU(size_t sets, size_t /*ways*/, Arena* arena = nullptr)
+      : tree_(sets, 0, arena) {}
+
+  void OnHit(size_t set_idx, size_t way_idx) noexcept {
+    State& t = tree_[set_idx];
+    t = static_cast<State>((t & ~kPaths.mask[way_idx]) |
+                           kPaths.value[way_idx]);
+  }
+
+  void OnFill(size_t set_idx, size_t way_idx) noexcept {
+    OnHit(set_idx, way_idx);
+  }
+
+  STRATUM_ALWAYS_INLINE void Prefetch(size_t set_idx) const noexcept {
+    PrefetchRange(&tree_[set_idx], sizeof(State));
+  }
+
+  [[nodiscard]] size_t GetVictim(size_t set_idx) const noexcept {
+    const State t = tree_[set_idx];
+    size_t node = 1;
+    for (size_t level = 0; level < kLevels; ++level) {
+      node = 2 * node + ((t >> (node - 1)) & 1);
+    }
+    return node - Ways;
+  }
+
+  void Reset() noexcept { tree_.Fill(0); }
+
+  void SaveState(SnapshotWriter& out) const {
+    out.Array(tree_.data(), tree_.size());
+  }
+
+  void LoadState(SnapshotReader& in) { in.Array(tree_.data(), tree_.size()); }
+};
+
+struct TreePLRUPolicy {
+  static constexpr std::string_view kName{"tree-plru"};
+  template <size_t Ways>
+  using ForWays = TreePLRU<Ways>;
+};
+
+// 5. Exact LRU with packed ages
+//
+// Each way has a 4-bit age (0 = MRU, Ways - 1 = LRU); the ages of a set form
+// a permutation packed into one word. Touch and victim search are branchless
+// SWAR operations on that word, O(1) regardless of associativity. Produces
+// the same victims as LRUPolicy at 1/16 of its state for 16 ways.
+template <size_t Ways>
+class PackedLRU {
+  static_assert(Ways >= 1 && Ways <= 16,
+                "PackedLRU holds at most 16 ways (4-bit ages); use LRUPolicy "
+                "for wider sets");
+
+  using State = PackedState<4 * Ways>;
+
+  static constexpr uint64_t kLowBytes = 0x0101010101010101ULL;
+  static constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+  static constexpr uint64_t kNibbles = 0x0F0F0F0F0F0F0F0FULL;
+
+  // Lane i starts at age i; unused lanes are pinned at 15 so they are never
+  // younger than a touched way and never equal to the LRU age (< 15 there).
+  static constexpr uint64_t InitialAges() {
+    uint64_t ages = 0;
+    for (size_t lane = 0; lane < 16; ++lane) {
+      ages |= uint64_t{lane < Ways ? lane : 15} << (4 * lane);
+    }
+    return ages;
+  }
+
+  static constexpr uint64_t kInitial = InitialAges();
+  static constexpr uint64_t kUnusedLanes =
+      Ways == 16 ? 0 : ~uint64_t{0} << (4 * Ways);
+
+  ArenaArray<State> ages_;
+
+  uint64_t Load(size_t set_idx) const {
+    return static_cast<uint64_t>(ages_[set_idx]) | kUnusedLanes;
+  }
+
+ public:
+  static constexpr size_t ArenaBytes(size_t sets, size_t /*ways*/) {
+    return stratum::ArenaBytes<State>(sets);
+  }
+
+  PackedLRU(size_t sets, size_t /*ways*/, Arena* arena = nullptr)
+      : ages_(sets, static_cast<State>(kInitial), arena) {}
+
+  void OnHit(size_t set_idx, size_t way_idx) noexcept {
+    const uint64_t ages = Load(set_idx);
+    const uint64_t age = (ages >> (4 * way_idx)) & 0xF;
+
+    // Split nibbles into byte lanes so each has a spare high bit, then bump
+    // every lane younger than the touched way: (x | 0x80) - age has its high
+    // bit clear exactly when x < age.
+    uint64_t even = ages & kNibbles;
+    uint64_t odd = (ages >> 4) & kNibbles;
+    even += (~((even | kHighBits) - kLowBytes * age) & kHighBits) >> 7;
+    odd += (~((odd | kHighBits) - kLowBytes * age) & kHighBits) >> 7;
+
+    uint64_t next = even | (odd << 4);
+    next &= ~(uint64_t{0xF} << (4 * way_idx));  // touched way becomes MRU
+    ages_[set_idx] = static_cast<State>(next);
+  }
+
+  void OnFill(size_t set_idx, size_t way_idx) noexcept {
+    OnHit(set_idx, way_idx);
+  }
+
+  STRATUM_ALWAYS_INLINE void Prefetch(size_t set_idx) const noexcept {
+    PrefetchRange(&ages_[set_idx], sizeof(State));
+  }
+
+  [[nodiscard]] size_t GetVictim(size_t set_idx) const noexcept {
+    // Exactly one lane holds Ways - 1; find the zero nibble after XOR.
+    const uint64_t x = Load(set_idx) ^ (kLowBytes * 0x11 * (Ways - 1));
+    const uint64_t even = x & kNibbles;
+    const uint64_t odd = (x >> 4) & kNibbles;
+    const uint64_t zero_even = ~((even | kHighBits) - kLowBytes) & kHighBits;
+    const uint64_t zero_odd = ~((odd | kHighBits) - kLowBytes) & kHighBits;
+    // Bit 7 of byte k -> nibble 2k, and -> nibble 2k + 1 for odd lanes.
+    const uint64_t lanes = (zero_even >> 7) | (zero_odd >> 3);
+    return static_cast<size_t>(std::countr_zero(lanes)) / 4;
+  }
+
+  void Reset() noexcept { ages_.Fill(static_cast<State>(kInitial)); }
+
+  void SaveState(SnapshotWriter& out) const {
+    out.Array(ages_.data(), ages_.size());
+  }
+
+  void LoadState(SnapshotReader& in) { in.Array(ages_.data(), ages_.size()); }
+};
+
+struct PackedLRUPolicy {
+  static constexpr std::string_view kName{"packed-lru"};
+  template <size_t Ways>
+  using ForWays = PackedLRU<Ways>;
+};
+
+// 6. Re-Reference Interval Prediction (Jaleel et al., ISCA 2010)
+//
+// Each way carries a 2-bit re-reference prediction value (RRPV), packed into
+// one word per set (up to 32 ways). Hits promote to 0; the victim is the
+// first way predicted "distant" (3). If none is, the whole set is aged in a
+// single SWAR add by the amount that brings the oldest way to 3, which is
+// equivalent to the incremental "age all and retry" loop.
+//
+//   SRRIP: insert at 2 (long re-reference interval)
+//   BRRIP: insert at 3, and at 2 once every kBimodalPeriod fills
+//   DRRIP: set dueling between SRRIP and BRRIP leader sets via a PSEL counter
+enum class RRIPMode { kStatic, kBimodal, kDynamic };
+
+template <size_t Ways, RRIPMode Mode>
+class RRIP {
+  static_assert(Ways >= 1 && Ways <= 32,
+                "RRIP packs 2-bit RRPVs for at most 32 ways");
+
+  using State = PackedState<2 * Ways>;
+
+  static constexpr uint64_t kDistant = 3;
+  static constexpr uint64_t kLong = 2;
+  static constexpr uint64_t kBimodalPeriod = 32;
+  static constexpr int kPselMax = 1023;  // 10-bit saturating counter
+  static constexpr size_t kLeaderSets = 32;
+
+  // Bit 0 of every RRPV lane in use.
+  static constexpr uint64_t kLaneLowBits =
+      0x5555555555555555ULL >> (64 - 2 * Ways);
+
+  ArenaArray<State> rrpv_;
+  uint64_t fills_ = 0;
+  int psel_ = kPselMax / 2;
+  size_t leader_period_ = 1;
+
+ public:
+  // BRRIP's 1-in-32 counter and DRRIP's PSEL are shared by all sets.
+  static constexpr bool kSetLocal = Mode == RRIPMode::kStatic;
+
+  static constexpr size_t ArenaBytes(size_t sets, size_t /*ways*/) {
+    return stratum::ArenaBytes<State>(sets);
+  }
+
+  RRIP(size_t sets, size_t /*ways*/, Arena* arena = nullptr)
+      : rrpv_(sets, static_cast<State>(kLaneLowBits * kDistant), arena) {
+    // At most a quarter of the sets lead, up to kLeaderSets per policy.
+    size_t leaders = std::max<size_t>(1, std::min(kLeaderSets, sets / 8));
+    leader_period_ = std::max<size_t>(1, sets / leaders);
+  }
+
+  STRATUM_ALWAYS_INLINE void Prefetch(size_t set_idx) const noexcept {
+    PrefetchRange(&rrpv_[set_idx], sizeof(State));
+  }
+
+  void OnHit(size_t set_idx, size_t way_idx) noexcept {
+    rrpv_[set_idx] &= static_cast<State>(~(uint64_t{3} << (2 * way_idx)));
+  }
+
+  void OnFill(size_t set_idx, size_t way_idx) noexcept {
+    const uint64_t insert = UseBimodal(set_idx) ? BimodalInsertion() : kLong;
+    const uint64_t shift = 2 * way_idx;
+    uint64_t v = rrpv_[set_idx];
+    v = (v & ~(uint64_t{3} << shift)) | (insert << shift);
+    rrpv_[set_idx] = static_cast<State>(v);
+  }
+
+  // Set dueling feedback: a miss in a leader set votes against its policy.
+  void OnMiss(size_t set_idx) noexcept {
+    if constexpr (Mode == RRIPMode::kDynamic) {
+      const size_t slot = set_idx % leader_period_;
+      if (slot == 0) {
+        psel_ = std::min(psel_ + 1, kPselMax);
+      } else if (slot == 1) {
+        psel_ = std::max(psel_ - 1, 0);
+      }
+    }
+  }
+
+  [[nodiscard]] size_t GetVictim(size_t set_idx) noexcept {
+    uint64_t v = rrpv_[set_idx];
+    uint64_t distant = v & (v >> 1) & kLaneLowBits;
+    if (distant == 0) {
+      // Max RRPV is 2 if any high bit is set, else 1 if any low bit, else 0.
+      const uint64_t high = (v >> 1) & kLaneLowBits;
+      const uint64_t age = high != 0 ? 1 : ((v & kLaneLowBits) != 0 ? 2 : 3);
+      v += kLaneLowBits * age;
+      rrpv_[set_idx] = static_cast<State>(v);
+      distant = v & (v >> 1) & kLaneLowBits;
+    }
+    return static_cast<size_t>(std::countr_zero(distant)) / 2;
+  }
+
+  // PSEL above its midpoint means SRRIP leaders miss more.
+  [[nodiscard]] bool PrefersBimodal() const { return psel_ > kPselMax / 2; }
+
+  void Reset() noexcept {
+    rrpv_.Fill(static_cast<State>(kLaneLowBits * kDistant));
+    fills_ = 0;
+    psel_ = kPselMax / 2;
+  }
+
+  void SaveState(SnapshotWriter& out) const {
+    out.Array(rrpv_.data(), rrpv_.size());
+    out.Value(fills_);
+    out.Value(psel_);
+  }
+
+  void LoadState(SnapshotReader& in) {
+    in.Array(rrpv_.data(), rrpv_.size());
+    in.Value(fills_);
+    in.Value(psel_);
+  }
+
+ private:
+  bool UseBimodal(size_t set_idx) const {
+    if constexpr (Mode == RRIPMode::kStatic) {
+      return false;
+    } else if constexpr (Mode == RRIPMode::kBimodal) {
+      return true;
+    } else {
+      const size_t slot = set_idx % leader_period_;
+      if (slot == 0) return false;  // SRRIP leader
+      if (slot == 1) return true;   // BRRIP leader
+      return PrefersBimodal();
+    }
+  }
+
+  // Deterministic epsilon so that runs are reproducible.
+  uint64_t BimodalInsertion() {
+    return (++fills_ % kBimodalPeriod == 0) ? kLong : kDistant;
+  }
+};
+
+struct SRRIPPolicy {
+  static constexpr std::string_view kName{"srrip"};
+  template <size_t Ways>
+  using ForWays = RRIP<Ways, RRIPMode::kStatic>;
+};
+
+struct BRRIPPolicy {
+  static constexpr std::string_view kName{"brrip"};
+  template <size_t Ways>
+  using ForWays = RRIP<Ways, RRIPMode::kBimodal>;
+};
+
+struct DRRIPPolicy {
+  static constexpr std::string_view kName{"drrip"};
+  template <size_t Ways>
+  using ForWays = RRIP<Ways, RRIPMode::kDynamic>;
 };
 
 }  // namespace stratum
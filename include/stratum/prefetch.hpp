@@ -0,0 +1,43 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Prefetch helpers must be inlined into the access loop. GCC treats an
+// out-of-line function that only prefetches as free of side effects and
+// deletes calls to it, which silently turns the hint into a no-op.
+#if defined(__GNUC__) || defined(__clang__)
+#define STRATUM_ALWAYS_INLINE [[gnu::always_inline]] inline
+#else
+#define STRATUM_ALWAYS_INLINE inline
+#endif
+
+namespace stratum {
+
+// Line size of the machine running the simulator (not the simulated one).
+inline constexpr size_t kHostCacheLine = 64;
+
+// Hints the host CPU that the lines covering [p, p + bytes) are about to be
+// read and written. Purely a performance hint: it never faults and compiles
+// to nothing on compilers without __builtin_prefetch.
+STRATUM_ALWAYS_INLINE void PrefetchRange(const void* p,
+                                         size_t bytes) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  const uintptr_t begin =
+      reinterpret_cast<uintptr_t>(p) & ~(uintptr_t{kHostCacheLine} - 1);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(p) + bytes;
+  for (uintptr_t line = begin; line < end; line += kHostCacheLine) {
+    __builtin_prefetch(reinterpret_cast<const void*>(line), 1, 3);
+  }
+#else
+  (void)p;
+  (void)bytes;
+#endif
+}
+
+}  // namespace stratum
+
+#endif  // PREFETCH_HPP
@@ -0,0 +1,214 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef PREFETCHERS_HPP
+#define PREFETCHERS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "stratum/snapshot.hpp"
+
+namespace stratum {
+
+// Simulated hardware prefetchers (the host-side hints live in prefetch.hpp).
+//
+// Prefetcher interface
+//
+//   static constexpr std::string_view kName;  // part of Cache::Signature
+//   static constexpr bool kEnabled;           // false only for NoPrefetcher
+//   template <typename Issue>
+//   void OnAccess(uint64_t block, bool hit, bool first_use, Issue&& issue);
+//   void Reset();
+//   void SaveState(SnapshotWriter&) const;
+//   void LoadState(SnapshotReader&);
+//
+// Cache calls OnAccess after every demand access with the block number
+// (addr / BlockSize). `hit` is the demand outcome, and `first_use` marks
+// the first demand hit on a line that a prefetch brought in. The prefetcher
+// calls issue(block) for each block it wants. Cache fills those blocks
+// through its prefetch path, which bypasses demand statistics (see
+// Cache::PrefetchFill). Such fills are untimed: their latency is assumed
+// to overlap the demand stream.
+//
+// Prefetchers see the whole address stream of their level, so none of them
+// is set-local (set-sharded runs with one are approximate).
+
+// Default: no prefetching. Cache compiles every prefetch hook out.
+struct NoPrefetcher {
+  static constexpr std::string_view kName{"none"};
+  static constexpr bool kEnabled = false;
+
+  template <typename Issue>
+  void OnAccess(uint64_t, bool, bool, Issue&&) {}
+  void Reset() {}
+  void SaveState(SnapshotWriter&) const {}
+  void LoadState(SnapshotReader&) {}
+};
+
+// Tagged next-line prefetcher: a miss, or the first use of a prefetched
+// line, fetches the next `Degree` blocks.
+template <size_t Degree = 1>
+struct NextLinePrefetcher {
+  static_assert(Degree > 0);
+  static constexpr std::string_view kName{"next-line"};
+  static constexpr bool kEnabled = true;
+  static constexpr bool kSetLocal = false;
+
+  template <typename Issue>
+  void OnAccess(uint64_t block, bool hit, bool first_use, Issue&& issue) {
+    if (hit && !first_use) return;
+    for (size_t d = 1; d <= Degree; ++d) issue(block + d);
+  }
+  void Reset() {}
+  void SaveState(SnapshotWriter&) const {}
+  void LoadState(SnapshotReader&) {}
+};
+
+// Stride prefetcher without instruction addresses: a direct-mapped table of
+// `Entries` regions of `RegionBlocks` blocks remembers the last block and
+// stride seen in each region. Once the same non-zero stride has been seen
+// twice in a row, each access in the region prefetches `Degree` strides
+// ahead.
+template <size_t Entries = 64, size_t RegionBlocks = 64, size_t Degree = 2>
+class StridePrefetcher {
+  static_assert(Entries > 0 && RegionBlocks > 0 && Degree > 0);
+
+  struct Entry {
+    uint64_t region = ~uint64_t{0};
+    uint64_t last_block = 0;
+    int64_t stride = 0;
+    uint8_t confidence = 0;  // saturates at kMaxConfidence
+  };
+
+  static constexpr uint8_t kThreshold = 2;
+  static constexpr uint8_t kMaxConfidence = 3;
+
+  std::array<Entry, Entries> table_{};
+
+ public:
+  static constexpr std::string_view kName{"stride"};
+  static constexpr bool kEnabled = true;
+  static constexpr bool kSetLocal = false;
+
+  template <typename Issue>
+  void OnAccess(uint64_t block, bool, bool, Issue&& issue) {
+    const uint64_t region = block / RegionBlocks;
+    Entry& e = table_[region % Entries];
+    if (e.region != region) {
+      e = {region, block, 0, 0};
+      return;
+    }
+    const int64_t delta = static_cast<int64_t>(block - e.last_block);
+    if (delta == 0) return;
+    if (delta == e.stride) {
+      e.confidence = std::min<uint8_t>(e.confidence + 1, kMaxConfidence);
+    } else {
+      e.stride = delta;
+      e.confidence = 1;
+    }
+    e.last_block = block;
+    if (e.confidence < kThreshold) return;
+    for (size_t d = 1; d <= Degree; ++d) {
+      issue(block + static_cast<uint64_t>(e.stride * static_cast<int64_t>(d)));
+    }
+  }
+
+  void Reset() { table_ = {}; }
+  void SaveState(SnapshotWriter& out) const { out.Value(table_); }
+  void LoadState(SnapshotReader& in) { in.Value(table_); }
+};
+
+// Stream prefetcher: tracks up to `Streams` sequential miss streams (LRU
+// replaced). A miss opens a candidate stream; the next two misses within
+// `Distance` blocks of it, moving in the same direction, confirm it. From
+// then on every miss or first use of a prefetched line in the stream moves
+// the prefetch head by up to `Degree` blocks, keeping it at most `Distance`
+// blocks ahead of the demand stream.
+template <size_t Streams = 16, size_t Distance = 16, size_t Degree = 4>
+class StreamPrefetcher {
+  static_assert(Streams > 0 && Distance > 0 && Degree > 0);
+
+  struct Stream {
+    uint64_t last = 0;  // last demand block
+    uint64_t head = 0;  // last block prefetched
+    int8_t direction = 0;
+    uint8_t confirmations = 0;
+    bool valid = false;
+    uint64_t stamp = 0;  // LRU stamp
+  };
+
+  std::array<Stream, Streams> streams_{};
+  uint64_t clock_ = 0;
+
+  static constexpr int64_t kDistance = static_cast<int64_t>(Distance);
+
+ public:
+  static constexpr std::string_view kName{"stream"};
+  static constexpr bool kEnabled = true;
+  static constexpr bool kSetLocal = false;
+
+  template <typename Issue>
+  void OnAccess(uint64_t block, bool hit, bool first_use, Issue&& issue) {
+    if (hit && !first_use) return;
+    clock_++;
+    for (Stream& s : streams_) {
+      const int64_t delta = static_cast<int64_t>(block - s.last);
+      if (!s.valid || delta == 0 || delta > kDistance || delta < -kDistance) {
+        continue;
+      }
+      const int8_t direction = delta > 0 ? 1 : -1;
+      if (direction == s.direction) {
+        s.confirmations = 2;
+      } else {
+        s = {s.last, s.last, direction, 1, true, 0};
+      }
+      s.last = block;
+      s.stamp = clock_;
+      if (s.confirmations < 2) return;
+
+      // Restart the head at the demand block if demand overtook it.
+      const int64_t ahead = static_cast<int64_t>(s.head - block) * direction;
+      if (ahead < 0) s.head = block;
+      for (size_t n = 0; n < Degree; ++n) {
+        if (static_cast<int64_t>(s.head - block) * direction >= kDistance) {
+          break;
+        }
+        s.head += static_cast<uint64_t>(static_cast<int64_t>(direction));
+        issue(s.head);
+      }
+      return;
+    }
+
+    Stream* victim = &streams_[0];
+    for (Stream& s : streams_) {
+      if (!s.valid) {
+        victim = &s;
+        break;
+      }
+      if (s.stamp < victim->stamp) victim = &s;
+    }
+    *victim = {block, block, 0, 0, true, clock_};
+  }
+
+  void Reset() {
+    streams_ = {};
+    clock_ = 0;
+  }
+
+  void SaveState(SnapshotWriter& out) const {
+    out.Value(streams_);
+    out.Value(clock_);
+  }
+
+  void LoadState(SnapshotReader& in) {
+    in.Value(streams_);
+    in.Value(clock_);
+  }
+};
+
+}  // namespace stratum
+
+#endif  // PREFETCHERS_HPP
@@ -0,0 +1,334 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef PREFILTER_HPP
+#define PREFILTER_HPP
+
+#include <fmt/core.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/cache_sim.hpp"
+#include "stratum/simulation.hpp"
+#include "stratum/trace_parser.hpp"
+
+namespace stratum {
+
+// ============================================================================
+// L1 Pre-filtering
+// ============================================================================
+// Sweeps over L2/L3 designs usually keep the L1 fixed, yet replaying the
+// full trace pushes every access through that same L1 again. The levels
+// below an L1 only ever see its demand fetches (misses, including
+// write-allocate fills) and its dirty victims, so the trace is run through
+// the L1 once and that request stream is kept instead:
+//
+//   'L' op   demand fetch the L1 sent down (Load of the missing address)
+//   'S' op   dirty victim the L1 wrote back
+//
+// in the order the L1 issued them, in the binary trace format. Replaying
+// the stream into the lower levels (ReplayMissStream) drives them through
+// exactly the calls the full hierarchy would make, so their state and
+// counters match, and FilteredRun rebuilds the per-level report of the
+// whole hierarchy from it. Cache-friendly traces shrink by 10-100x.
+//
+// The stream keeps block numbers at the L1 block size, so the lower levels
+// must use block sizes that are multiples of the L1's (as usual).
+//
+// A stream written to a file (FilterTraceToFile) keeps the L1 stats in a
+// small text file next to it (FilterStatsPath), so a later run rebuilds the
+// full report from the two files alone (RunFilteredFile).
+//
+// Example:
+//   using L1 = Cache<"L1", MainMemory<>, 64, 8, 64, LRUPolicy, 4>;
+//   MappedTraceReader reader("trace.txt");
+//   FilterTraceToFile<L1>(reader, "trace.l1.bin");
+//   ...
+//   auto lower = std::make_unique<L2Type>(100);
+//   const auto run = RunFilteredFile("trace.l1.bin", *lower);
+
+// Bottom layer of the filter stage: records what the L1 above sends to the
+// next level instead of serving it. Every request completes in 0 cycles.
+class MissStreamRecorder {
+  BinaryTraceWriter* out_;
+  uint64_t fetches_ = 0;
+  uint64_t writebacks_ = 0;
+
+ public:
+  static constexpr std::string_view kName{"MissStream"};
+  static constexpr size_t kLevels = 1;
+  static constexpr LevelInfo kInfo{kName, 0, 0, 0, 0, true};
+
+  explicit MissStreamRecorder(BinaryTraceWriter& out) : out_(&out) {}
+
+  AccessResult Load(uint64_t addr) {
+    out_->Append({'L', addr});
+    fetches_++;
+    return {0, 0};
+  }
+
+  AccessResult Store(uint64_t addr) { return Writeback(addr); }
+
+  AccessResult Writeback(uint64_t addr) {
+    out_->Append({'S', addr});
+    writebacks_++;
+    return {0, 0};
+  }
+
+  [[nodiscard]] uint64_t Fetches() const { return fetches_; }
+  [[nodiscard]] uint64_t Writebacks() const { return writebacks_; }
+};
+
+// What the filter stage measured at the L1. Counted from access results,
+// so it is exact with STRATUM_INSTRUMENTATION=0 as well.
+struct FilterStats {
+  std::string name;
+  uint64_t accesses = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;      // demand fetches ('L' ops in the stream)
+  uint64_t writebacks = 0;  // dirty victims ('S' ops in the stream)
+  size_t hit_latency = 0;
+
+  [[nodiscard]] uint64_t StreamOps() const { return misses + writebacks; }
+
+  // Trace operations per stream operation (0 for an empty stream).
+  [[nodiscard]] double Reduction() const {
+    return StreamOps() == 0 ? 0.0 : (double)accesses / StreamOps();
+  }
+};
+
+// Runs every operation from `reader` through a fresh L1 of type `L1` (a
+// Cache whose own NextLayer is ignored) and appends the requests it sends
+// below to `out`. The writer is left open for the caller to close.
+template <typename L1, typename Reader>
+FilterStats FilterTrace(Reader& reader, BinaryTraceWriter& out) {
+  using Stage = typename L1::template Rebind<MissStreamRecorder>;
+  auto stage = std::make_unique<Stage>(out);
+
+  FilterStats stats;
+  stats.name = Stage::kName;
+  stats.hit_latency = Stage::kHitLatency;
+  ReplayTrace(reader, *stage, [&](const TraceOp&, const AccessResult& res) {
+    stats.accesses++;
+    if (res.hit_level == 0) stats.hits++;
+  });
+  stats.misses = stage->GetNext()->Fetches();
+  stats.writebacks = stage->GetNext()->Writebacks();
+  return stats;
+}
+
+// A filter stream held in memory with the L1 stats it was produced with.
+struct FilteredTrace {
+  FilterStats l1;
+  std::string stream;  // binary trace, see BinaryTraceReader(string_view)
+};
+
+template <typename L1, typename Reader>
+FilteredTrace FilterTraceToMemory(Reader& reader) {
+  FilteredTrace filtered;
+  BinaryTraceWriter out(filtered.stream, L1::kBlockSize);
+  filtered.l1 = FilterTrace<L1>(reader, out);
+  out.Close();
+  return filtered;
+}
+
+// Where FilterTraceToFile stores the L1 stats of the stream at
+// `stream_path`.
+inline std::string FilterStatsPath(const std::string& stream_path) {
+  return stream_path + ".l1";
+}
+
+inline constexpr uint32_t kFilterStatsVersion = 1;
+
+// Writes `stats` as "key value" lines after a "stratum-filter <version>"
+// line. Returns false (with a message) on I/O error.
+inline bool SaveFilterStats(const FilterStats& stats,
+                            const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    fmt::print(stderr, "Error: Could not create filter stats {}\n", path);
+    return false;
+  }
+  fmt::print(file,
+             "stratum-filter {}\nname {}\naccesses {}\nhits {}\nmisses {}\n"
+             "writebacks {}\nhit_latency {}\n",
+             kFilterStatsVersion, stats.name, stats.accesses, stats.hits,
+             stats.misses, stats.writebacks, stats.hit_latency);
+  bool ok = std::ferror(file) == 0;
+  ok &= std::fclose(file) == 0;
+  if (!ok) {
+    fmt::print(stderr, "Error: Could not write filter stats {}\n", path);
+  }
+  return ok;
+}
+
+// Reads stats written by SaveFilterStats; nullopt (with a message) if the
+// file is missing, incomplete or of another version.
+inline std::optional<FilterStats> LoadFilterStats(const std::string& path) {
+  std::ifstream in(path);
+  auto field = [&](std::string_view key, auto& value) {
+    std::string word;
+    return in >> word >> value && word == key;
+  };
+  uint32_t version = 0;
+  FilterStats stats;
+  const bool ok = field("stratum-filter", version) &&
+                  version == kFilterStatsVersion &&
+                  field("name", stats.name) &&
+                  field("accesses", stats.accesses) &&
+                  field("hits", stats.hits) && field("misses", stats.misses) &&
+                  field("writebacks", stats.writebacks) &&
+                  field("hit_latency", stats.hit_latency);
+  if (!ok) {
+    fmt::print(stderr, "Error: Invalid filter stats {}\n", path);
+    return std::nullopt;
+  }
+  return stats;
+}
+
+// Filters `reader` through a fresh `L1` into the binary trace
+// `stream_path` and stores the L1 stats at FilterStatsPath(stream_path).
+// nullopt (with a message) if either file could not be written.
+template <typename L1, typename Reader>
+std::optional<FilterStats> FilterTraceToFile(
+    Reader& reader, const std::string& stream_path,
+    TraceEncoding encoding = TraceEncoding::kDeltaVarint) {
+  BinaryTraceWriter out(stream_path, L1::kBlockSize, encoding);
+  if (!out.IsOpen()) return std::nullopt;
+  FilterStats stats = FilterTrace<L1>(reader, out);
+  if (!out.Close()) {
+    fmt::print(stderr, "Error: Could not write {}\n", stream_path);
+    return std::nullopt;
+  }
+  if (!SaveFilterStats(stats, FilterStatsPath(stream_path))) {
+    return std::nullopt;
+  }
+  return stats;
+}
+
+// Replays a filter stream into `lower`, the hierarchy below the filtered
+// L1: 'L' ops as Loads, 'S' ops as Writebacks (Stores for levels without
+// one). Calls on_fetch(op, result) for each demand fetch only; the results
+// of writebacks are dropped, as the L1 drops them.
+template <typename Reader, typename Lower, typename OnFetch>
+void ReplayMissStream(Reader& reader, Lower& lower, OnFetch&& on_fetch) {
+  std::vector<TraceOp> batch;
+  batch.reserve(kTraceBatchSize);
+  while (reader.ReadBatch(batch) > 0) {
+    for (const auto& op : batch) {
+      if (op.type == 'L') {
+        on_fetch(op, lower.Load(op.addr));
+      } else if constexpr (requires { lower.Writeback(op.addr); }) {
+        lower.Writeback(op.addr);
+      } else {
+        lower.Store(op.addr);
+      }
+    }
+  }
+}
+
+// Statistics of a full hierarchy (the filtered L1 on top of a lower
+// hierarchy of `LowerLevels` levels) rebuilt from a filter pass and a
+// replay of its stream.
+template <size_t LowerLevels>
+struct FilteredRun {
+  static constexpr size_t kLevels = LowerLevels + 1;
+
+  FilterStats l1;
+  SimulationStats<LowerLevels> lower;  // demand fetches, from below the L1
+
+  [[nodiscard]] size_t Accesses() const { return l1.accesses; }
+
+  // Same as SimulationStats::Level over the unfiltered trace: level 0 is
+  // the L1; every access served below it also paid the L1 hit latency.
+  [[nodiscard]] CacheStats Level(size_t level) const {
+    if (level == 0) return {l1.hits, l1.misses, l1.hits * l1.hit_latency};
+    CacheStats s = lower.Level(level - 1);
+    s.total_latency += s.hits * l1.hit_latency;
+    return s;
+  }
+
+  // Average memory access time in cycles.
+  [[nodiscard]] double Amat() const {
+    size_t cycles = 0;
+    for (size_t i = 0; i < kLevels; ++i) cycles += Level(i).total_latency;
+    return l1.accesses == 0 ? 0.0 : (double)cycles / l1.accesses;
+  }
+};
+
+// Replays `filtered` into a fresh `Lower` hierarchy.
+template <typename Lower>
+FilteredRun<Lower::kLevels> RunFiltered(const FilteredTrace& filtered,
+                                        Lower& lower) {
+  FilteredRun<Lower::kLevels> run{filtered.l1, {}};
+  BinaryTraceReader reader{std::string_view(filtered.stream)};
+  ReplayMissStream(reader, lower,
+                   [&](const TraceOp& op, const AccessResult& res) {
+                     run.lower.Record(op, res);
+                   });
+  return run;
+}
+
+// Replays the stream FilterTraceToFile wrote to `stream_path` into
+// `lower`, with the L1 stats stored next to it. nullopt (with a message)
+// if either file is missing or they do not describe the same pass.
+template <typename Lower>
+std::optional<FilteredRun<Lower::kLevels>> RunFilteredFile(
+    const std::string& stream_path, Lower& lower) {
+  const auto l1 = LoadFilterStats(FilterStatsPath(stream_path));
+  if (!l1) return std::nullopt;
+  BinaryTraceReader reader(stream_path);
+  if (!reader.IsOpen()) return std::nullopt;
+  if (reader.Header().op_count != l1->StreamOps()) {
+    fmt::print(stderr, "Error: {} does not match filter stats {}\n",
+               stream_path, FilterStatsPath(stream_path));
+    return std::nullopt;
+  }
+
+  FilteredRun<Lower::kLevels> run{*l1, {}};
+  ReplayMissStream(reader, lower,
+                   [&](const TraceOp& op, const AccessResult& res) {
+                     run.lower.Record(op, res);
+                   });
+  return run;
+}
+
+inline void PrintFilterStats(const FilterStats& s) {
+  fmt::print(
+      "Filter {}: Accesses={}, Hits={}, Misses={}, Writebacks={}, "
+      "StreamOps={} ({:.1f}x smaller)\n",
+      s.name, s.accesses, s.hits, s.misses, s.writebacks, s.StreamOps(),
+      s.Reduction());
+}
+
+// Prints the per-level table of SimulationStats::Print for a filtered run.
+template <size_t LowerLevels>
+void PrintFilteredReport(
+    const FilteredRun<LowerLevels>& run,
+    const std::array<std::string_view, LowerLevels>& lower_names) {
+  fmt::print("\n=== Simulation Results (L1-filtered) ===\n");
+  PrintFilterStats(run.l1);
+  fmt::print("{:<15} {:>10} {:>10} {:>20}\n", "Level", "Hits", "Misses",
+             "Avg Latency (cyc)");
+  for (size_t i = 0; i < run.kLevels; ++i) {
+    const auto s = run.Level(i);
+    const double avg_lat = s.hits > 0 ? (double)s.total_latency / s.hits : 0;
+    fmt::print("{:<15} {:>10} {:>10} {:>20.0f}\n",
+               i == 0 ? std::string_view(run.l1.name) : lower_names[i - 1],
+               s.hits, s.misses, avg_lat);
+  }
+  fmt::print("AMAT: {:.2f} cycles\n", run.Amat());
+}
+
+}  // namespace stratum
+
+#endif  // PREFILTER_HPP
@@ -0,0 +1,272 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef PROGRESS_HPP
+#define PROGRESS_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "stratum/cache_sim.hpp"
+#include "stratum/trace_parser.hpp"
+
+namespace stratum {
+
+// Live progress of a long replay.
+//
+// The replay thread publishes its running totals to ProgressCounters once
+// per batch. It is the only writer, so each counter is a relaxed store: no
+// read-modify-write, lock or fence on the simulation path, and a batch of
+// kTraceBatchSize accesses pays for a handful of stores. A ProgressReporter
+// thread loads the counters every interval and reports progress,
+// throughput and an ETA. Counters are read one by one, so a report may mix
+// two consecutive batches.
+
+// When and where progress is reported. Disabled by default.
+struct ProgressOptions {
+  std::chrono::milliseconds interval{0};  // 0 disables reporting
+  std::string json_path;  // JSON lines to this file instead of text to stderr
+
+  [[nodiscard]] bool Enabled() const { return interval.count() > 0; }
+
+  // STRATUM_PROGRESS=<seconds> reports every <seconds>;
+  // STRATUM_PROGRESS_JSON=<path> writes the reports as JSON lines (every
+  // 10 s unless STRATUM_PROGRESS is also set). Lets any binary, generated
+  // experiments included, report without a rebuild.
+  static ProgressOptions FromEnv() {
+    ProgressOptions options;
+    if (const char* json = std::getenv("STRATUM_PROGRESS_JSON")) {
+      options.json_path = json;
+      if (!options.json_path.empty()) {
+        options.interval = std::chrono::seconds(10);
+      }
+    }
+    if (const char* seconds = std::getenv("STRATUM_PROGRESS")) {
+      const double s = std::strtod(seconds, nullptr);
+      options.interval = std::chrono::milliseconds(
+          s > 0.0 ? static_cast<int64_t>(s * 1000.0 + 0.5) : 0);
+    }
+    return options;
+  }
+};
+
+// Running totals of a replay over a hierarchy of `Levels` levels, on a
+// cache line of their own.
+template <size_t Levels>
+struct alignas(64) ProgressCounters {
+  std::atomic<uint64_t> ops{0};
+  std::atomic<uint64_t> cycles{0};
+  std::array<std::atomic<uint64_t>, Levels> served{};  // hits by level
+  std::atomic<uint64_t> done{0};  // trace units read (see TraceProgress)
+  std::atomic<uint64_t> total{0};
+
+  // Called by the replay thread, the only writer, after each batch.
+  void Publish(const SimulationStats<Levels>& stats,
+               TraceProgress progress) noexcept {
+    uint64_t cycles_so_far = 0;
+    for (size_t i = 0; i < Levels; ++i) {
+      const CacheStats s = stats.Level(i);
+      served[i].store(s.hits, std::memory_order_relaxed);
+      cycles_so_far += s.total_latency;
+    }
+    cycles.store(cycles_so_far, std::memory_order_relaxed);
+    done.store(progress.done, std::memory_order_relaxed);
+    total.store(progress.total, std::memory_order_relaxed);
+    ops.store(stats.Accesses(), std::memory_order_relaxed);
+  }
+};
+
+// Where `reader` is in its trace, or {} for readers that cannot tell.
+template <typename Reader>
+TraceProgress ReaderProgress(const Reader& reader) {
+  if constexpr (requires { reader.Progress(); }) {
+    return reader.Progress();
+  } else {
+    return {};
+  }
+}
+
+// `s` as a JSON string literal.
+inline std::string JsonString(std::string_view s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out += fmt::format("\\u{:04x}", static_cast<unsigned>(c));
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+// Reports `counters` every options.interval from a thread of its own,
+// until Stop() (or destruction), which adds one final report of the
+// totals. The replay thread never waits on it.
+//
+// Text reports go to stderr:
+//   [progress] Random: 12.6M ops (45.1%) | 3.21 Mops/s (avg 3.10) |
+//     ETA 1h02m03s | AMAT 23.4 | L1 95.1% L2 40.2% L3 10.0%
+// JSON lines (options.json_path) carry the same fields per report.
+template <size_t Levels>
+class ProgressReporter {
+  using Clock = std::chrono::steady_clock;
+
+  const ProgressCounters<Levels>& counters_;
+  std::string label_;
+  std::array<std::string_view, Levels> names_;
+  ProgressOptions options_;
+  std::FILE* json_ = nullptr;
+  Clock::time_point start_ = Clock::now();
+  Clock::time_point last_time_ = start_;
+  uint64_t last_ops_ = 0;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;  // last: starts once everything above is set
+
+ public:
+  ProgressReporter(const ProgressCounters<Levels>& counters,
+                   std::string label,
+                   const std::array<std::string_view, Levels>& names,
+                   ProgressOptions options)
+      : counters_(counters),
+        label_(std::move(label)),
+        names_(names),
+        options_(std::move(options)) {
+    if (!options_.json_path.empty()) {
+      json_ = std::fopen(options_.json_path.c_str(), "a");
+      if (json_ == nullptr) {
+        fmt::print(stderr, "Error: Could not open progress file {}\n",
+                   options_.json_path);
+      }
+    }
+    if (options_.Enabled()) thread_ = std::thread([this] { Run(); });
+  }
+
+  ProgressReporter(const ProgressReporter&) = delete;
+  ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+  ~ProgressReporter() { Stop(); }
+
+  void Stop() {
+    if (!thread_.joinable()) return;
+    stop_.store(true, std::memory_order_relaxed);
+    thread_.join();
+    Report(/*final=*/true);
+    if (json_ != nullptr) std::fclose(json_);
+    json_ = nullptr;
+  }
+
+ private:
+  void Run() {
+    // Sleeps in short steps so Stop() returns promptly.
+    constexpr auto kPoll = std::chrono::milliseconds(50);
+    auto next = start_ + options_.interval;
+    while (!stop_.load(std::memory_order_relaxed)) {
+      const auto now = Clock::now();
+      if (now >= next) {
+        Report(/*final=*/false);
+        next += options_.interval;
+        if (next < now) next = now + options_.interval;
+      }
+      std::this_thread::sleep_for(
+          std::min<Clock::duration>(kPoll, next - Clock::now()));
+    }
+  }
+
+  void Report(bool final) {
+    const auto now = Clock::now();
+    const uint64_t ops = counters_.ops.load(std::memory_order_relaxed);
+    const uint64_t cycles = counters_.cycles.load(std::memory_order_relaxed);
+    const uint64_t done = counters_.done.load(std::memory_order_relaxed);
+    const uint64_t total = counters_.total.load(std::memory_order_relaxed);
+    std::array<uint64_t, Levels> served;
+    for (size_t i = 0; i < Levels; ++i) {
+      served[i] = counters_.served[i].load(std::memory_order_relaxed);
+    }
+
+    const double elapsed = Seconds(now - start_);
+    const double window = Seconds(now - last_time_);
+    const double mops = window > 0.0 ? (ops - last_ops_) / window / 1e6 : 0.0;
+    const double avg_mops = elapsed > 0.0 ? ops / elapsed / 1e6 : 0.0;
+    last_time_ = now;
+    last_ops_ = ops;
+    const bool known = total > 0;
+    const double fraction =
+        known ? std::min(1.0, static_cast<double>(done) / total) : 0.0;
+    const double eta = fraction > 0.0 && fraction < 1.0
+                           ? elapsed * (1.0 - fraction) / fraction
+                           : 0.0;
+    const double amat = ops > 0 ? static_cast<double>(cycles) / ops : 0.0;
+
+    // Misses of a level: accesses served further down.
+    std::array<uint64_t, Levels> misses{};
+    for (size_t i = Levels; i-- > 1;) misses[i - 1] = misses[i] + served[i];
+
+    if (json_ != nullptr) {
+      std::string levels;
+      for (size_t i = 0; i < Levels; ++i) {
+        levels += fmt::format("{}{{\"name\":{},\"hits\":{},\"misses\":{}}}",
+                              i == 0 ? "" : ",", JsonString(names_[i]),
+                              served[i], misses[i]);
+      }
+      fmt::print(json_,
+                 "{{\"trace\":{},\"elapsed_s\":{:.3f},\"ops\":{},"
+                 "\"fraction\":{},\"mops\":{:.3f},\"avg_mops\":{:.3f},"
+                 "\"eta_s\":{},\"amat\":{:.3f},\"levels\":[{}],"
+                 "\"final\":{}}}\n",
+                 JsonString(label_), elapsed, ops,
+                 known ? fmt::format("{:.4f}", fraction) : "null", mops,
+                 avg_mops, known ? fmt::format("{:.1f}", eta) : "null", amat,
+                 levels, final);
+      std::fflush(json_);
+      return;
+    }
+
+    std::string rates;
+    for (size_t i = 0; i + 1 < Levels; ++i) {
+      const uint64_t accesses = served[i] + misses[i];
+      rates += fmt::format(" {} {:.1f}%", names_[i],
+                           accesses > 0 ? 100.0 * served[i] / accesses : 0.0);
+    }
+    const std::string where =
+        known ? fmt::format(" ({:.1f}%)", 100.0 * fraction) : "";
+    const std::string when =
+        final ? fmt::format("done in {}", FormatDuration(elapsed))
+              : known ? fmt::format("ETA {}", FormatDuration(eta))
+                      : "ETA unknown";
+    fmt::print(stderr,
+               "[progress] {}: {:.1f}M ops{} | {:.2f} Mops/s (avg {:.2f}) | "
+               "{} | AMAT {:.1f} |{}\n",
+               label_, ops / 1e6, where, final ? avg_mops : mops, avg_mops,
+               when, amat, rates);
+  }
+
+  static double Seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+  }
+
+  static std::string FormatDuration(double seconds) {
+    const auto s = static_cast<uint64_t>(seconds + 0.5);
+    if (s >= 3600) {
+      return fmt::format("{}h{:02}m{:02}s", s / 3600, s / 60 % 60, s % 60);
+    }
+    if (s >= 60) return fmt::format("{}m{:02}s", s / 60, s % 60);
+    return fmt::format("{:.1f}s", seconds);
+  }
+};
+
+}  // namespace stratum
+
+#endif  // PROGRESS_HPP
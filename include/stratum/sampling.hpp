@@ -0,0 +1,370 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef SAMPLING_HPP
+#define SAMPLING_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/cache_sim.hpp"
+#include "stratum/simulation.hpp"
+#include "stratum/trace_parser.hpp"
+
+namespace stratum {
+
+// Operations [begin, end) of the trace are measured; `weight` is the share
+// of the whole program the interval stands for.
+struct SampleWindow {
+  uint64_t begin = 0;
+  uint64_t end = 0;
+  double weight = 1.0;
+};
+
+// Which operations of a trace are measured, warmed or skipped.
+//
+// Before each measured window, `warmup` operations are simulated without
+// recording statistics. With functional warming every other operation is
+// simulated the same way, so the caches enter each window fully warm.
+// Without it those operations are skipped entirely: faster, but large
+// levels start each window partly cold.
+class SampleSchedule {
+  uint64_t period_ = 0;  // 0: explicit windows
+  uint64_t interval_ = 0;
+  std::vector<SampleWindow> windows_;
+  uint64_t warmup_ = 0;
+  bool functional_warming_ = true;
+
+ public:
+  // SMARTS-style periodic sampling: the last `interval` operations of every
+  // `period` are measured, all with equal weight.
+  static SampleSchedule Periodic(uint64_t period, uint64_t interval,
+                                 uint64_t warmup,
+                                 bool functional_warming = true) {
+    SampleSchedule s;
+    s.period_ = std::max<uint64_t>(period, 1);
+    s.interval_ = std::clamp<uint64_t>(interval, 1, s.period_);
+    s.warmup_ = warmup;
+    s.functional_warming_ = functional_warming;
+    return s;
+  }
+
+  // Explicit (e.g. SimPoint) windows; overlapping windows are merged into
+  // the earlier one.
+  static SampleSchedule Windows(std::vector<SampleWindow> windows,
+                                uint64_t warmup,
+                                bool functional_warming = true) {
+    std::sort(windows.begin(), windows.end(),
+              [](const SampleWindow& a, const SampleWindow& b) {
+                return a.begin < b.begin;
+              });
+    SampleSchedule s;
+    for (const auto& w : windows) {
+      if (w.end <= w.begin) continue;
+      if (!s.windows_.empty() && w.begin < s.windows_.back().end) {
+        s.windows_.back().end = std::max(s.windows_.back().end, w.end);
+        s.windows_.back().weight += w.weight;
+      } else {
+        s.windows_.push_back(w);
+      }
+    }
+    s.warmup_ = warmup;
+    s.functional_warming_ = functional_warming;
+    return s;
+  }
+
+  // The k-th measured window in trace order, or nullopt past the last one.
+  [[nodiscard]] std::optional<SampleWindow> Window(size_t k) const {
+    if (period_ != 0) {
+      const uint64_t end = (k + 1) * period_;
+      return SampleWindow{end - interval_, end, 1.0};
+    }
+    if (k < windows_.size()) return windows_[k];
+    return std::nullopt;
+  }
+
+  [[nodiscard]] uint64_t Warmup() const { return warmup_; }
+  [[nodiscard]] bool FunctionalWarming() const { return functional_warming_; }
+};
+
+// Reads SimPoint output: a .simpoints file of "<interval> <cluster>" lines
+// and a .weights file of "<weight> <cluster>" lines. Interval i covers
+// operations [i * interval_size, (i + 1) * interval_size).
+inline std::optional<SampleSchedule> LoadSimPointSchedule(
+    const std::string& simpoints_path, const std::string& weights_path,
+    uint64_t interval_size, uint64_t warmup, bool functional_warming = true) {
+  std::ifstream simpoints(simpoints_path);
+  std::ifstream weights(weights_path);
+  if (!simpoints || !weights || interval_size == 0) {
+    fmt::print(stderr, "Error: Could not read SimPoints {} / {}\n",
+               simpoints_path, weights_path);
+    return std::nullopt;
+  }
+
+  std::map<uint64_t, double> weight_of;
+  double weight;
+  uint64_t cluster;
+  while (weights >> weight >> cluster) weight_of[cluster] = weight;
+
+  std::vector<SampleWindow> windows;
+  uint64_t interval;
+  while (simpoints >> interval >> cluster) {
+    auto it = weight_of.find(cluster);
+    if (it == weight_of.end()) {
+      fmt::print(stderr, "Error: No weight for SimPoint cluster {}\n",
+                 cluster);
+      return std::nullopt;
+    }
+    windows.push_back({interval * interval_size,
+                       (interval + 1) * interval_size, it->second});
+  }
+  if (windows.empty()) {
+    fmt::print(stderr, "Error: No SimPoints in {}\n", simpoints_path);
+    return std::nullopt;
+  }
+  return SampleSchedule::Windows(std::move(windows), warmup,
+                                 functional_warming);
+}
+
+// Mean of a sampled metric and the half-width of its 95% confidence
+// interval (NaN when fewer than two samples carry weight).
+struct SampleEstimate {
+  double mean = 0.0;
+  double half_width = std::numeric_limits<double>::quiet_NaN();
+};
+
+// Weighted mean with a normal-approximation confidence interval. Unequal
+// weights use Kish's effective sample size, so for SimPoint schedules the
+// interval describes the spread between representatives rather than a
+// strict sampling error.
+inline SampleEstimate EstimateMean(std::span<const double> values,
+                                   std::span<const double> weights) {
+  SampleEstimate e;
+  double sum_w = 0.0;
+  double sum_w2 = 0.0;
+  double sum_wx = 0.0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    sum_w += weights[i];
+    sum_w2 += weights[i] * weights[i];
+    sum_wx += weights[i] * values[i];
+  }
+  if (sum_w <= 0.0) return e;
+  e.mean = sum_wx / sum_w;
+
+  const double n_eff = sum_w * sum_w / sum_w2;
+  if (n_eff <= 1.0) return e;
+  double sum_wd2 = 0.0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    const double d = values[i] - e.mean;
+    sum_wd2 += weights[i] * d * d;
+  }
+  const double variance = sum_wd2 / sum_w * n_eff / (n_eff - 1.0);
+  constexpr double kZ95 = 1.959964;
+  e.half_width = kZ95 * std::sqrt(variance / n_eff);
+  return e;
+}
+
+// Counts of one measured window: just what the estimators need, so a run
+// with many windows stays small.
+template <size_t Levels>
+struct SampleWindowStats {
+  uint64_t accesses = 0;
+  uint64_t cycles = 0;
+  std::array<uint64_t, Levels> hits{};  // by hit level
+
+  void Record(const AccessResult& res) noexcept {
+    ++accesses;
+    cycles += res.total_cycles;
+    ++hits[res.hit_level];
+  }
+
+  // Hits and misses of `level`, as SimulationStats::Level derives them.
+  [[nodiscard]] CacheStats Level(size_t level) const {
+    CacheStats s;
+    s.hits = hits[level];
+    for (size_t below = level + 1; below < Levels; ++below) {
+      s.misses += hits[below];
+    }
+    return s;
+  }
+};
+
+// Outcome of a sampled run over a hierarchy of `Levels` levels.
+template <size_t Levels>
+struct SampledRun {
+  SimulationStats<Levels> measured;  // every measured access
+  std::vector<SampleWindowStats<Levels>> windows;
+  std::vector<double> weights;
+  uint64_t total_ops = 0;      // operations read from the trace
+  uint64_t simulated_ops = 0;  // operations driven through the hierarchy
+
+  // Average memory access time per access.
+  [[nodiscard]] SampleEstimate Amat() const {
+    std::vector<double> values;
+    std::vector<double> used;
+    for (size_t k = 0; k < windows.size(); ++k) {
+      values.push_back(static_cast<double>(windows[k].cycles) /
+                       windows[k].accesses);
+      used.push_back(weights[k]);
+    }
+    return EstimateMean(values, used);
+  }
+
+  // Local hit rate of `level`: hits over the accesses that reached it.
+  [[nodiscard]] SampleEstimate HitRate(size_t level) const {
+    std::vector<double> values;
+    std::vector<double> used;
+    for (size_t k = 0; k < windows.size(); ++k) {
+      const auto s = windows[k].Level(level);
+      if (s.hits + s.misses == 0) continue;
+      values.push_back(static_cast<double>(s.hits) / (s.hits + s.misses));
+      used.push_back(weights[k]);
+    }
+    return EstimateMean(values, used);
+  }
+};
+
+// Replays `reader` through `system` following `schedule`. Measured
+// operations go through the same Load/Store (batched) path as a full run;
+// warmup operations skip the statistics bookkeeping.
+template <typename Reader, typename CacheSystem>
+SampledRun<CacheSystem::kLevels> SimulateSampled(
+    Reader& reader, CacheSystem& system, const SampleSchedule& schedule) {
+  SampledRun<CacheSystem::kLevels> run;
+  SampleWindowStats<CacheSystem::kLevels> current;
+  std::vector<TraceOp> batch;
+  std::vector<AccessResult> results;
+  batch.reserve(kTraceBatchSize);
+
+  size_t k = 0;
+  std::optional<SampleWindow> window = schedule.Window(0);
+  auto close_window = [&] {
+    if (current.accesses != 0) {
+      run.windows.push_back(current);
+      run.weights.push_back(window->weight);
+    }
+    current = {};
+  };
+  auto warm = [](const TraceOp&, const AccessResult&) {};
+  auto measure = [&](const TraceOp& op, const AccessResult& res) {
+    run.measured.Record(op, res);
+    current.Record(res);
+  };
+
+  while (reader.ReadBatch(batch) > 0) {
+    const std::span<const TraceOp> ops(batch);
+    const uint64_t base = run.total_ops;
+    run.total_ops += ops.size();
+
+    size_t i = 0;
+    while (i < ops.size()) {
+      const uint64_t pos = base + i;
+      while (window && pos >= window->end) {
+        close_window();
+        window = schedule.Window(++k);
+      }
+
+      uint64_t stop;  // end (in trace positions) of the current phase
+      bool simulate = schedule.FunctionalWarming();
+      bool measured = false;
+      if (!window) {
+        if (!simulate) return run;  // nothing more to measure or warm
+        stop = run.total_ops;
+      } else if (pos >= window->begin) {
+        stop = window->end;
+        simulate = measured = true;
+      } else if (pos + schedule.Warmup() >= window->begin) {
+        stop = window->begin;
+        simulate = true;
+      } else {
+        stop = window->begin - schedule.Warmup();
+      }
+
+      const size_t n = std::min<uint64_t>(stop, run.total_ops) - pos;
+      if (simulate) {
+        const auto part = ops.subspan(i, n);
+        if (measured) {
+          ReplayOps(part, system, results, measure);
+        } else {
+          ReplayOps(part, system, results, warm);
+        }
+        run.simulated_ops += n;
+      }
+      i += n;
+    }
+  }
+  if (window) close_window();  // a final, possibly partial window
+  return run;
+}
+
+// Prints the estimates of a sampled run, one row per level.
+template <size_t Levels>
+void PrintSampledReport(const SampledRun<Levels>& run,
+                        const std::array<std::string_view, Levels>& names) {
+  auto format = [](const SampleEstimate& e, double scale) {
+    if (std::isnan(e.half_width)) return fmt::format("{:.2f}", e.mean * scale);
+    return fmt::format("{:.2f} +/- {:.2f}", e.mean * scale,
+                       e.half_width * scale);
+  };
+
+  fmt::print("\n=== Sampled Results ({} windows, {} of {} ops measured, {} "
+             "simulated) ===\n",
+             run.windows.size(), run.measured.Accesses(), run.total_ops,
+             run.simulated_ops);
+  if (run.windows.empty()) {
+    fmt::print("No measured windows\n");
+    return;
+  }
+  fmt::print("{:<15} {:>24}\n", "Level", "Hit Rate % (95% CI)");
+  for (size_t i = 0; i < Levels; ++i) {
+    fmt::print("{:<15} {:>24}\n", names[i], format(run.HitRate(i), 100.0));
+  }
+  fmt::print("{:<15} {:>24}\n", "AMAT (cyc)", format(run.Amat(), 1.0));
+  run.measured.PrintLatencyDistribution(names);
+}
+
+// Sampled counterpart of RunTraceSimulation: replays `filepath` following
+// `schedule` and prints AMAT and per-level hit rates with confidence
+// intervals.
+//
+// Example:
+//   RunSampledTraceSimulation<L1Type>(
+//       "Huge", "huge.bin", SampleSchedule::Periodic(1'000'000, 10'000,
+//                                                    /*warmup=*/0));
+template <typename CacheSystem>
+SampledRun<CacheSystem::kLevels> RunSampledTraceSimulation(
+    const std::string& trace_name, const std::string& filepath,
+    const SampleSchedule& schedule, size_t mem_latency = 100) {
+  fmt::print("\n=========================================================\n");
+  fmt::print("Running Sampled Simulation: {} ({})\n", trace_name, filepath);
+  fmt::print("=========================================================\n");
+
+  auto cache_system = std::make_unique<CacheSystem>(mem_latency);
+  SampledRun<CacheSystem::kLevels> run;
+  if (IsBinaryTraceFile(filepath)) {
+    BinaryTraceReader reader(filepath);
+    run = SimulateSampled(reader, *cache_system, schedule);
+  } else {
+    MappedTraceReader reader(filepath);
+    run = SimulateSampled(reader, *cache_system, schedule);
+  }
+
+  PrintSampledReport(run, HierarchyNames<CacheSystem>());
+  return run;
+}
+
+}  // namespace stratum
+
+#endif  // SAMPLING_HPP
@@ -0,0 +1,222 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef SET_SAMPLING_HPP
+#define SET_SAMPLING_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+
+#include "stratum/geometry.hpp"
+
+namespace stratum {
+
+// Set samplers: the last Cache template parameter. A sampled level keeps
+// state for a fixed subset of its sets only, stored compactly (tag, dirty,
+// policy and prefetch arrays hold the sampled sets alone), and an access
+// to any other set does no tag work there: it passes through to the next
+// level as if this level were not present, uncounted. The level's figures
+// for the whole cache are then estimated from the sampled sets (see
+// Cache::SampledStats and PrintSetSamplingReport).
+//
+// The sampled sets see exactly the accesses they see in a full run, so
+// their hit/miss behavior is exact, and the estimates are unbiased for
+// set-local replacement. Levels below a sampled one see the passed-through
+// accesses as well, so their counters (and the hierarchy-wide AMAT of
+// SimulationStats) describe a hierarchy whose sampled level is missing the
+// other sets; sample the last level cache to keep that to main memory.
+//
+// Sampler interface
+//
+//   static constexpr std::string_view kName;  // part of Cache::Signature
+//   static constexpr bool kEnabled;           // false only for NoSetSampling
+//   static constexpr size_t kRatio;           // one set in kRatio is kept
+//   static constexpr size_t kOffset;
+//   template <size_t Sets> static constexpr size_t SampledSets();
+//   template <size_t Sets> static constexpr uint64_t Slot(uint64_t set);
+//   template <size_t Sets> static constexpr uint64_t SetOf(uint64_t slot);
+//
+// Slot maps a set index to its index in the compact arrays, or to
+// kUnsampledSet; SetOf is its inverse on sampled sets.
+
+inline constexpr uint64_t kUnsampledSet = ~uint64_t{0};
+
+// Default: every set is simulated.
+struct NoSetSampling {
+  static constexpr std::string_view kName{"all"};
+  static constexpr bool kEnabled = false;
+  static constexpr size_t kRatio = 1;
+  static constexpr size_t kOffset = 0;
+
+  template <size_t Sets>
+  static constexpr size_t SampledSets() {
+    return Sets;
+  }
+  template <size_t Sets>
+  static constexpr uint64_t Slot(uint64_t set) noexcept {
+    return set;
+  }
+  template <size_t Sets>
+  static constexpr uint64_t SetOf(uint64_t slot) noexcept {
+    return slot;
+  }
+};
+
+// Keeps the sets with set % Ratio == Offset. Sets must be a multiple of
+// Ratio. Strided, so a workload whose hot sets share a stride with Ratio
+// is over- or under-represented; HashSetSampling avoids that.
+template <size_t Ratio, size_t Offset = 0>
+struct ModuloSetSampling {
+  static_assert(Ratio > 0 && Offset < Ratio);
+  static constexpr std::string_view kName{"modulo"};
+  static constexpr bool kEnabled = true;
+  static constexpr size_t kRatio = Ratio;
+  static constexpr size_t kOffset = Offset;
+
+  template <size_t Sets>
+  static constexpr size_t SampledSets() {
+    static_assert(Sets % Ratio == 0,
+                  "ModuloSetSampling: Sets must be a multiple of Ratio");
+    return Sets / Ratio;
+  }
+  template <size_t Sets>
+  static constexpr uint64_t Slot(uint64_t set) noexcept {
+    if constexpr (IsPowerOfTwo(Ratio)) {
+      if ((set & (Ratio - 1)) != Offset) return kUnsampledSet;
+      return set >> Log2(Ratio);
+    } else {
+      if (set % Ratio != Offset) return kUnsampledSet;
+      return set / Ratio;
+    }
+  }
+  template <size_t Sets>
+  static constexpr uint64_t SetOf(uint64_t slot) noexcept {
+    return slot * Ratio + Offset;
+  }
+};
+
+// Keeps a pseudo-random 1 / Ratio of the sets: those whose index, scrambled
+// by an odd multiplier modulo Sets, falls below Sets / Ratio. The scramble
+// is a bijection, so the scrambled index is the compact slot and SetOf
+// undoes it with the multiplier's inverse. Sets and Ratio must be powers
+// of two.
+template <size_t Ratio>
+struct HashSetSampling {
+  static_assert(Ratio > 0 && IsPowerOfTwo(Ratio),
+                "HashSetSampling: Ratio must be a power of two");
+  static constexpr std::string_view kName{"hash"};
+  static constexpr bool kEnabled = true;
+  static constexpr size_t kRatio = Ratio;
+  static constexpr size_t kOffset = 0;
+
+  static constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ULL;
+
+  // kMultiplier * kInverse == 1 (mod 2^64), by Newton iteration.
+  static constexpr uint64_t kInverse = [] {
+    uint64_t x = kMultiplier;
+    for (int i = 0; i < 6; ++i) x *= 2 - kMultiplier * x;
+    return x;
+  }();
+  static_assert(kMultiplier * kInverse == 1);
+
+  template <size_t Sets>
+  static constexpr size_t SampledSets() {
+    static_assert(IsPowerOfTwo(Sets) && Sets >= Ratio,
+                  "HashSetSampling: Sets must be a power of two >= Ratio");
+    return Sets / Ratio;
+  }
+  template <size_t Sets>
+  static constexpr uint64_t Slot(uint64_t set) noexcept {
+    const uint64_t scrambled = (set * kMultiplier) & (Sets - 1);
+    return scrambled < Sets / Ratio ? scrambled : kUnsampledSet;
+  }
+  template <size_t Sets>
+  static constexpr uint64_t SetOf(uint64_t slot) noexcept {
+    return (slot * kInverse) & (Sets - 1);
+  }
+};
+
+// Demand accesses and misses of one sampled set.
+struct SampledSetCounts {
+  uint64_t accesses = 0;
+  uint64_t misses = 0;
+};
+
+// An estimate and the half-width of its 95% confidence interval (NaN with
+// fewer than two sampled sets).
+struct SetSampleEstimate {
+  double value = 0.0;
+  double half_width = std::numeric_limits<double>::quiet_NaN();
+};
+
+// Whole-cache figures of a sampled level.
+struct SetSampledStats {
+  std::string_view name;
+  size_t sampled_sets = 0;
+  size_t sets = 0;
+  double scale = 1.0;  // sets / sampled_sets, for scaling other counters
+  uint64_t sampled_accesses = 0;
+  uint64_t sampled_misses = 0;
+  SetSampleEstimate accesses;
+  SetSampleEstimate misses;
+  SetSampleEstimate miss_ratio;
+};
+
+// Estimates from the per-set counts of `sets`' sampled subset, treating
+// the sampled sets as a simple random sample of the cache's sets (with the
+// finite population correction). Totals scale the sample mean by `sets`;
+// the miss ratio is the ratio estimator sum(misses) / sum(accesses).
+inline SetSampledStats EstimateSetSample(
+    std::string_view name, std::span<const SampledSetCounts> counts,
+    size_t sets) {
+  SetSampledStats s;
+  s.name = name;
+  s.sampled_sets = counts.size();
+  s.sets = sets;
+  if (counts.empty()) return s;
+
+  const double n = static_cast<double>(counts.size());
+  s.scale = static_cast<double>(sets) / n;
+  for (const auto& c : counts) {
+    s.sampled_accesses += c.accesses;
+    s.sampled_misses += c.misses;
+  }
+  const double mean_a = static_cast<double>(s.sampled_accesses) / n;
+  const double mean_m = static_cast<double>(s.sampled_misses) / n;
+  const double ratio = s.sampled_accesses == 0 ? 0.0 : mean_m / mean_a;
+  s.accesses.value = mean_a * static_cast<double>(sets);
+  s.misses.value = mean_m * static_cast<double>(sets);
+  s.miss_ratio.value = ratio;
+  if (counts.size() < 2) return s;
+
+  double ss_a = 0.0;
+  double ss_m = 0.0;
+  double ss_r = 0.0;
+  for (const auto& c : counts) {
+    const double a = static_cast<double>(c.accesses);
+    const double m = static_cast<double>(c.misses);
+    ss_a += (a - mean_a) * (a - mean_a);
+    ss_m += (m - mean_m) * (m - mean_m);
+    ss_r += (m - ratio * a) * (m - ratio * a);
+  }
+  constexpr double kZ95 = 1.959964;
+  const double fpc = 1.0 - n / static_cast<double>(sets);
+  const double total = static_cast<double>(sets);
+  auto total_half_width = [&](double ss) {
+    return kZ95 * total * std::sqrt(fpc * ss / (n - 1.0) / n);
+  };
+  s.accesses.half_width = total_half_width(ss_a);
+  s.misses.half_width = total_half_width(ss_m);
+  s.miss_ratio.half_width =
+      mean_a == 0.0
+          ? 0.0
+          : kZ95 * std::sqrt(fpc * ss_r / (n - 1.0) / n) / mean_a;
+  return s;
+}
+
+}  // namespace stratum
+
+#endif  // SET_SAMPLING_HPP
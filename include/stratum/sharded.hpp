@@ -0,0 +1,270 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef SHARDED_HPP
+#define SHARDED_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/cache_sim.hpp"
+#include "stratum/geometry.hpp"
+#include "stratum/parallel.hpp"
+#include "stratum/simulation.hpp"
+#include "stratum/spsc_queue.hpp"
+#include "stratum/trace_parser.hpp"
+
+namespace stratum {
+
+// Upper bound on shards per run. Every power of two up to it is one
+// instantiation of the sharded hierarchy, so this also bounds compile time.
+inline constexpr size_t kShardLimit = 64;
+
+// Operations handed to a shard per queue transfer.
+inline constexpr size_t kShardChunk = 1024;
+
+// How the hierarchy rooted at `Top` splits into independent set shards.
+//
+// The shard of an address is taken from address bits [kShift, kShift +
+// log2(kMaxShards)), chosen to lie inside the set index of every level. Two
+// addresses that share a set anywhere in the hierarchy therefore share a
+// shard, and so do the writebacks they cause, so shards never touch the
+// same state. Compact() drops the shard bits from an address: within one
+// shard that maps each level's sets onto Sets / Shards consecutive sets and
+// leaves tags unchanged, which lets a worker run Top::Sharded<Shards>
+// instead of a full-size hierarchy.
+//
+// Sharding needs power-of-two geometries; otherwise kMaxShards is 1.
+template <typename Top>
+class ShardGeometry {
+  struct Bits {
+    bool pow2 = true;
+    unsigned lo = 0;   // highest offset width over all levels
+    unsigned hi = 64;  // lowest offset + set width over all levels
+  };
+
+  static constexpr Bits Compute() {
+    Bits bits;
+    for (const auto& level : HierarchyInfo<Top>()) {
+      if (level.is_memory) continue;
+      if (!IsPowerOfTwo(level.sets) || !IsPowerOfTwo(level.block_size)) {
+        bits.pow2 = false;
+        continue;
+      }
+      const unsigned offset = Log2(level.block_size);
+      bits.lo = std::max(bits.lo, offset);
+      bits.hi = std::min(bits.hi, offset + Log2(level.sets));
+    }
+    return bits;
+  }
+
+  static constexpr Bits kBits = Compute();
+
+ public:
+  static constexpr unsigned kShift = kBits.lo;
+  static constexpr size_t kMaxShards =
+      kBits.pow2 && Top::kLevels > 1 && kBits.hi > kBits.lo
+          ? size_t{1} << std::min(kBits.hi - kBits.lo, Log2(kShardLimit))
+          : 1;
+
+  static constexpr size_t Shard(uint64_t addr, size_t shards) noexcept {
+    return (addr >> kShift) & (shards - 1);
+  }
+
+  template <size_t Shards>
+  static constexpr uint64_t Compact(uint64_t addr) noexcept {
+    constexpr unsigned kShardBits = Log2(Shards);
+    const uint64_t offset = addr & ((uint64_t{1} << kShift) - 1);
+    return offset | ((addr >> (kShift + kShardBits)) << kShift);
+  }
+};
+
+// Outcome of a sharded run, in the same shape RunTraceSimulation reports.
+template <size_t Levels>
+struct ShardedRun {
+  SimulationStats<Levels> stats;
+  std::vector<AccessResult> log_history;
+  std::vector<uint64_t> log_addrs;
+  size_t shards = 1;
+};
+
+namespace detail {
+
+template <typename CacheSystem, size_t Shards, typename Reader>
+ShardedRun<CacheSystem::kLevels> SimulateShards(Reader& reader,
+                                                size_t mem_latency) {
+  using Geometry = ShardGeometry<CacheSystem>;
+  using ShardSystem = typename CacheSystem::template Sharded<Shards>;
+  constexpr size_t kLevels = CacheSystem::kLevels;
+
+  struct Worker {
+    std::unique_ptr<ShardSystem> system;
+    SimulationStats<kLevels> stats;
+    std::vector<AccessResult> log;
+    SpscQueue<TraceOp> queue{16 * kShardChunk};
+  };
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (size_t s = 0; s < Shards; ++s) {
+    workers.push_back(std::make_unique<Worker>());
+    workers.back()->system = std::make_unique<ShardSystem>(mem_latency);
+  }
+
+  // Each worker replays its shard in trace order; only the first
+  // kAccessLogLimit + 1 results of a shard can belong to the global log.
+  auto consume = [](Worker& w) {
+    std::vector<TraceOp> chunk(kShardChunk);
+    std::vector<AccessResult> results(kShardChunk);
+    for (;;) {
+      const size_t n = w.queue.PopSome(chunk);
+      if (n == 0) {
+        if (w.queue.Drained()) break;
+        std::this_thread::yield();
+        continue;
+      }
+      const std::span<const TraceOp> ops(chunk.data(), n);
+      if constexpr (requires { w.system->AccessBatch(ops, results); }) {
+        w.system->AccessBatch(ops, results);
+      } else {
+        for (size_t i = 0; i < n; ++i) {
+          results[i] = ops[i].type == 'L' ? w.system->Load(ops[i].addr)
+                                          : w.system->Store(ops[i].addr);
+        }
+      }
+      for (size_t i = 0; i < n; ++i) {
+        w.stats.Record(ops[i], results[i]);
+        if (w.log.size() <= kAccessLogLimit) w.log.push_back(results[i]);
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (auto& w : workers) threads.emplace_back(consume, std::ref(*w));
+
+  ShardedRun<kLevels> run;
+  run.shards = Shards;
+  std::vector<size_t> log_shards;
+
+  std::array<std::vector<TraceOp>, Shards> staging;
+  auto flush = [&](size_t s) {
+    std::span<const TraceOp> rest(staging[s]);
+    while (!rest.empty()) {
+      const size_t n = workers[s]->queue.PushSome(rest);
+      rest = rest.subspan(n);
+      if (n == 0) std::this_thread::yield();
+    }
+    staging[s].clear();
+  };
+
+  std::vector<TraceOp> batch;
+  batch.reserve(kTraceBatchSize);
+  while (reader.ReadBatch(batch) > 0) {
+    for (const auto& op : batch) {
+      const size_t s = Geometry::Shard(op.addr, Shards);
+      if (run.log_addrs.size() <= kAccessLogLimit) {
+        run.log_addrs.push_back(op.addr);
+        log_shards.push_back(s);
+      }
+      staging[s].push_back(
+          {op.type, Geometry::template Compact<Shards>(op.addr)});
+      if (staging[s].size() == kShardChunk) flush(s);
+    }
+  }
+  for (size_t s = 0; s < Shards; ++s) {
+    flush(s);
+    workers[s]->queue.Close();
+  }
+  for (auto& t : threads) t.join();
+
+  // Merge in shard order, so the result does not depend on scheduling.
+  std::array<size_t, Shards> taken{};
+  for (size_t s : log_shards) {
+    run.log_history.push_back(workers[s]->log[taken[s]++]);
+  }
+  for (const auto& w : workers) run.stats.Merge(w->stats);
+  return run;
+}
+
+// Calls fn.template operator()<S>() with S the largest power of two that is
+// at most `shards`, capped at `Max`.
+template <size_t Max, size_t S = 1, typename Fn>
+auto WithShardCount(size_t shards, Fn&& fn) {
+  if constexpr (S * 2 <= Max) {
+    if (shards >= S * 2) {
+      return WithShardCount<Max, S * 2>(shards, std::forward<Fn>(fn));
+    }
+  }
+  return fn.template operator()<S>();
+}
+
+}  // namespace detail
+
+// Replays `reader` through CacheSystem split into set shards, one worker
+// thread per shard (at most `threads`, 0 = one per hardware thread).
+//
+// The calling thread parses the trace and routes every operation to its
+// shard's SPSC queue, so operations on any one set keep their trace order.
+// Each worker owns a CacheSystem::Sharded<N> that holds only its own sets
+// at every level; misses and writebacks stay within the worker. Statistics
+// are merged in shard order at the end.
+//
+// For set-local policies (HierarchyIsSetLocal) the result is identical to
+// the serial run. Policies with cross-set state (Random, BRRIP, DRRIP) see
+// each shard separately, so their results only approximate it.
+template <typename CacheSystem, typename Reader>
+ShardedRun<CacheSystem::kLevels> SimulateSharded(Reader& reader,
+                                                 size_t threads = 0,
+                                                 size_t mem_latency = 100) {
+  constexpr size_t kMax = ShardGeometry<CacheSystem>::kMaxShards;
+  if (threads == 0) threads = DefaultThreadCount();
+  return detail::WithShardCount<kMax>(threads, [&]<size_t Shards>() {
+    return detail::SimulateShards<CacheSystem, Shards>(reader, mem_latency);
+  });
+}
+
+// Sharded counterpart of RunTraceSimulation with the same report.
+//
+// Example:
+//   RunShardedTraceSimulation<L1Type>("Random", "traces/random.bin", 16);
+template <typename CacheSystem>
+void RunShardedTraceSimulation(const std::string& trace_name,
+                               const std::string& filepath,
+                               size_t threads = 0, size_t mem_latency = 100) {
+  fmt::print("\n=========================================================\n");
+  fmt::print("Running Simulation: {} ({})\n", trace_name, filepath);
+  fmt::print("=========================================================\n");
+
+  auto run = [&](auto& reader) {
+    auto result = SimulateSharded<CacheSystem>(reader, threads, mem_latency);
+    fmt::print("Sharded by set across {} workers\n", result.shards);
+    if (!HierarchyIsSetLocal<CacheSystem>() && result.shards > 1) {
+      fmt::print("Note: policies with cross-set state make sharded results "
+                 "approximate\n");
+    }
+    PrintSimulationReport(trace_name, result.stats,
+                          HierarchyNames<CacheSystem>(), result.log_history,
+                          result.log_addrs);
+  };
+
+  // Binary traces (see binary_trace.hpp) are detected by their magic.
+  if (IsBinaryTraceFile(filepath)) {
+    BinaryTraceReader reader(filepath);
+    run(reader);
+  } else {
+    MappedTraceReader reader(filepath);
+    run(reader);
+  }
+}
+
+}  // namespace stratum
+
+#endif  // SHARDED_HPP
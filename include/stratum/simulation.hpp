@@ -5,86 +5,190 @@
 
 #include <fmt/core.h>
 
+#include <array>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "stratum/binary_trace.hpp"
 #include "stratum/cache_sim.hpp"
+#include "stratum/progress.hpp"
 #include "stratum/trace_parser.hpp"
 
 namespace stratum {
 
+// Maximum number of accesses kept for the detailed access log.
+inline constexpr size_t kAccessLogLimit = 20;
+
+// Simulates `ops` in order through `system`, calling on_access(op, result)
+// after each access. `results` is scratch space reused across calls.
+template <typename CacheSystem, typename OnAccess>
+void ReplayOps(std::span<const TraceOp> ops, CacheSystem& system,
+               std::vector<AccessResult>& results, OnAccess&& on_access) {
+  // Levels with a batched entry point prefetch their state ahead.
+  if constexpr (requires { system.AccessBatch(ops, results); }) {
+    results.resize(ops.size());
+    system.AccessBatch(ops, results);
+    for (size_t i = 0; i < ops.size(); ++i) on_access(ops[i], results[i]);
+  } else {
+    for (const auto& op : ops) {
+      AccessResult res;
+      if (op.type == 'L') {
+        res = system.Load(op.addr);
+      } else {
+        res = system.Store(op.addr);
+      }
+      on_access(op, res);
+    }
+  }
+}
+
+// Drives every operation from `reader` (anything with the ReadBatch contract
+// of MappedTraceReader) through `system`, calling on_access(op, result)
+// after each access and on_batch() after each batch (e.g. to publish
+// ProgressCounters).
+template <typename Reader, typename CacheSystem, typename OnAccess,
+          typename OnBatch>
+void ReplayTrace(Reader& reader, CacheSystem& system, OnAccess&& on_access,
+                 OnBatch&& on_batch) {
+  std::vector<TraceOp> batch;
+  std::vector<AccessResult> results;
+  batch.reserve(kTraceBatchSize);
+  while (reader.ReadBatch(batch) > 0) {
+    ReplayOps(std::span<const TraceOp>(batch), system, results, on_access);
+    on_batch();
+  }
+}
+
+template <typename Reader, typename CacheSystem, typename OnAccess>
+void ReplayTrace(Reader& reader, CacheSystem& system, OnAccess&& on_access) {
+  ReplayTrace(reader, system, on_access, [] {});
+}
+
+// Prints the aggregated statistics of a finished run and, for traces of at
+// most kAccessLogLimit operations, the detailed access log.
+template <size_t Levels>
+void PrintSimulationReport(const std::string& trace_name,
+                           const SimulationStats<Levels>& stats,
+                           const std::array<std::string_view, Levels>& names,
+                           const std::vector<AccessResult>& log_history,
+                           const std::vector<uint64_t>& log_addrs) {
+  if (stats.Accesses() == 0) {
+    fmt::print("No operations to simulate for {}\n", trace_name);
+    return;
+  }
+
+  // Print aggregated statistics (hits, misses, latency per level).
+  stats.Print(names);
+  stats.PrintLatencyDistribution(names);
+
+  // Print detailed access log only for small traces.
+  if (stats.Accesses() <= kAccessLogLimit) {
+    PrintAccessLog(log_history, log_addrs, names);
+  } else {
+    fmt::print("\n(Detailed history hidden for large trace: {} ops)\n",
+               stats.Accesses());
+  }
+}
+
 // Runs a trace-driven cache simulation and prints performance statistics.
 //
 // This function simulates a complete cache hierarchy by:
-// 1. Parsing a trace file containing memory access operations
+// 1. Streaming the trace file in fixed-size batches of operations
 // 2. Executing each operation (Load/Store) through the cache system
-// 3. Recording access results (hit level, latency) for each operation
-// 4. Aggregating and printing statistics per cache level
+// 3. Accumulating statistics (hit level, latency) as it goes
+// 4. Printing statistics per cache level
+//
+// Peak memory is independent of the trace length: only one batch of
+// operations and the first kAccessLogLimit results are held at a time.
 //
 // Template Parameters:
 //   CacheSystem: Top-level cache type (e.g., L1Type). Must provide:
 //     - Constructor accepting size_t (memory latency)
 //     - Load(uint64_t addr) -> AccessResult
 //     - Store(uint64_t addr) -> AccessResult
+//     - Topology traits (kLevels, kInfo, Next), see HierarchyInfo()
 //
 // Parameters:
 //   trace_name: Human-readable name for this trace (e.g., "Sequential")
-//   filepath: Path to trace file (format: "L 0x1000" or "S 0x2000")
-//   hierarchy: Cache level names in order (e.g., {"L1", "L2", "MainMemory"})
+//   filepath: Path to trace file, either text (format: "L 0x1000" or
+//             "S 0x2000") or the binary format from binary_trace.hpp
 //   mem_latency: Main memory access latency in cycles (default: 100)
+//   progress: Live progress reports while the trace replays (see
+//             progress.hpp); by default from STRATUM_PROGRESS and
+//             STRATUM_PROGRESS_JSON, off when neither is set
 //
 // Example:
-//   RunTraceSimulation<L1Type>("Temporal", "traces/temporal.txt",
-//                              {"L1", "L2", "MainMemory"}, 200);
+//   RunTraceSimulation<L1Type>("Temporal", "traces/temporal.txt", 200);
+//
+// Level names and the number of levels come from the CacheSystem type, so
+// the statistics storage is sized at compile time.
 //
 // Output:
 //   - Simulation header with trace name and file path
 //   - Aggregated statistics (hits, misses, avg latency per level)
-//   - Detailed access log (if trace has ≤20 operations)
+//   - Detailed access log (if trace has <= kAccessLogLimit operations)
 template <typename CacheSystem>
-void RunTraceSimulation(const std::string& trace_name,
-                        const std::string& filepath,
-                        const std::vector<std::string>& hierarchy,
-                        size_t mem_latency = 100) {
+void RunTraceSimulation(
+    const std::string& trace_name, const std::string& filepath,
+    size_t mem_latency = 100,
+    const ProgressOptions& progress = ProgressOptions::FromEnv()) {
   fmt::print("\n=========================================================\n");
   fmt::print("Running Simulation: {} ({})\n", trace_name, filepath);
   fmt::print("=========================================================\n");
 
-  auto ops = ParseTraceFile(filepath);
-  if (ops.empty()) {
-    fmt::print("No operations to simulate for {}\n", trace_name);
-    return;
-  }
-
   // Initialize cache hierarchy with specified memory latency.
   // The latency parameter propagates down to MainMemory constructor.
   auto cache_system = std::make_unique<CacheSystem>(mem_latency);
 
-  std::vector<AccessResult> history;
-  std::vector<uint64_t> trace_addrs;
+  SimulationStats<CacheSystem::kLevels> stats;
 
-  // Execute all trace operations and record results.
-  for (const auto& op : ops) {
-    AccessResult res;
-    if (op.type == 'L') {
-      res = cache_system->Load(op.addr);
-    } else {
-      res = cache_system->Store(op.addr);
-    }
-    history.push_back(res);
-    trace_addrs.push_back(op.addr);
-  }
+  // Only the head of the trace is kept, for the detailed access log.
+  std::vector<AccessResult> log_history;
+  std::vector<uint64_t> log_addrs;
 
-  // Print aggregated statistics (hits, misses, latency per level).
-  PrintSimulationStats(history, hierarchy);
+  // Stream the trace batch by batch; nothing here grows with trace length.
+  // Progress is published once per batch, off the per-access path.
+  auto replay = [&](auto& reader) {
+    ProgressCounters<CacheSystem::kLevels> counters;
+    std::optional<ProgressReporter<CacheSystem::kLevels>> reporter;
+    if (progress.Enabled()) {
+      reporter.emplace(counters, trace_name, HierarchyNames<CacheSystem>(),
+                       progress);
+    }
+    ReplayTrace(
+        reader, *cache_system,
+        [&](const TraceOp& op, const AccessResult& res) {
+          stats.Record(op, res);
+          if (log_history.size() <= kAccessLogLimit) {
+            log_history.push_back(res);
+            log_addrs.push_back(op.addr);
+          }
+        },
+        [&] {
+          if (reporter) counters.Publish(stats, ReaderProgress(reader));
+        });
+  };
 
-  // Print detailed access log only for small traces (≤20 ops).
-  if (history.size() <= 20) {
-    PrintAccessLog(history, trace_addrs);
+  // Binary traces (see binary_trace.hpp) are detected by their magic.
+  if (IsBinaryTraceFile(filepath)) {
+    BinaryTraceReader reader(filepath);
+    replay(reader);
   } else {
-    fmt::print("\n(Detailed history hidden for large trace: {} ops)\n",
-               history.size());
+    MappedTraceReader reader(filepath);
+    replay(reader);
+  }
+
+  PrintSimulationReport(trace_name, stats, HierarchyNames<CacheSystem>(),
+                        log_history, log_addrs);
+  if constexpr (kInstrumentation && HierarchyHasPrefetcher<CacheSystem>()) {
+    if (stats.Accesses() > 0) PrintPrefetchReport(*cache_system);
+  }
+  if constexpr (HierarchyHasSetSampling<CacheSystem>()) {
+    if (stats.Accesses() > 0) PrintSetSamplingReport(*cache_system);
   }
 }
 
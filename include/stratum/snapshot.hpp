@@ -0,0 +1,191 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <fmt/core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace stratum {
+
+// Complete simulator state of one hierarchy (tags, dirty bits, policy state
+// and per-level counters), produced by Cache::Snapshot().
+//
+// The payload is a flat byte stream in host byte order, written and read
+// level by level through SaveState/LoadState. `signature` identifies the
+// hierarchy configuration the state belongs to (Cache::Signature()), so a
+// snapshot can only be restored into the same type.
+struct CacheSnapshot {
+  uint64_t signature = 0;
+  std::vector<std::byte> payload;
+};
+
+// Appends state to a snapshot payload.
+class SnapshotWriter {
+  std::vector<std::byte>& out_;
+
+ public:
+  explicit SnapshotWriter(std::vector<std::byte>& out) : out_(out) {}
+
+  template <typename T>
+  void Value(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Raw(&value, sizeof(T));
+  }
+
+  // Length-prefixed, so a reader catches a geometry mismatch.
+  template <typename T>
+  void Array(const T* data, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Value(uint64_t{count});
+    Raw(data, count * sizeof(T));
+  }
+
+  void String(std::string_view s) { Array(s.data(), s.size()); }
+
+ private:
+  void Raw(const void* data, size_t bytes) {
+    const auto* p = static_cast<const std::byte*>(data);
+    out_.insert(out_.end(), p, p + bytes);
+  }
+};
+
+// Reads state back in the order SnapshotWriter wrote it. Any short read or
+// length mismatch latches Ok() to false; later reads then do nothing.
+class SnapshotReader {
+  const std::vector<std::byte>& in_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+
+ public:
+  explicit SnapshotReader(const std::vector<std::byte>& in) : in_(in) {}
+
+  [[nodiscard]] bool Ok() const { return ok_; }
+  [[nodiscard]] bool AtEnd() const { return pos_ == in_.size(); }
+
+  template <typename T>
+  void Value(T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Raw(&value, sizeof(T));
+  }
+
+  template <typename T>
+  void Array(T* data, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    uint64_t stored = 0;
+    Value(stored);
+    if (stored != count) ok_ = false;
+    Raw(data, count * sizeof(T));
+  }
+
+  void String(std::string& s) {
+    uint64_t size = 0;
+    Value(size);
+    if (!ok_ || size > in_.size() - pos_) {
+      ok_ = false;
+      return;
+    }
+    s.resize(size);
+    Raw(s.data(), size);
+  }
+
+ private:
+  void Raw(void* data, size_t bytes) {
+    if (!ok_ || bytes > in_.size() - pos_) {
+      ok_ = false;
+      return;
+    }
+    std::memcpy(data, in_.data() + pos_, bytes);
+    pos_ += bytes;
+  }
+};
+
+inline constexpr uint32_t kSnapshotVersion = 1;
+
+// On-disk layout: this header followed by the payload bytes.
+struct SnapshotFileHeader {
+  char magic[4] = {'S', 'T', 'R', 'S'};
+  uint32_t version = kSnapshotVersion;
+  uint64_t signature = 0;
+  uint64_t payload_size = 0;
+};
+static_assert(sizeof(SnapshotFileHeader) == 24);
+
+// Writes `snapshot` to `path`. Returns false (with a message) on I/O error.
+inline bool SaveSnapshot(const CacheSnapshot& snapshot,
+                         const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    fmt::print(stderr, "Error: Could not create snapshot {}\n", path);
+    return false;
+  }
+  SnapshotFileHeader header;
+  header.signature = snapshot.signature;
+  header.payload_size = snapshot.payload.size();
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+            std::fwrite(snapshot.payload.data(), 1, snapshot.payload.size(),
+                        file) == snapshot.payload.size();
+  ok &= std::fclose(file) == 0;
+  if (!ok) fmt::print(stderr, "Error: Could not write snapshot {}\n", path);
+  return ok;
+}
+
+// Reads a snapshot written by SaveSnapshot; nullopt if the file is missing,
+// truncated or not a snapshot.
+inline std::optional<CacheSnapshot> LoadSnapshot(const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) return std::nullopt;
+
+  SnapshotFileHeader header;
+  CacheSnapshot snapshot;
+  bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+            std::memcmp(header.magic, "STRS", 4) == 0 &&
+            header.version == kSnapshotVersion;
+  // Check the size against the file before allocating for it.
+  const long start = ok ? std::ftell(file) : -1;
+  ok &= start >= 0 && std::fseek(file, 0, SEEK_END) == 0;
+  const long end = ok ? std::ftell(file) : -1;
+  ok &= end >= start && std::fseek(file, start, SEEK_SET) == 0 &&
+        header.payload_size <= static_cast<uint64_t>(end - start);
+  if (ok) {
+    snapshot.signature = header.signature;
+    snapshot.payload.resize(header.payload_size);
+    ok = std::fread(snapshot.payload.data(), 1, header.payload_size, file) ==
+         header.payload_size;
+  }
+  std::fclose(file);
+  if (!ok) {
+    fmt::print(stderr, "Error: Invalid snapshot file {}\n", path);
+    return std::nullopt;
+  }
+  return snapshot;
+}
+
+// FNV-1a step used to build Cache::Signature() from the configuration.
+constexpr uint64_t SignatureMix(uint64_t hash, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    hash ^= (value >> (8 * i)) & 0xFF;
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+constexpr uint64_t SignatureMix(uint64_t hash, std::string_view text) {
+  for (char c : text) hash = SignatureMix(hash, static_cast<uint8_t>(c));
+  return SignatureMix(hash, text.size());
+}
+
+inline constexpr uint64_t kSignatureSeed = 0xCBF29CE484222325ULL;
+
+}  // namespace stratum
+
+#endif  // SNAPSHOT_HPP
@@ -0,0 +1,84 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace stratum {
+
+// Bounded lock-free single-producer/single-consumer ring buffer.
+//
+// Items move in bulk (PushSome/PopSome) so one acquire/release pair is paid
+// per chunk rather than per item. Head and tail live on separate cache lines
+// and each side caches the other's index, so the shared lines are only
+// touched when the cached view says the ring is full (or empty).
+template <typename T>
+class SpscQueue {
+  static constexpr size_t kCacheLine = 64;
+
+  std::vector<T> ring_;
+  size_t mask_;
+
+  // Consumer side
+  alignas(kCacheLine) std::atomic<size_t> head_{0};
+  size_t cached_tail_ = 0;
+
+  // Producer side
+  alignas(kCacheLine) std::atomic<size_t> tail_{0};
+  size_t cached_head_ = 0;
+  std::atomic<bool> closed_{false};
+
+ public:
+  // Capacity is rounded up to a power of two.
+  explicit SpscQueue(size_t capacity)
+      : ring_(std::bit_ceil(std::max<size_t>(capacity, 2))),
+        mask_(ring_.size() - 1) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Producer: enqueues a prefix of `items`, returns how many fit.
+  size_t PushSome(std::span<const T> items) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ + items.size() > ring_.size()) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+    }
+    const size_t room = ring_.size() - (tail - cached_head_);
+    const size_t n = std::min(items.size(), room);
+    for (size_t i = 0; i < n; ++i) ring_[(tail + i) & mask_] = items[i];
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  // Producer: no more items will be pushed.
+  void Close() { closed_.store(true, std::memory_order_release); }
+
+  // Consumer: dequeues up to out.size() items, returns how many.
+  size_t PopSome(std::span<T> out) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (cached_tail_ == head) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+    }
+    const size_t n = std::min(out.size(), cached_tail_ - head);
+    for (size_t i = 0; i < n; ++i) out[i] = ring_[(head + i) & mask_];
+    head_.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer: true once the producer has closed and every item was popped.
+  [[nodiscard]] bool Drained() const {
+    return closed_.load(std::memory_order_acquire) &&
+           head_.load(std::memory_order_relaxed) ==
+               tail_.load(std::memory_order_acquire);
+  }
+};
+
+}  // namespace stratum
+
+#endif  // SPSC_QUEUE_HPP
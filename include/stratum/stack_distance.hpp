@@ -0,0 +1,220 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef STACK_DISTANCE_HPP
+#define STACK_DISTANCE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "stratum/trace_parser.hpp"
+
+namespace stratum {
+
+// Binary indexed tree over positions [0, size()): point add, prefix sum.
+class FenwickTree {
+  std::vector<uint32_t> tree_;  // 1-based
+
+ public:
+  explicit FenwickTree(size_t size = 0) : tree_(size + 1, 0) {}
+
+  [[nodiscard]] size_t size() const { return tree_.size() - 1; }
+
+  void Add(size_t pos, int32_t delta) {
+    for (size_t i = pos + 1; i < tree_.size(); i += i & (~i + 1)) {
+      tree_[i] += static_cast<uint32_t>(delta);
+    }
+  }
+
+  // Sum of positions [0, pos).
+  [[nodiscard]] uint32_t PrefixSum(size_t pos) const {
+    uint32_t sum = 0;
+    for (size_t i = pos; i > 0; i -= i & (~i + 1)) sum += tree_[i];
+    return sum;
+  }
+
+  // Rebuilds the tree with a one at each of the first `ones` positions.
+  void AssignOnes(size_t size, size_t ones) {
+    tree_.assign(size + 1, 0);
+    for (size_t i = 1; i <= size; ++i) {
+      if (i <= ones) tree_[i] += 1;
+      const size_t parent = i + (i & (~i + 1));
+      if (parent < tree_.size()) tree_[parent] += tree_[i];
+    }
+  }
+};
+
+// One LRU stack (Mattson et al.): the stack distance of an access is the
+// number of distinct blocks touched since the previous access to the same
+// block, so it hits in every LRU cache of more ways than that distance.
+//
+// Instead of walking a list, each live block is marked at the time of its
+// last access in a Fenwick tree; the distance is the number of marks after
+// that time, O(log n). When the clock reaches the tree's capacity, live
+// marks are renumbered densely, so memory tracks the number of distinct
+// blocks rather than the trace length.
+class LruStack {
+  std::unordered_map<uint64_t, uint32_t> last_access_;
+  FenwickTree marks_;
+  uint32_t now_ = 0;
+
+ public:
+  static constexpr uint64_t kColdMiss = std::numeric_limits<uint64_t>::max();
+
+  explicit LruStack(size_t initial_capacity = 64)
+      : marks_(std::max<size_t>(initial_capacity, 2)) {}
+
+  // Returns the stack distance of `block` (0 = most recently used), or
+  // kColdMiss on its first access, and moves it to the top of the stack.
+  uint64_t Access(uint64_t block) {
+    if (now_ == marks_.size()) Compact();
+    auto [it, inserted] = last_access_.try_emplace(block, now_);
+    uint64_t distance = kColdMiss;
+    if (!inserted) {
+      distance = marks_.PrefixSum(now_) - marks_.PrefixSum(it->second + 1);
+      marks_.Add(it->second, -1);
+      it->second = now_;
+    }
+    marks_.Add(now_, 1);
+    ++now_;
+    return distance;
+  }
+
+  [[nodiscard]] size_t DistinctBlocks() const { return last_access_.size(); }
+
+ private:
+  void Compact() {
+    std::vector<std::pair<uint32_t, uint64_t>> live;
+    live.reserve(last_access_.size());
+    for (const auto& [block, time] : last_access_) {
+      live.emplace_back(time, block);
+    }
+    std::sort(live.begin(), live.end());
+
+    // Keep at least half the tree free so compactions stay amortized O(1).
+    size_t capacity = marks_.size();
+    while (live.size() * 2 > capacity) capacity *= 2;
+    for (uint32_t i = 0; i < live.size(); ++i) {
+      last_access_[live[i].second] = i;
+    }
+    marks_.AssignOnes(capacity, live.size());
+    now_ = static_cast<uint32_t>(live.size());
+  }
+};
+
+// Stack-distance profile of a trace for caches of `sets` sets of
+// `block_size` bytes: one pass yields the hits of an LRU cache of every
+// associativity up to `max_ways` (the same results LRUPolicy gives, since
+// write-allocate makes loads and stores update the stack alike).
+//
+// Set sampling: with max_sampled_sets != 0, only every
+// (sets / max_sampled_sets)-th set is tracked and ratios are taken over the
+// accesses to those sets. Large set counts then cost no more than small
+// ones, so many capacities can be profiled in one replay.
+class StackDistanceProfile {
+  size_t block_size_;
+  size_t sets_;
+  size_t max_ways_;
+  size_t stride_;
+  std::vector<LruStack> stacks_;  // one per tracked set
+  std::vector<uint64_t> histogram_;  // [d]: accesses at distance d
+  uint64_t accesses_ = 0;            // to tracked sets
+
+ public:
+  StackDistanceProfile(size_t block_size, size_t sets, size_t max_ways,
+                       size_t max_sampled_sets = 0)
+      : block_size_(std::max<size_t>(block_size, 1)),
+        sets_(std::max<size_t>(sets, 1)),
+        max_ways_(std::max<size_t>(max_ways, 1)),
+        stride_(max_sampled_sets == 0
+                    ? 1
+                    : std::max<size_t>(sets_ / max_sampled_sets, 1)),
+        stacks_((sets_ + stride_ - 1) / stride_),
+        histogram_(max_ways_, 0) {}
+
+  void Access(uint64_t addr) {
+    const uint64_t block = addr / block_size_;
+    const uint64_t set = block % sets_;
+    if (set % stride_ != 0) return;
+    ++accesses_;
+    const uint64_t distance = stacks_[set / stride_].Access(block / sets_);
+    if (distance < max_ways_) ++histogram_[distance];
+  }
+
+  void AccessBatch(std::span<const TraceOp> ops) {
+    for (const auto& op : ops) Access(op.addr);
+  }
+
+  [[nodiscard]] size_t Sets() const { return sets_; }
+  [[nodiscard]] size_t MaxWays() const { return max_ways_; }
+  [[nodiscard]] size_t BlockSize() const { return block_size_; }
+  [[nodiscard]] bool Sampled() const { return stride_ > 1; }
+  [[nodiscard]] uint64_t Accesses() const { return accesses_; }
+  [[nodiscard]] std::span<const uint64_t> Histogram() const {
+    return histogram_;
+  }
+
+  // Hits of a `ways`-way LRU cache (ways <= MaxWays()).
+  [[nodiscard]] uint64_t Hits(size_t ways) const {
+    uint64_t hits = 0;
+    for (size_t d = 0; d < std::min(ways, max_ways_); ++d) {
+      hits += histogram_[d];
+    }
+    return hits;
+  }
+
+  [[nodiscard]] double MissRatio(size_t ways) const {
+    if (accesses_ == 0) return 0.0;
+    return 1.0 - static_cast<double>(Hits(ways)) / accesses_;
+  }
+};
+
+// One point of a miss-ratio curve.
+struct MrcPoint {
+  size_t sets;
+  size_t ways;
+  size_t capacity_bytes;
+  double miss_ratio;
+};
+
+// Profiles one replay of `reader` for every set count in `set_counts` and
+// returns the miss ratio of each (sets, ways <= max_ways) geometry, sorted
+// by capacity.
+template <typename Reader>
+std::vector<MrcPoint> MissRatioCurve(Reader& reader, size_t block_size,
+                                     std::span<const size_t> set_counts,
+                                     size_t max_ways,
+                                     size_t max_sampled_sets = 0) {
+  std::vector<StackDistanceProfile> profiles;
+  for (size_t sets : set_counts) {
+    profiles.emplace_back(block_size, sets, max_ways, max_sampled_sets);
+  }
+  std::vector<TraceOp> batch;
+  batch.reserve(kTraceBatchSize);
+  while (reader.ReadBatch(batch) > 0) {
+    for (auto& profile : profiles) profile.AccessBatch(batch);
+  }
+
+  std::vector<MrcPoint> curve;
+  for (const auto& profile : profiles) {
+    for (size_t ways = 1; ways <= max_ways; ++ways) {
+      curve.push_back({profile.Sets(), ways,
+                       profile.Sets() * ways * profile.BlockSize(),
+                       profile.MissRatio(ways)});
+    }
+  }
+  std::stable_sort(curve.begin(), curve.end(),
+                   [](const MrcPoint& a, const MrcPoint& b) {
+                     return a.capacity_bytes < b.capacity_bytes;
+                   });
+  return curve;
+}
+
+}  // namespace stratum
+
+#endif  // STACK_DISTANCE_HPP
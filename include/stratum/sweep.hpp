@@ -0,0 +1,269 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/cache_sim.hpp"
+#include "stratum/mapped_file.hpp"
+#include "stratum/parallel.hpp"
+#include "stratum/prefilter.hpp"
+#include "stratum/simulation.hpp"
+#include "stratum/trace_parser.hpp"
+
+namespace stratum {
+
+// One hierarchy in a sweep: a label for the report and its top-level type.
+//
+// Example:
+//   using Sweep = SweepList<SweepConfig<"case_001", L1Type>,
+//                           SweepConfig<"case_002", L1Small>>;
+template <FixedString Label, typename CacheSystem>
+struct SweepConfig {
+  using System = CacheSystem;
+  static constexpr std::string_view kLabel{Label.value};
+};
+
+// Compile-time list of SweepConfig entries.
+template <typename... Configs>
+struct SweepList {
+  static constexpr size_t kSize = sizeof...(Configs);
+};
+
+struct SweepTrace {
+  std::string name;
+  std::string path;
+};
+
+struct SweepLevelResult {
+  std::string_view name;
+  CacheStats stats;
+};
+
+// Outcome of replaying one trace into one configuration.
+struct SweepResult {
+  std::string_view config;
+  std::string trace;
+  size_t accesses = 0;
+  size_t total_cycles = 0;
+  double seconds = 0.0;
+  std::vector<SweepLevelResult> levels;
+
+  // Average memory access time in cycles.
+  [[nodiscard]] double Amat() const {
+    return accesses == 0 ? 0.0 : (double)total_cycles / accesses;
+  }
+};
+
+// A trace loaded once and shared read-only by every sweep job.
+//
+// Text traces are parsed into memory up front; binary traces stay mapped
+// and each job decodes them with its own BinaryTraceReader cursor, which
+// is cheaper than expanding them into 16-byte TraceOps.
+class LoadedTrace {
+  std::vector<TraceOp> ops_;
+  std::optional<MappedFile> binary_;
+  size_t op_count_ = 0;
+
+ public:
+  explicit LoadedTrace(const std::string& path) {
+    if (IsBinaryTraceFile(path)) {
+      binary_.emplace(path);
+      op_count_ = BinaryTraceReader(binary_->View()).Header().op_count;
+    } else {
+      ops_ = ParseTraceFileMapped(path);
+      op_count_ = ops_.size();
+    }
+  }
+
+  [[nodiscard]] size_t OpCount() const { return op_count_; }
+
+  // Calls fn(reader) with a fresh reader positioned at the first operation.
+  template <typename Fn>
+  void WithReader(Fn&& fn) const {
+    if (binary_) {
+      BinaryTraceReader reader(binary_->View());
+      fn(reader);
+    } else {
+      SpanTraceReader reader(ops_);
+      fn(reader);
+    }
+  }
+};
+
+namespace detail {
+
+template <typename Config>
+SweepResult RunSweepJob(const LoadedTrace& trace, size_t mem_latency) {
+  using System = typename Config::System;
+  const auto start = std::chrono::steady_clock::now();
+
+  auto system = std::make_unique<System>(mem_latency);
+  SimulationStats<System::kLevels> stats;
+  trace.WithReader([&](auto& reader) {
+    ReplayTrace(reader, *system,
+                [&](const TraceOp& op, const AccessResult& res) {
+                  stats.Record(op, res);
+                });
+  });
+
+  SweepResult result;
+  result.config = Config::kLabel;
+  result.accesses = stats.Accesses();
+  constexpr auto names = HierarchyNames<System>();
+  for (size_t i = 0; i < System::kLevels; ++i) {
+    result.levels.push_back({names[i], stats.Level(i)});
+    result.total_cycles += result.levels.back().stats.total_latency;
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+template <typename L1, typename Config>
+SweepResult RunFilteredSweepJob(const FilteredTrace& filtered,
+                                size_t mem_latency) {
+  using Lower = typename Config::System;
+  const auto start = std::chrono::steady_clock::now();
+
+  auto lower = std::make_unique<Lower>(mem_latency);
+  const auto run = RunFiltered(filtered, *lower);
+
+  SweepResult result;
+  result.config = Config::kLabel;
+  result.accesses = run.Accesses();
+  constexpr auto names = HierarchyNames<Lower>();
+  for (size_t i = 0; i < run.kLevels; ++i) {
+    result.levels.push_back(
+        {i == 0 ? L1::kName : names[i - 1], run.Level(i)});
+    result.total_cycles += result.levels.back().stats.total_latency;
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+}  // namespace detail
+
+// Replays every trace into every configuration of `List` on a pool of
+// `threads` workers (0 = one per hardware thread).
+//
+// Each trace is loaded exactly once (see LoadedTrace) and each job owns
+// its own hierarchy, so jobs share nothing mutable. Jobs are dispatched
+// longest trace first to keep the tail of the sweep short. Results are
+// returned trace-major in list order, independent of scheduling.
+template <typename... Configs>
+std::vector<SweepResult> RunSweep(SweepList<Configs...>,
+                                  const std::vector<SweepTrace>& traces,
+                                  size_t threads = 0,
+                                  size_t mem_latency = 100) {
+  constexpr size_t kConfigs = sizeof...(Configs);
+  using Job = SweepResult (*)(const LoadedTrace&, size_t);
+  constexpr std::array<Job, kConfigs> jobs{&detail::RunSweepJob<Configs>...};
+
+  std::vector<std::unique_ptr<LoadedTrace>> loaded(traces.size());
+  ParallelFor(traces.size(), threads, [&](size_t t) {
+    loaded[t] = std::make_unique<LoadedTrace>(traces[t].path);
+  });
+
+  std::vector<size_t> order(traces.size() * kConfigs);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return loaded[a / kConfigs]->OpCount() > loaded[b / kConfigs]->OpCount();
+  });
+
+  std::vector<SweepResult> results(order.size());
+  ParallelFor(order.size(), threads, [&](size_t i) {
+    const size_t slot = order[i];
+    const size_t t = slot / kConfigs;
+    results[slot] = jobs[slot % kConfigs](*loaded[t], mem_latency);
+    results[slot].trace = traces[t].name;
+  });
+  return results;
+}
+
+// RunSweep for designs that share one L1: each configuration of `List` is
+// the hierarchy *below* `L1` (see prefilter.hpp). Every trace goes through
+// the L1 once; the jobs replay only its miss stream, and the results are
+// those RunSweep would report for L1 on top of each configuration.
+// Job times exclude the filter pass.
+//
+// Example:
+//   using L1 = Cache<"L1", MainMemory<>, 64, 8, 64, LRUPolicy, 4>;
+//   using Lower = SweepList<SweepConfig<"l2_512x8", L2Big>,
+//                           SweepConfig<"l2_256x8", L2Small>>;
+//   PrintSweepTable(RunFilteredSweep<L1>(Lower{}, traces));
+template <typename L1, typename... Configs>
+std::vector<SweepResult> RunFilteredSweep(
+    SweepList<Configs...>, const std::vector<SweepTrace>& traces,
+    size_t threads = 0, size_t mem_latency = 100) {
+  constexpr size_t kConfigs = sizeof...(Configs);
+  using Job = SweepResult (*)(const FilteredTrace&, size_t);
+  constexpr std::array<Job, kConfigs> jobs{
+      &detail::RunFilteredSweepJob<L1, Configs>...};
+
+  std::vector<FilteredTrace> filtered(traces.size());
+  ParallelFor(traces.size(), threads, [&](size_t t) {
+    const LoadedTrace trace(traces[t].path);
+    trace.WithReader(
+        [&](auto& reader) { filtered[t] = FilterTraceToMemory<L1>(reader); });
+  });
+
+  std::vector<size_t> order(traces.size() * kConfigs);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return filtered[a / kConfigs].l1.StreamOps() >
+           filtered[b / kConfigs].l1.StreamOps();
+  });
+
+  std::vector<SweepResult> results(order.size());
+  ParallelFor(order.size(), threads, [&](size_t i) {
+    const size_t slot = order[i];
+    const size_t t = slot / kConfigs;
+    results[slot] = jobs[slot % kConfigs](filtered[t], mem_latency);
+    results[slot].trace = traces[t].name;
+  });
+  return results;
+}
+
+// Prints one comparison table: a row per (trace, configuration) with the
+// AMAT and the local hit rate of every cache level.
+inline void PrintSweepTable(const std::vector<SweepResult>& results) {
+  fmt::print("\n=== Sweep Results ({} runs) ===\n", results.size());
+  fmt::print("{:<12} {:<18} {:>10} {:>12} {:>9}  {}\n", "Trace", "Config",
+             "Accesses", "AMAT (cyc)", "Time (s)", "Hit rate per level");
+
+  for (const auto& r : results) {
+    std::string rates;
+    // The last level is MainMemory, which always hits.
+    for (size_t i = 0; i + 1 < r.levels.size(); ++i) {
+      const auto& s = r.levels[i].stats;
+      const size_t total = s.hits + s.misses;
+      const double rate = total == 0 ? 0.0 : 100.0 * s.hits / total;
+      if (!rates.empty()) rates += " | ";
+      rates += fmt::format("{} {:.1f}%", r.levels[i].name, rate);
+    }
+    fmt::print("{:<12} {:<18} {:>10} {:>12.2f} {:>9.3f}  {}\n", r.trace,
+               r.config, r.accesses, r.Amat(), r.seconds, rates);
+  }
+}
+
+}  // namespace stratum
+
+#endif  // SWEEP_HPP
@@ -0,0 +1,143 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef TAG_MATCH_HPP
+#define TAG_MATCH_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace stratum {
+
+// One bit per way, bit w set = way w matches.
+using WayMask = uint64_t;
+
+// Tag value stored in invalid ways. Real tags are addr / (BlockSize * Sets),
+// which never reaches 2^64 - 1 as long as BlockSize * Sets > 1, so a single
+// compare against the tag array answers both "valid" and "tag equal".
+inline constexpr uint64_t kInvalidTag = ~uint64_t{0};
+
+template <size_t Ways>
+constexpr WayMask AllWaysMask() {
+  static_assert(Ways >= 1 && Ways <= 64, "WayMask holds at most 64 ways");
+  return Ways == 64 ? ~WayMask{0} : (WayMask{1} << Ways) - 1;
+}
+
+// Compares `tag` against the `Ways` contiguous tags of one set and returns
+// the matching ways as a bitmask.
+//
+// Uses AVX-512 (8 ways / compare), AVX2 (4) or NEON (2) when the target
+// supports it (e.g. -march=native, see STRATUM_NATIVE_ARCH), and a scalar
+// loop for the remainder or when no SIMD is available. Ways is a template
+// parameter, so the chunk loops are fully unrolled.
+template <size_t Ways>
+inline WayMask MatchTags(const uint64_t* tags, uint64_t tag) noexcept {
+  static_assert(Ways >= 1 && Ways <= 64, "WayMask holds at most 64 ways");
+  WayMask mask = 0;
+  size_t way = 0;
+
+#if defined(__AVX512F__)
+  const __m512i needle8 = _mm512_set1_epi64(static_cast<long long>(tag));
+  for (; way + 8 <= Ways; way += 8) {
+    __m512i v = _mm512_loadu_si512(tags + way);
+    mask |= WayMask{_mm512_cmpeq_epi64_mask(v, needle8)} << way;
+  }
+#endif
+#if defined(__AVX2__)
+  const __m256i needle4 = _mm256_set1_epi64x(static_cast<long long>(tag));
+  for (; way + 4 <= Ways; way += 4) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + way));
+    __m256i eq = _mm256_cmpeq_epi64(v, needle4);
+    mask |= static_cast<WayMask>(
+                _mm256_movemask_pd(_mm256_castsi256_pd(eq)))
+            << way;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const uint64x2_t needle2 = vdupq_n_u64(tag);
+  for (; way + 2 <= Ways; way += 2) {
+    uint64x2_t eq = vceqq_u64(vld1q_u64(tags + way), needle2);
+    mask |= (vgetq_lane_u64(eq, 0) & 1) << way;
+    mask |= (vgetq_lane_u64(eq, 1) & 1) << (way + 1);
+  }
+#endif
+
+  for (; way < Ways; ++way) {
+    mask |= static_cast<WayMask>(tags[way] == tag) << way;
+  }
+  return mask;
+}
+
+// Result of a single pass over one set: matching ways and free ways.
+struct TagLookup {
+  WayMask hit;
+  WayMask free;
+};
+
+// Like MatchTags, but also compares against kInvalidTag in the same pass so
+// the miss path can pick a free way without rescanning the set.
+template <size_t Ways>
+inline TagLookup LookupTags(const uint64_t* tags, uint64_t tag) noexcept {
+  static_assert(Ways >= 1 && Ways <= 64, "WayMask holds at most 64 ways");
+  TagLookup res{0, 0};
+  size_t way = 0;
+
+#if defined(__AVX512F__)
+  const __m512i needle8 = _mm512_set1_epi64(static_cast<long long>(tag));
+  const __m512i invalid8 = _mm512_set1_epi64(-1);
+  for (; way + 8 <= Ways; way += 8) {
+    __m512i v = _mm512_loadu_si512(tags + way);
+    res.hit |= WayMask{_mm512_cmpeq_epi64_mask(v, needle8)} << way;
+    res.free |= WayMask{_mm512_cmpeq_epi64_mask(v, invalid8)} << way;
+  }
+#endif
+#if defined(__AVX2__)
+  const __m256i needle4 = _mm256_set1_epi64x(static_cast<long long>(tag));
+  const __m256i invalid4 = _mm256_set1_epi64x(-1);
+  for (; way + 4 <= Ways; way += 4) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + way));
+    __m256i eq = _mm256_cmpeq_epi64(v, needle4);
+    __m256i inv = _mm256_cmpeq_epi64(v, invalid4);
+    res.hit |= static_cast<WayMask>(
+                   _mm256_movemask_pd(_mm256_castsi256_pd(eq)))
+               << way;
+    res.free |= static_cast<WayMask>(
+                    _mm256_movemask_pd(_mm256_castsi256_pd(inv)))
+                << way;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const uint64x2_t needle2 = vdupq_n_u64(tag);
+  const uint64x2_t invalid2 = vdupq_n_u64(kInvalidTag);
+  for (; way + 2 <= Ways; way += 2) {
+    uint64x2_t v = vld1q_u64(tags + way);
+    uint64x2_t eq = vceqq_u64(v, needle2);
+    uint64x2_t inv = vceqq_u64(v, invalid2);
+    res.hit |= (vgetq_lane_u64(eq, 0) & 1) << way;
+    res.hit |= (vgetq_lane_u64(eq, 1) & 1) << (way + 1);
+    res.free |= (vgetq_lane_u64(inv, 0) & 1) << way;
+    res.free |= (vgetq_lane_u64(inv, 1) & 1) << (way + 1);
+  }
+#endif
+
+  for (; way < Ways; ++way) {
+    res.hit |= static_cast<WayMask>(tags[way] == tag) << way;
+    res.free |= static_cast<WayMask>(tags[way] == kInvalidTag) << way;
+  }
+  return res;
+}
+
+// Index of the lowest set way in a non-empty mask.
+constexpr size_t FirstWay(WayMask mask) {
+  return static_cast<size_t>(std::countr_zero(mask));
+}
+
+}  // namespace stratum
+
+#endif  // TAG_MATCH_HPP
@@ -0,0 +1,414 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#ifndef TIMING_HPP
+#define TIMING_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/cache_sim.hpp"
+#include "stratum/simulation.hpp"
+#include "stratum/trace_parser.hpp"
+
+namespace stratum {
+
+// ============================================================================
+// Timing model with MSHRs, banks and DRAM row buffers
+// ============================================================================
+// The functional model charges every access the sum of the hit latencies
+// down to the level that served it, as if accesses ran one at a time.
+// TimingModel replays the functional outcome of each access (which level
+// served it) against timed resources instead:
+//
+//   Core    issues one access every `issue_cycles` in trace order, with at
+//           most `window` accesses in flight (retired in order). Stores
+//           retire at issue (store buffer) unless `stores_block`.
+//   Level   `banks` banks (interleaved by block, rounded up to a power of
+//           two), each busy `bank_cycles` per access; the tag check
+//           takes the level's HitLatency. A miss takes one of `mshrs`
+//           MSHRs until its fill returns, stalling when all are busy. A
+//           miss to a block already in flight merges into that MSHR, and a
+//           hit on a block still being filled waits for the fill.
+//   DRAM    `banks` banks of `row_bytes` rows (both rounded up to powers
+//           of two) with an open row each. A row hit takes
+//           row_hit_cycles, a miss row_miss_cycles (precharge + activate +
+//           column access); each transfer then holds the shared data bus
+//           for `burst_cycles`.
+//
+// Resources are reserved in trace order, each keeping the time it is next
+// free, and the MSHR files are small arrays scanned on misses (and on hits
+// only while fills are pending). That keeps timed replay within a small
+// factor of functional replay. Writebacks and prefetch fills are untimed,
+// and MainMemory's fixed latency is replaced by the DRAM model.
+//
+// Example:
+//   TimingModel<L1Type> timing;
+//   ReplayTrace(reader, *cache, [&](const TraceOp& op, AccessResult res) {
+//     res = timing.Time(op, res);  // total_cycles: issue to completion
+//   });
+
+struct CoreTiming {
+  uint32_t window = 64;  // accesses in flight
+  uint32_t issue_cycles = 1;
+  bool stores_block = false;
+};
+
+struct LevelTiming {
+  uint32_t mshrs = 16;
+  uint32_t banks = 4;
+  uint32_t bank_cycles = 1;
+};
+
+struct DramTiming {
+  uint32_t banks = 8;
+  uint32_t row_bytes = 2048;
+  uint32_t row_hit_cycles = 40;
+  uint32_t row_miss_cycles = 100;
+  uint32_t burst_cycles = 4;
+};
+
+// Timing parameters of a hierarchy with `CacheLevels` cache levels above
+// memory.
+template <size_t CacheLevels>
+struct TimingConfig {
+  CoreTiming core;
+  std::array<LevelTiming, CacheLevels> levels{};
+  DramTiming dram;
+};
+
+struct LevelTimingStats {
+  uint64_t accesses = 0;
+  uint64_t bank_conflicts = 0;  // accesses that waited for a busy bank
+  uint64_t mshr_merges = 0;     // misses merged into an in-flight miss
+  uint64_t pending_hits = 0;    // hits that waited for an in-flight fill
+  uint64_t mshr_stalls = 0;     // misses that waited for a free MSHR
+};
+
+struct DramTimingStats {
+  uint64_t accesses = 0;
+  uint64_t row_hits = 0;
+  uint64_t row_misses = 0;
+  uint64_t bank_conflicts = 0;
+};
+
+template <size_t CacheLevels>
+struct TimingStats {
+  uint64_t accesses = 0;
+  uint64_t cycles = 0;       // completion time of the last access
+  uint64_t latency_sum = 0;  // issue to completion, over all accesses
+  std::array<LevelTimingStats, CacheLevels> levels{};
+  DramTimingStats dram;
+
+  [[nodiscard]] double MeanLatency() const {
+    return accesses == 0 ? 0.0 : (double)latency_sum / accesses;
+  }
+
+  // Memory-level parallelism: accesses in flight on average.
+  [[nodiscard]] double Mlp() const {
+    return cycles == 0 ? 0.0 : (double)latency_sum / cycles;
+  }
+};
+
+// Outstanding misses of one level.
+class MshrFile {
+  std::vector<uint64_t> block_;
+  std::vector<uint64_t> ready_;  // fill completion time; free once passed
+  uint64_t latest_ = 0;          // latest ready_ ever set
+
+ public:
+  explicit MshrFile(size_t entries)
+      : block_(std::max<size_t>(entries, 1), ~uint64_t{0}),
+        ready_(block_.size(), 0) {}
+
+  // Completion time of a fill of `block` still in flight at `t`, or 0.
+  [[nodiscard]] uint64_t Pending(uint64_t block, uint64_t t) const {
+    if (t >= latest_) return 0;
+    for (size_t i = 0; i < block_.size(); ++i) {
+      if (block_[i] == block && ready_[i] > t) return ready_[i];
+    }
+    return 0;
+  }
+
+  // An entry for a miss at `t` and the time it is free: `t`, or the first
+  // completion if every entry is busy.
+  [[nodiscard]] std::pair<size_t, uint64_t> Allocate(uint64_t t) const {
+    size_t earliest = 0;
+    for (size_t i = 0; i < ready_.size(); ++i) {
+      if (ready_[i] <= t) return {i, t};
+      if (ready_[i] < ready_[earliest]) earliest = i;
+    }
+    return {earliest, ready_[earliest]};
+  }
+
+  void Set(size_t entry, uint64_t block, uint64_t ready) {
+    block_[entry] = block;
+    ready_[entry] = ready;
+    latest_ = std::max(latest_, ready);
+  }
+
+  void Reset() {
+    std::fill(block_.begin(), block_.end(), ~uint64_t{0});
+    std::fill(ready_.begin(), ready_.end(), 0);
+    latest_ = 0;
+  }
+};
+
+// Times the accesses of a CacheSystem (a Cache chain ending in memory).
+template <typename CacheSystem>
+class TimingModel {
+ public:
+  static constexpr size_t kLevels = CacheSystem::kLevels;
+  static constexpr size_t kCacheLevels = kLevels - 1;
+  using Config = TimingConfig<kCacheLevels>;
+
+ private:
+  static constexpr auto kInfo = HierarchyInfo<CacheSystem>();
+  static_assert(kInfo[kLevels - 1].is_memory,
+                "TimingModel needs a hierarchy that ends in memory");
+
+  struct LevelState {
+    std::vector<uint64_t> bank_free;
+    uint64_t bank_mask;
+    MshrFile mshrs;
+    uint32_t bank_cycles;
+  };
+
+  Config config_;
+  std::vector<LevelState> levels_;
+  std::vector<uint64_t> dram_bank_free_;
+  std::vector<uint64_t> open_row_;
+  int row_shift_ = 0;
+  int dram_bank_shift_ = 0;
+  uint64_t bus_free_ = 0;
+  std::vector<uint64_t> retire_;  // ring: retire time of the last `window`
+  size_t head_ = 0;
+  uint64_t next_issue_ = 0;
+  uint64_t last_retire_ = 0;
+  TimingStats<kCacheLevels> stats_;
+
+  static constexpr uint64_t kNoRow = ~uint64_t{0};
+
+ public:
+  explicit TimingModel(const Config& config = {}) : config_(config) {
+    config_.core.window = std::max<uint32_t>(config_.core.window, 1);
+    config_.dram.banks =
+        std::bit_ceil(std::max<uint32_t>(config_.dram.banks, 1));
+    config_.dram.row_bytes =
+        std::bit_ceil(std::max<uint32_t>(config_.dram.row_bytes, 1));
+    // A row miss costs at least a row hit (the activate time is unsigned).
+    config_.dram.row_miss_cycles =
+        std::max(config_.dram.row_miss_cycles, config_.dram.row_hit_cycles);
+    row_shift_ = std::countr_zero(config_.dram.row_bytes);
+    dram_bank_shift_ = std::countr_zero(config_.dram.banks);
+    for (const LevelTiming& level : config_.levels) {
+      const uint32_t banks = std::bit_ceil(std::max<uint32_t>(level.banks, 1));
+      levels_.push_back({std::vector<uint64_t>(banks), banks - 1u,
+                         MshrFile(level.mshrs), level.bank_cycles});
+    }
+    dram_bank_free_.assign(config_.dram.banks, 0);
+    open_row_.assign(config_.dram.banks, kNoRow);
+    retire_.assign(config_.core.window, 0);
+  }
+
+  // Times the next access in trace order, which the functional model
+  // resolved as `res`. Returns `res` with total_cycles replaced by the
+  // time from issue to completion.
+  AccessResult Time(const TraceOp& op, const AccessResult& res) {
+    const uint64_t issue = std::max(next_issue_, retire_[head_]);
+    next_issue_ = issue + config_.core.issue_cycles;
+
+    const uint64_t done = Serve<0>(op.addr, res.hit_level, issue);
+    const bool blocks = op.type == 'L' || config_.core.stores_block;
+    last_retire_ = std::max(last_retire_, blocks ? done : issue);
+    retire_[head_] = last_retire_;
+    head_ = head_ + 1 == retire_.size() ? 0 : head_ + 1;
+
+    stats_.accesses++;
+    stats_.latency_sum += done - issue;
+    stats_.cycles = std::max(stats_.cycles, done);
+    return {res.hit_level, static_cast<size_t>(done - issue)};
+  }
+
+  [[nodiscard]] const TimingStats<kCacheLevels>& Stats() const {
+    return stats_;
+  }
+
+  void Reset() {
+    for (LevelState& level : levels_) {
+      std::fill(level.bank_free.begin(), level.bank_free.end(), 0);
+      level.mshrs.Reset();
+    }
+    std::fill(dram_bank_free_.begin(), dram_bank_free_.end(), 0);
+    std::fill(open_row_.begin(), open_row_.end(), kNoRow);
+    bus_free_ = 0;
+    std::fill(retire_.begin(), retire_.end(), 0);
+    head_ = 0;
+    next_issue_ = 0;
+    last_retire_ = 0;
+    stats_ = {};
+  }
+
+ private:
+  // Walks the access through level I at time `t` and returns the time its
+  // data is back there: from a hit, from an in-flight fill it merges into,
+  // or from the levels below, holding an MSHR here until the fill.
+  // Unrolled per level, so block sizes and latencies are constants.
+  template <size_t I>
+  uint64_t Serve(uint64_t addr, uint32_t hit_level, uint64_t t) {
+    if constexpr (I == kCacheLevels) {
+      return Dram(addr, t);
+    } else {
+      LevelState& level = levels_[I];
+      LevelTimingStats& stats = stats_.levels[I];
+      const uint64_t block = addr / kInfo[I].block_size;
+      stats.accesses++;
+
+      uint64_t& bank = level.bank_free[block & level.bank_mask];
+      if (bank > t) {
+        stats.bank_conflicts++;
+        t = bank;
+      }
+      bank = t + level.bank_cycles;
+      t += kInfo[I].hit_latency;
+
+      if (const uint64_t fill = level.mshrs.Pending(block, t); fill != 0) {
+        if (I == hit_level) {
+          stats.pending_hits++;
+        } else {
+          stats.mshr_merges++;
+        }
+        return fill;
+      }
+      if (I == hit_level) return t;
+
+      const auto [entry, free_at] = level.mshrs.Allocate(t);
+      if (free_at > t) {
+        stats.mshr_stalls++;
+        t = free_at;
+      }
+      const uint64_t done = Serve<I + 1>(addr, hit_level, t);
+      level.mshrs.Set(entry, block, done);
+      return done;
+    }
+  }
+
+  uint64_t Dram(uint64_t addr, uint64_t t) {
+    const DramTiming& dram = config_.dram;
+    const uint64_t global_row = addr >> row_shift_;
+    const size_t bank = global_row & (dram.banks - 1);
+    const uint64_t row = global_row >> dram_bank_shift_;
+    stats_.dram.accesses++;
+
+    uint64_t& bank_free = dram_bank_free_[bank];
+    if (bank_free > t) {
+      stats_.dram.bank_conflicts++;
+      t = bank_free;
+    }
+    const bool row_hit = open_row_[bank] == row;
+    open_row_[bank] = row;
+    if (row_hit) {
+      stats_.dram.row_hits++;
+    } else {
+      stats_.dram.row_misses++;
+    }
+
+    // Row hits to one bank pipeline at the burst rate; a row miss holds
+    // the bank for the precharge and activate first.
+    const uint64_t activate =
+        row_hit ? 0 : dram.row_miss_cycles - dram.row_hit_cycles;
+    const uint64_t data =
+        t + (row_hit ? dram.row_hit_cycles : dram.row_miss_cycles);
+    const uint64_t transfer = std::max(data, bus_free_);
+    bus_free_ = transfer + dram.burst_cycles;
+    bank_free = t + activate + dram.burst_cycles;
+    return transfer + dram.burst_cycles;
+  }
+};
+
+template <size_t CacheLevels>
+void PrintTimingReport(
+    const TimingStats<CacheLevels>& s,
+    const std::array<std::string_view, CacheLevels + 1>& names) {
+  fmt::print("\n=== Timing ===\n");
+  fmt::print("Cycles: {}, Mean latency: {:.2f}, MLP: {:.2f}\n", s.cycles,
+             s.MeanLatency(), s.Mlp());
+  fmt::print("{:<15} {:>10} {:>12} {:>12} {:>12} {:>12}\n", "Level",
+             "Accesses", "BankWaits", "MshrMerges", "PendingHits",
+             "MshrStalls");
+  for (size_t i = 0; i < CacheLevels; ++i) {
+    const LevelTimingStats& l = s.levels[i];
+    fmt::print("{:<15} {:>10} {:>12} {:>12} {:>12} {:>12}\n", names[i],
+               l.accesses, l.bank_conflicts, l.mshr_merges, l.pending_hits,
+               l.mshr_stalls);
+  }
+  const double row_hit_rate =
+      s.dram.accesses == 0 ? 0.0 : (double)s.dram.row_hits / s.dram.accesses;
+  fmt::print("{:<15} {:>10} RowHits={} RowMisses={} ({:.1f}% hits) "
+             "BankWaits={}\n",
+             names[CacheLevels], s.dram.accesses, s.dram.row_hits,
+             s.dram.row_misses, row_hit_rate * 100.0,
+             s.dram.bank_conflicts);
+}
+
+// RunTraceSimulation with timed latencies: the per-level report and the
+// latency distribution show issue-to-completion times from TimingModel.
+//
+// Example:
+//   TimingModel<L1Type>::Config timing;
+//   timing.dram.row_miss_cycles = 150;
+//   RunTimedTraceSimulation<L1Type>("Sequential", "seq.txt", timing);
+template <typename CacheSystem>
+void RunTimedTraceSimulation(
+    const std::string& trace_name, const std::string& filepath,
+    const typename TimingModel<CacheSystem>::Config& config = {}) {
+  fmt::print("\n=========================================================\n");
+  fmt::print("Running Timed Simulation: {} ({})\n", trace_name, filepath);
+  fmt::print("=========================================================\n");
+
+  auto cache_system = std::make_unique<CacheSystem>();
+  TimingModel<CacheSystem> timing(config);
+  SimulationStats<CacheSystem::kLevels> stats;
+  std::vector<AccessResult> log_history;
+  std::vector<uint64_t> log_addrs;
+
+  auto replay = [&](auto& reader) {
+    ReplayTrace(reader, *cache_system,
+                [&](const TraceOp& op, const AccessResult& functional) {
+                  const AccessResult res = timing.Time(op, functional);
+                  stats.Record(op, res);
+                  if (log_history.size() <= kAccessLogLimit) {
+                    log_history.push_back(res);
+                    log_addrs.push_back(op.addr);
+                  }
+                });
+  };
+
+  if (IsBinaryTraceFile(filepath)) {
+    BinaryTraceReader reader(filepath);
+    replay(reader);
+  } else {
+    MappedTraceReader reader(filepath);
+    replay(reader);
+  }
+
+  PrintSimulationReport(trace_name, stats, HierarchyNames<CacheSystem>(),
+                        log_history, log_addrs);
+  if (stats.Accesses() > 0) {
+    PrintTimingReport(timing.Stats(), HierarchyNames<CacheSystem>());
+  }
+}
+
+}  // namespace stratum
+
+#endif  // TIMING_HPP
@@ -5,13 +5,20 @@
 
 #include <fmt/core.h>
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "stratum/mapped_file.hpp"
+
 namespace stratum {
 
 struct TraceOp {
@@ -19,36 +26,302 @@ struct TraceOp {
   uint64_t addr;
 };
 
+// Number of operations handed to the simulator per batch in streaming mode.
+// Large enough to amortize the I/O loop, small enough to stay in L2.
+inline constexpr size_t kTraceBatchSize = 4096;
+
+// How far a reader has got through its trace: `done` of `total` units
+// (bytes of a text trace, operations otherwise), for progress reports.
+struct TraceProgress {
+  uint64_t done = 0;
+  uint64_t total = 0;
+};
+
+// Parses a single trace line into `op`.
+// Returns false for blank lines, comments and malformed lines.
+inline bool ParseTraceLine(const std::string& line, TraceOp& op) {
+  if (line.empty() || line[0] == '#') return false;
+
+  std::stringstream ss(line);
+  char type;
+  std::string addr_str;
+
+  // Expected format: L 0x1234 or S 0x1234
+  if (!(ss >> type >> addr_str)) return false;
+
+  try {
+    op.addr = std::stoull(addr_str, nullptr, 16);
+  } catch (...) {
+    fmt::print(stderr, "Warning: Skipping invalid line: {}\n", line);
+    return false;
+  }
+  op.type = type;
+  return true;
+}
+
+// Streaming trace reader.
+//
+// Reads the trace in fixed-size batches so that peak memory is bounded by the
+// batch size rather than by the trace length.
+//
+// Example:
+//   TraceReader reader("trace.txt");
+//   std::vector<TraceOp> batch;
+//   while (reader.ReadBatch(batch) > 0) {
+//     for (const auto& op : batch) { ... }
+//   }
+class TraceReader {
+  std::ifstream file_;
+  std::string line_;
+
+ public:
+  explicit TraceReader(const std::string& filename) : file_(filename) {
+    if (!file_.is_open()) {
+      fmt::print(stderr, "Error: Could not open trace file {}\n", filename);
+    }
+  }
+
+  [[nodiscard]] bool IsOpen() const { return file_.is_open(); }
+
+  // Replaces the contents of `batch` with up to `max_ops` operations.
+  // Returns the number of operations read; 0 means end of trace.
+  size_t ReadBatch(std::vector<TraceOp>& batch,
+                   size_t max_ops = kTraceBatchSize) {
+    batch.clear();
+    TraceOp op;
+    while (batch.size() < max_ops && std::getline(file_, line_)) {
+      if (ParseTraceLine(line_, op)) batch.push_back(op);
+    }
+    return batch.size();
+  }
+};
+
 inline std::vector<TraceOp> ParseTraceFile(const std::string& filename) {
   std::vector<TraceOp> ops;
-  std::ifstream file(filename);
-
-  if (!file.is_open()) {
-    fmt::print(stderr, "Error: Could not open trace file {}\n", filename);
-    return ops;
-  }
-
-  std::string line;
-  while (std::getline(file, line)) {
-    if (line.empty() || line[0] == '#') continue;
-
-    std::stringstream ss(line);
-    char type;
-    std::string addr_str;
-
-    // Expected format: L 0x1234 or S 0x1234
-    if (ss >> type >> addr_str) {
-      uint64_t addr = 0;
-      try {
-        addr = std::stoull(addr_str, nullptr, 16);
-      } catch (...) {
-        fmt::print(stderr, "Warning: Skipping invalid line: {}\n", line);
-        continue;
-      }
-      ops.push_back({type, addr});
+  TraceReader reader(filename);
+  if (!reader.IsOpen()) return ops;
+
+  std::vector<TraceOp> batch;
+  while (reader.ReadBatch(batch) > 0) {
+    ops.insert(ops.end(), batch.begin(), batch.end());
+  }
+
+  return ops;
+}
+
+
+// ============================================================================
+// Zero-copy parser
+// ============================================================================
+// The functions below scan a trace buffer in place (typically a MappedFile)
+// and never allocate. They accept the same format as ParseTraceLine:
+//   <type> [0x]<hex address> [ignored...]
+// with '#' comment lines and blank lines skipped.
+
+namespace detail {
+
+inline constexpr uint64_t kLowBytes = 0x0101010101010101ULL;
+inline constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+
+// Per byte: high bit set iff byte >= n. Valid for bytes < 0x80, n <= 0x80.
+constexpr uint64_t BytesGreaterEqual(uint64_t x, uint8_t n) {
+  return ((x | kHighBits) - kLowBytes * n) & kHighBits;
+}
+
+// Number of leading hex digits (0..8) in the 8 bytes of `x`, where `x` holds
+// the bytes in memory order (first character in the lowest byte).
+constexpr unsigned HexRunLength(uint64_t x) {
+  const uint64_t lower = x | (kLowBytes * 0x20);
+  const uint64_t digit =
+      BytesGreaterEqual(x, '0') & ~BytesGreaterEqual(x, '9' + 1);
+  const uint64_t alpha =
+      BytesGreaterEqual(lower, 'a') & ~BytesGreaterEqual(lower, 'f' + 1);
+  // Bytes >= 0x80 wrap the comparisons above; reject them explicitly.
+  const uint64_t valid = (digit | alpha) & ~x & kHighBits;
+  return static_cast<unsigned>(std::countr_zero(valid ^ kHighBits)) / 8;
+}
+
+// Converts 8 ASCII hex digits (memory order) to their value (SWAR).
+constexpr uint64_t DecodeHex8(uint64_t x) {
+  // '0'-'9' -> low nibble; 'a'-'f' / 'A'-'F' -> low nibble + 9.
+  uint64_t v = (x & (kLowBytes * 0x0F)) + ((x >> 6) & kLowBytes) * 9;
+  // Merge neighbours; the first character is the most significant digit.
+  v = ((v & 0x000F000F000F000FULL) << 4) | ((v >> 8) & 0x000F000F000F000FULL);
+  v = ((v & 0x000000FF000000FFULL) << 8) | ((v >> 16) & 0x000000FF000000FFULL);
+  v = ((v & 0x000000000000FFFFULL) << 16) | ((v >> 32) & 0x000000000000FFFFULL);
+  return v;
+}
+
+// Fallback digit lookup: value of a hex character, or 0xFF if not hex.
+constexpr uint8_t HexDigitValue(char c) {
+  if (c >= '0' && c <= '9') return static_cast<uint8_t>(c - '0');
+  if (c >= 'a' && c <= 'f') return static_cast<uint8_t>(c - 'a' + 10);
+  if (c >= 'A' && c <= 'F') return static_cast<uint8_t>(c - 'A' + 10);
+  return 0xFF;
+}
+
+// Parses a hex number at `p`. On success stores the value, advances `p` past
+// the digits and returns true. Fails on an empty run or more than 16 digits.
+inline bool ParseHex(const char*& p, const char* end, uint64_t& value) {
+  uint64_t v = 0;
+  unsigned digits = 0;
+  bool run_ended = false;
+
+  // Fast path: 8 characters per step while the buffer allows wide loads.
+  while (!run_ended && end - p >= 8) {
+    uint64_t chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+    if constexpr (std::endian::native == std::endian::big) {
+      chunk = __builtin_bswap64(chunk);
     }
+    const unsigned n = HexRunLength(chunk);
+    digits += n;
+    p += n;
+    if (digits > 16) return false;
+    // Characters after the run land in the low nibbles and are shifted out.
+    v = (v << (4 * n)) | (DecodeHex8(chunk) >> (4 * (8 - n)));
+    run_ended = n < 8;
   }
 
+  // Tail: byte at a time near the end of the buffer.
+  while (!run_ended && p < end) {
+    const uint8_t d = HexDigitValue(*p);
+    if (d == 0xFF) break;
+    v = (v << 4) | d;
+    ++digits;
+    ++p;
+  }
+
+  if (digits == 0 || digits > 16) return false;
+  value = v;
+  return true;
+}
+
+// Horizontal whitespace as skipped by operator>> within a line.
+constexpr bool IsBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+}  // namespace detail
+
+// Parses the next operation from [p, end), skipping blank, comment and
+// malformed lines. Advances `p` to the start of the following line and
+// sets `rest` to whatever followed the address on the parsed line.
+// Returns false once the buffer is exhausted.
+inline bool NextTraceOp(const char*& p, const char* end, TraceOp& op,
+                        std::string_view& rest) {
+  while (p < end) {
+    const char* line = p;
+    const char* eol =
+        static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) eol = end;
+    p = (eol == end) ? end : eol + 1;
+
+    if (line == eol || *line == '#') continue;
+
+    const char* q = line;
+    while (q < eol && detail::IsBlank(*q)) ++q;
+    if (q == eol) continue;
+    const char type = *q++;
+
+    while (q < eol && detail::IsBlank(*q)) ++q;
+    if (q == eol) continue;
+    if (eol - q >= 2 && q[0] == '0' && (q[1] == 'x' || q[1] == 'X')) q += 2;
+
+    uint64_t addr;
+    if (!detail::ParseHex(q, eol, addr)) {
+      fmt::print(stderr, "Warning: Skipping invalid line: {}\n",
+                 std::string_view(line, eol - line));
+      continue;
+    }
+
+    op.type = type;
+    op.addr = addr;
+    rest = std::string_view(q, eol - q);
+    return true;
+  }
+  return false;
+}
+
+inline bool NextTraceOp(const char*& p, const char* end, TraceOp& op) {
+  std::string_view rest;
+  return NextTraceOp(p, end, op, rest);
+}
+
+// Calls fn(const TraceOp&) for every operation in `buffer`.
+template <typename Fn>
+void ForEachTraceOp(std::string_view buffer, Fn&& fn) {
+  const char* p = buffer.data();
+  const char* end = p + buffer.size();
+  TraceOp op;
+  while (NextTraceOp(p, end, op)) fn(op);
+}
+
+// Memory-mapped streaming trace reader.
+//
+// Drop-in replacement for TraceReader: same ReadBatch contract, but the file
+// is scanned in place with the allocation-free parser above.
+class MappedTraceReader {
+  MappedFile file_;
+  const char* cursor_;
+  const char* end_;
+
+ public:
+  explicit MappedTraceReader(const std::string& filename)
+      : file_(filename),
+        cursor_(file_.Data()),
+        end_(file_.Data() + file_.Size()) {}
+
+  [[nodiscard]] bool IsOpen() const { return file_.IsOpen(); }
+
+  [[nodiscard]] TraceProgress Progress() const {
+    return {static_cast<uint64_t>(cursor_ - file_.Data()), file_.Size()};
+  }
+
+  // Replaces the contents of `batch` with up to `max_ops` operations.
+  // Returns the number of operations read; 0 means end of trace.
+  size_t ReadBatch(std::vector<TraceOp>& batch,
+                   size_t max_ops = kTraceBatchSize) {
+    batch.clear();
+    TraceOp op;
+    while (batch.size() < max_ops && NextTraceOp(cursor_, end_, op)) {
+      batch.push_back(op);
+    }
+    return batch.size();
+  }
+};
+
+// Replays operations already held in memory (e.g. a trace parsed once and
+// shared by several sweep workers) through the ReadBatch contract.
+class SpanTraceReader {
+  std::span<const TraceOp> ops_;
+  size_t pos_ = 0;
+
+ public:
+  explicit SpanTraceReader(std::span<const TraceOp> ops) : ops_(ops) {}
+
+  [[nodiscard]] bool IsOpen() const { return true; }
+
+  [[nodiscard]] TraceProgress Progress() const { return {pos_, ops_.size()}; }
+
+  // Replaces the contents of `batch` with up to `max_ops` operations.
+  // Returns the number of operations read; 0 means end of trace.
+  size_t ReadBatch(std::vector<TraceOp>& batch,
+                   size_t max_ops = kTraceBatchSize) {
+    const size_t n = std::min(max_ops, ops_.size() - pos_);
+    batch.assign(ops_.begin() + pos_, ops_.begin() + pos_ + n);
+    pos_ += n;
+    return n;
+  }
+};
+
+// Zero-copy counterpart of ParseTraceFile.
+inline std::vector<TraceOp> ParseTraceFileMapped(const std::string& filename) {
+  std::vector<TraceOp> ops;
+  MappedFile file(filename);
+  if (!file.IsOpen()) return ops;
+
+  ForEachTraceOp(file.View(), [&](const TraceOp& op) { ops.push_back(op); });
   return ops;
 }
 
@@ -0,0 +1,21 @@
+#!/bin/bash
+# Copyright 2025 Yi-Ping Pan (Cloudlet)
+# Profile-guided build of the sweep drivers (stratum_sweep, sweep_all)
+# Usage: ./scripts/pgo_build.sh [build_dir]   (default: build)
+#
+# 1. configure with STRATUM_PGO=GENERATE and build instrumented binaries
+# 2. pgo_train: run them on the test/data traces to record profiles
+# 3. reconfigure with STRATUM_PGO=USE and rebuild with the profiles
+
+set -e
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+BUILD="${1:-build}"
+
+cmake -S "$ROOT" -B "$BUILD" -DCMAKE_BUILD_TYPE=Release -DSTRATUM_PGO=GENERATE
+rm -rf "$BUILD/pgo"
+cmake --build "$BUILD" --target pgo_train -j"$(nproc)"
+
+cmake -S "$ROOT" -B "$BUILD" -DSTRATUM_PGO=USE
+cmake --build "$BUILD" -j"$(nproc)"
+echo "PGO build done: profiles in $BUILD/pgo" >&2
@@ -18,9 +18,6 @@ int main() {
   using L2Type = Cache<"L2", L3Type, 512, 8, 64, LRUPolicy, 10>;
   using L1Type = Cache<"L1", L2Type, 64, 8, 64, LRUPolicy, 4>;
 
-  // Define Hierarchy for Stats
-  std::vector<std::string> hierarchy = {"L1", "L2", "L3", "MainMemory"};
-
   // Define Traces
   const std::string project_root = STRATUM_ROOT;
   std::vector<std::pair<std::string, std::string>> traces = {
@@ -33,7 +30,7 @@ int main() {
 
   // Run Simulations
   for (const auto& t : traces) {
-    RunTraceSimulation<L1Type>(t.first, t.second, hierarchy);
+    RunTraceSimulation<L1Type>(t.first, t.second);
   }
 
   return 0;
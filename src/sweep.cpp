@@ -0,0 +1,52 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "stratum/cache_sim.hpp"
+#include "stratum/sweep.hpp"
+
+using namespace stratum;
+
+// ============================================================================
+// SWEEP CONFIGURATION (mirrors the experiments in scripts/config.rkt)
+// ============================================================================
+using MemType = MainMemory<"MainMemory">;
+
+template <typename Policy>
+using ThreeLevel =
+    Cache<"L1",
+          Cache<"L2", Cache<"L3", MemType, 8192, 16, 64, Policy, 64>, 512, 8,
+                64, Policy, 64>,
+          64, 8, 64, Policy, 4>;
+
+template <typename Policy>
+using TwoLevel =
+    Cache<"L1", Cache<"L2", MemType, 512, 8, 64, Policy, 64>, 64, 8, 64,
+          Policy, 4>;
+
+using Experiments =
+    SweepList<SweepConfig<"case_001", ThreeLevel<LRUPolicy>>,
+              SweepConfig<"case_002", TwoLevel<LRUPolicy>>,
+              SweepConfig<"case_003_fifo", ThreeLevel<FIFOPolicy>>,
+              SweepConfig<"case_004_random", TwoLevel<RandomPolicy>>>;
+
+// Usage: stratum_sweep [threads]   (default: one per hardware thread)
+int main(int argc, char** argv) {
+  const size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 0;
+
+  const std::string project_root = STRATUM_ROOT;
+  const std::vector<SweepTrace> traces = {
+      {"Sequential", project_root + "/test/data/sequential.txt"},
+      {"Random", project_root + "/test/data/random.txt"},
+      {"Temporal", project_root + "/test/data/temporal.txt"},
+      {"Spatial", project_root + "/test/data/spatial.txt"},
+      {"LargeLoop", project_root + "/test/data/largeloop.txt"},
+      {"Gaussian", project_root + "/test/data/gaussian.txt"}};
+
+  PrintSweepTable(RunSweep(Experiments{}, traces, threads));
+  return 0;
+}
@@ -2,15 +2,37 @@
 
 #include <fmt/core.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
 #include "stratum/cache_sim.hpp"
+#include "stratum/coherence.hpp"
+#include "stratum/dynamic_cache.hpp"
+#include "stratum/multicore.hpp"
+#include "stratum/prefilter.hpp"
+#include "stratum/progress.hpp"
+#include "stratum/sampling.hpp"
+#include "stratum/sharded.hpp"
+#include "stratum/stack_distance.hpp"
+#include "stratum/sweep.hpp"
+#include "stratum/timing.hpp"
+#include "stratum/trace_parser.hpp"
+
+using namespace stratum;
 
 // Simple manual test runner for now
 // In a real scenario, use GTest or Catch2
-int main() {
-    fmt::print("Running Unit Tests...\n");
-    
-    using namespace stratum;
-    
+bool TestEvictionLogic() {
     // Tiny Cache for testing evictions
     using Mem = MainMemory<"MainMemory">;
     using TinyCache = Cache<"Tiny", Mem, 1, 2, 64, LRUPolicy, 1>;
@@ -32,12 +54,1684 @@ int main() {
     // Load new block -> Should evict Way 1 (0x0040)
     auto res = cache->Load(0x0080);
     
-    if (res.hit_level == "MainMemory") {
+    // Level 1 below Tiny is MainMemory
+    if (res.hit_level == 1) {
         fmt::print("[PASS] Eviction Logic\n");
+        return true;
+    }
+    fmt::print("[FAIL] Eviction Logic. Expected level 1 (MainMemory), got {}\n", res.hit_level);
+    return false;
+}
+
+// Bottom layer that records the writebacks it receives.
+struct WritebackRecorder {
+    static constexpr std::string_view kName{"Recorder"};
+    static constexpr size_t kLevels = 1;
+    static constexpr LevelInfo kInfo{kName, 0, 0, 0, 0, true};
+    static inline std::vector<uint64_t> stores;
+
+    explicit WritebackRecorder(size_t) {}
+    AccessResult Load(uint64_t) { return {0, 100}; }
+    AccessResult Store(uint64_t addr) {
+        stores.push_back(addr);
+        return {0, 100};
+    }
+};
+
+// A write miss allocates the line dirty, so evicting it writes back once.
+bool TestWriteMissDirtyFill() {
+    using TinyCache = Cache<"Tiny", WritebackRecorder, 1, 2, 64, LRUPolicy, 1>;
+    WritebackRecorder::stores.clear();
+    auto cache = std::make_unique<TinyCache>(100);
+
+    cache->Store(0x0000);  // miss, filled dirty
+    cache->Load(0x0040);   // miss, clean
+    cache->Load(0x0080);   // evicts 0x0000 (LRU) -> writeback
+    cache->Load(0x00C0);   // evicts 0x0040 (clean) -> no writeback
+
+    if (WritebackRecorder::stores == std::vector<uint64_t>{0x0000}) {
+        fmt::print("[PASS] Write Miss Dirty Fill\n");
+        return true;
+    }
+    fmt::print("[FAIL] Write Miss Dirty Fill. Got {} writebacks\n",
+               WritebackRecorder::stores.size());
+    return false;
+}
+
+// Topology traits are resolved at compile time from the Cache<...> chain.
+namespace topology_check {
+using Mem = MainMemory<"MainMemory">;
+using L2 = Cache<"L2", Mem, 512, 8, 64, LRUPolicy, 10>;
+using L1 = Cache<"L1", L2, 64, 8, 64, LRUPolicy, 4>;
+constexpr auto kInfo = HierarchyInfo<L1>();
+static_assert(L1::kLevels == 3 && kInfo.size() == 3);
+static_assert(kInfo[0].name == "L1" && kInfo[0].sets == 64 &&
+              kInfo[0].hit_latency == 4);
+static_assert(kInfo[1].name == "L2" && kInfo[1].ways == 8);
+static_assert(kInfo[2].name == "MainMemory" && kInfo[2].is_memory);
+static_assert(HierarchyNames<L1>()[1] == "L2");
+
+// One arena holds tags, dirty masks and LRU state of every level.
+static_assert(L1::kArenaBytes ==
+              (64 * 8 * 8 + 64 * sizeof(WayMask) + 64 * 8 * 8 + 64 * 8) +
+                  (512 * 8 * 8 + 512 * sizeof(WayMask) + 512 * 8 * 8 +
+                   512 * 8));
+static_assert(LevelArenaBytes<Mem>() == 0);
+
+// Bit-sliced and general address mapping agree on decomposition.
+using Pow2 = AddressMapping<64, 64>;
+using Odd = AddressMapping<48, 64>;
+static_assert(Pow2::kPowerOfTwo && !Odd::kPowerOfTwo);
+static_assert(Pow2::SetIndex(0x12345) == (0x12345 / 64) % 64);
+static_assert(Pow2::Tag(0x12345) == 0x12345 / (64 * 64));
+static_assert(Odd::SetIndex(0x12345) == (0x12345 / 64) % 48);
+static_assert(Pow2::BlockAddress(Pow2::Tag(0x12345), Pow2::SetIndex(0x12345)) ==
+              0x12340);
+static_assert(Odd::BlockAddress(Odd::Tag(0x12345), Odd::SetIndex(0x12345)) ==
+              0x12340);
+}  // namespace topology_check
+
+// SIMD and scalar tag match must agree for every supported way count.
+template <size_t Ways>
+bool CheckMatchTags() {
+    uint64_t tags[Ways];
+    for (size_t round = 0; round < 64; ++round) {
+        for (size_t w = 0; w < Ways; ++w) {
+            tags[w] = ((w * 7 + round) % 5 == 0) ? kInvalidTag
+                                                 : (w + round) % 3;
+        }
+        for (uint64_t needle : {uint64_t{0}, uint64_t{1}, uint64_t{2},
+                                kInvalidTag}) {
+            WayMask expected = 0;
+            for (size_t w = 0; w < Ways; ++w) {
+                if (tags[w] == needle) expected |= WayMask{1} << w;
+            }
+            if (MatchTags<Ways>(tags, needle) != expected) return false;
+            TagLookup lookup = LookupTags<Ways>(tags, needle);
+            if (lookup.hit != expected ||
+                lookup.free != MatchTags<Ways>(tags, kInvalidTag)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool TestMatchTags() {
+    bool ok = CheckMatchTags<1>() && CheckMatchTags<2>() &&
+              CheckMatchTags<4>() && CheckMatchTags<6>() &&
+              CheckMatchTags<8>() && CheckMatchTags<12>() &&
+              CheckMatchTags<16>() && CheckMatchTags<32>() &&
+              CheckMatchTags<64>();
+    if (ok) {
+        fmt::print("[PASS] Tag Match\n");
+    } else {
+        fmt::print("[FAIL] Tag Match\n");
+    }
+    return ok;
+}
+
+// Replays `ops` and returns the hit count per level.
+template <typename System>
+std::vector<size_t> ReplayHits(const std::vector<TraceOp>& ops) {
+    auto system = std::make_unique<System>(100);
+    SimulationStats<System::kLevels> stats;
+    for (const auto& op : ops) {
+        stats.Record(op, op.type == 'L' ? system->Load(op.addr)
+                                        : system->Store(op.addr));
+    }
+    std::vector<size_t> hits;
+    for (size_t i = 0; i < System::kLevels; ++i) {
+        hits.push_back(stats.Level(i).hits);
+    }
+    return hits;
+}
+
+std::vector<TraceOp> LoadAllTestTraces() {
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    std::vector<TraceOp> all;
+    for (const char* name : {"sequential.txt", "random.txt", "temporal.txt",
+                             "spatial.txt", "largeloop.txt", "gaussian.txt"}) {
+        auto ops = ParseTraceFileMapped(data_dir + name);
+        all.insert(all.end(), ops.begin(), ops.end());
+    }
+    return all;
+}
+
+template <typename Policy>
+using PolicyHierarchy =
+    Cache<"L1", Cache<"L2", MainMemory<"MainMemory">, 16, 16, 64, Policy, 10>,
+          8, 8, 64, Policy, 4>;
+
+// PackedLRU is exact LRU; 2-way tree PLRU degenerates to exact LRU too.
+bool TestPackedPolicies() {
+    // Tree PLRU order on a 4-way set: touching 0,1,2,3 leaves 0 as victim,
+    // touching 0 then points to the other half (way 2).
+    TreePLRU<4> plru(1, 4);
+    for (size_t w = 0; w < 4; ++w) plru.OnFill(0, w);
+    bool ok = plru.GetVictim(0) == 0;
+    plru.OnHit(0, 0);
+    ok &= plru.GetVictim(0) == 2;
+
+    auto ops = LoadAllTestTraces();
+    auto lru = ReplayHits<PolicyHierarchy<LRUPolicy>>(ops);
+    ok &= ReplayHits<PolicyHierarchy<PackedLRUPolicy>>(ops) == lru;
+
+    using Lru2 = Cache<"L1", MainMemory<"MainMemory">, 64, 2, 64, LRUPolicy, 1>;
+    using Tree2 =
+        Cache<"L1", MainMemory<"MainMemory">, 64, 2, 64, TreePLRUPolicy, 1>;
+    ok &= ReplayHits<Lru2>(ops) == ReplayHits<Tree2>(ops);
+
+    if (ok) {
+        fmt::print("[PASS] Packed Policies\n");
+    } else {
+        fmt::print("[FAIL] Packed Policies\n");
+    }
+    return ok;
+}
+
+// Packed SRRIP must match the textbook "age all until one is distant" loop,
+// and keep a re-referenced working set alive across a scan.
+bool TestRRIP() {
+    constexpr size_t kWays = 8;
+    RRIP<kWays, RRIPMode::kStatic> packed(1, kWays);
+    std::array<int, kWays> ref;
+    ref.fill(3);
+
+    bool ok = true;
+    uint64_t lcg = 12345;
+    for (int step = 0; step < 10000 && ok; ++step) {
+        lcg = lcg * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t way = (lcg >> 33) % kWays;
+        if ((lcg >> 20) & 1) {
+            packed.OnHit(0, way);
+            ref[way] = 0;
+        } else {
+            size_t expected = 0;
+            while (true) {
+                auto it = std::find(ref.begin(), ref.end(), 3);
+                if (it != ref.end()) {
+                    expected = it - ref.begin();
+                    break;
+                }
+                for (auto& r : ref) r++;
+            }
+            ok = packed.GetVictim(0) == expected;
+            packed.OnFill(0, expected);
+            ref[expected] = 2;
+        }
+    }
+
+    // 4-way single set: A, B re-referenced, then a scan of E, F, G.
+    using Mem = MainMemory<"MainMemory">;
+    auto srrip = std::make_unique<Cache<"L1", Mem, 1, 4, 64, SRRIPPolicy>>(100);
+    auto lru = std::make_unique<Cache<"L1", Mem, 1, 4, 64, LRUPolicy>>(100);
+    for (uint64_t block : {0, 1, 2, 3, 0, 1, 4, 5, 6}) {
+        srrip->Load(block * 64);
+        lru->Load(block * 64);
+    }
+    ok &= srrip->Load(0).hit_level == 0 && srrip->Load(64).hit_level == 0;
+    ok &= lru->Load(0).hit_level == 1;
+
+    // All three variants run on the shared traces.
+    auto ops = LoadAllTestTraces();
+    ok &= ReplayHits<PolicyHierarchy<SRRIPPolicy>>(ops).size() == 3;
+    ok &= ReplayHits<PolicyHierarchy<BRRIPPolicy>>(ops).size() == 3;
+    ok &= ReplayHits<PolicyHierarchy<DRRIPPolicy>>(ops).size() == 3;
+
+    if (ok) {
+        fmt::print("[PASS] RRIP Policies\n");
+    } else {
+        fmt::print("[FAIL] RRIP Policies\n");
+    }
+    return ok;
+}
+
+// The zero-copy parser must agree with the reference stringstream parser.
+bool TestMappedParser() {
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    for (const char* name : {"sequential.txt", "random.txt", "temporal.txt",
+                             "spatial.txt", "largeloop.txt", "gaussian.txt"}) {
+        auto expected = ParseTraceFile(data_dir + name);
+        auto actual = ParseTraceFileMapped(data_dir + name);
+        bool same = expected.size() == actual.size();
+        for (size_t i = 0; same && i < expected.size(); ++i) {
+            same = expected[i].type == actual[i].type &&
+                   expected[i].addr == actual[i].addr;
+        }
+        if (!same || expected.empty()) {
+            fmt::print("[FAIL] Mapped Parser. Mismatch on {}\n", name);
+            return false;
+        }
+    }
+
+    // Edge cases: comments, CRLF, blanks, no 0x prefix, long and short
+    // addresses, trailing columns and a final line without newline.
+    const std::string text =
+        "# header\n\nL 0x1\r\n  S\t0xDEADbeefCAFE0123 extra\nL ff\n"
+        "L 0x\nS 0x123456789\n# c\nL 0x40";
+    std::vector<TraceOp> ops;
+    ForEachTraceOp(text, [&](const TraceOp& op) { ops.push_back(op); });
+    const std::vector<TraceOp> want = {{'L', 0x1},
+                                       {'S', 0xDEADBEEFCAFE0123ULL},
+                                       {'L', 0xFF},
+                                       {'S', 0x123456789ULL},
+                                       {'L', 0x40}};
+    bool same = ops.size() == want.size();
+    for (size_t i = 0; same && i < want.size(); ++i) {
+        same = ops[i].type == want[i].type && ops[i].addr == want[i].addr;
+    }
+    if (!same) {
+        fmt::print("[FAIL] Mapped Parser. Edge cases parsed incorrectly\n");
+        return false;
+    }
+
+    fmt::print("[PASS] Mapped Parser\n");
+    return true;
+}
+
+// Binary traces must round-trip through both record encodings.
+bool TestBinaryTraceRoundTrip() {
+    const std::vector<TraceOp> ops = {{'L', 0x1000}, {'S', 0x1040},
+                                      {'L', 0x40},   {'L', 0x7FFFFFFFFFC0ULL},
+                                      {'S', 0x0},    {'L', 0x1044}};
+    const std::string path = "unit_test_trace.bin";
+
+    for (auto encoding : {TraceEncoding::kPacked, TraceEncoding::kDeltaVarint}) {
+        for (uint32_t block_size : {1u, 64u}) {
+            bool same;
+            {
+                BinaryTraceWriter writer(path, block_size, encoding);
+                for (const auto& op : ops) writer.Append(op);
+                same = writer.Close() && writer.Ok();
+            }
+
+            BinaryTraceReader reader(path);
+            std::vector<TraceOp> batch;
+            same &= reader.IsOpen() &&
+                    reader.ReadBatch(batch) == ops.size() &&
+                    reader.Header().op_count == ops.size();
+            for (size_t i = 0; same && i < ops.size(); ++i) {
+                same = batch[i].type == ops[i].type &&
+                       batch[i].addr == ops[i].addr / block_size * block_size;
+            }
+            if (!same) {
+                fmt::print("[FAIL] Binary Trace. encoding={} block_size={}\n",
+                           static_cast<int>(encoding), block_size);
+                std::remove(path.c_str());
+                return false;
+            }
+        }
+    }
+
+    // Unknown record encodings are rejected, not decoded as varints.
+    std::string bad;
+    {
+        BinaryTraceWriter writer(bad);
+        for (const auto& op : ops) writer.Append(op);
+    }
+    bad[offsetof(BinaryTraceHeader, encoding)] = 7;
+    if (BinaryTraceReader(std::string_view(bad)).IsOpen()) {
+        fmt::print("[FAIL] Binary Trace. unknown encoding accepted\n");
+        std::remove(path.c_str());
+        return false;
+    }
+    std::remove(path.c_str());
+
+    // Failed opens and writes are reported, and Append after a failed open
+    // does nothing.
+    bool ok = true;
+    {
+        BinaryTraceWriter missing("no_such_dir/unit_test_trace.bin");
+        for (const auto& op : ops) missing.Append(op);
+        ok &= !missing.IsOpen() && !missing.Ok() && !missing.Close();
+    }
+    if (std::filesystem::exists("/dev/full")) {
+        BinaryTraceWriter full("/dev/full");
+        for (const auto& op : ops) full.Append(op);
+        ok &= !full.Close() && !full.Ok();
+    }
+    if (!ok) {
+        fmt::print("[FAIL] Binary Trace. write errors\n");
+        return false;
+    }
+    fmt::print("[PASS] Binary Trace\n");
+    return true;
+}
+
+// A parallel sweep must report exactly what a serial replay of each
+// (configuration, trace) pair does, for both text and binary traces.
+bool TestSweep() {
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    const std::string bin_path = "unit_test_sweep.bin";
+    const auto temporal = ParseTraceFileMapped(data_dir + "temporal.txt");
+    {
+        BinaryTraceWriter writer(bin_path, 1, TraceEncoding::kDeltaVarint);
+        for (const auto& op : temporal) writer.Append(op);
+    }
+
+    const std::vector<SweepTrace> traces = {
+        {"Random", data_dir + "random.txt"},
+        {"Gaussian", data_dir + "gaussian.txt"},
+        {"TemporalBin", bin_path}};
+    using Configs = SweepList<SweepConfig<"lru", PolicyHierarchy<LRUPolicy>>,
+                              SweepConfig<"srrip", PolicyHierarchy<SRRIPPolicy>>>;
+    const auto results = RunSweep(Configs{}, traces, 4);
+
+    auto hits_of = [](const SweepResult& r) {
+        std::vector<size_t> hits;
+        for (const auto& level : r.levels) hits.push_back(level.stats.hits);
+        return hits;
+    };
+    const std::vector<std::vector<TraceOp>> ops = {
+        ParseTraceFileMapped(data_dir + "random.txt"),
+        ParseTraceFileMapped(data_dir + "gaussian.txt"), temporal};
+
+    bool ok = results.size() == 6;
+    for (size_t t = 0; ok && t < ops.size(); ++t) {
+        const auto& lru = results[t * 2];
+        const auto& srrip = results[t * 2 + 1];
+        ok = lru.trace == traces[t].name && lru.config == "lru" &&
+             srrip.config == "srrip" && lru.accesses == ops[t].size() &&
+             hits_of(lru) == ReplayHits<PolicyHierarchy<LRUPolicy>>(ops[t]) &&
+             hits_of(srrip) == ReplayHits<PolicyHierarchy<SRRIPPolicy>>(ops[t]);
+    }
+    std::remove(bin_path.c_str());
+
+    if (ok) {
+        fmt::print("[PASS] Sweep\n");
+    } else {
+        fmt::print("[FAIL] Sweep\n");
+    }
+    return ok;
+}
+
+using ShardL3 =
+    Cache<"L3", MainMemory<"MainMemory">, 8192, 16, 64, LRUPolicy, 20>;
+using ShardL2 = Cache<"L2", ShardL3, 512, 8, 128, PackedLRUPolicy, 10>;
+using ShardL1 = Cache<"L1", ShardL2, 64, 8, 64, TreePLRUPolicy, 4>;
+
+// Shard bits sit above the widest block offset and inside every set index.
+static_assert(ShardGeometry<ShardL1>::kShift == 7);
+static_assert(ShardGeometry<ShardL1>::kMaxShards == 32);
+static_assert(
+    ShardGeometry<Cache<"L1", MainMemory<"M">, 48, 4, 64>>::kMaxShards == 1);
+static_assert(HierarchyIsSetLocal<ShardL1>() &&
+              !HierarchyIsSetLocal<PolicyHierarchy<DRRIPPolicy>>());
+static_assert(ShardL1::Sharded<8>::Next::kSets == 64);
+
+// Set-sharded replay of set-local policies must match the serial run
+// exactly, including the head-of-trace access log.
+bool TestShardedSimulation() {
+    auto ops = LoadAllTestTraces();
+    auto serial = std::make_unique<ShardL1>(100);
+    SimulationStats<ShardL1::kLevels> expected;
+    std::vector<AccessResult> expected_log;
+    for (const auto& op : ops) {
+        auto res = op.type == 'L' ? serial->Load(op.addr)
+                                  : serial->Store(op.addr);
+        expected.Record(op, res);
+        if (expected_log.size() <= kAccessLogLimit) expected_log.push_back(res);
+    }
+
+    bool ok = true;
+    for (size_t threads : {1, 4, 64}) {
+        SpanTraceReader reader(ops);
+        auto run = SimulateSharded<ShardL1>(reader, threads, 100);
+        ok &= run.shards == std::min<size_t>(threads, 32);
+        ok &= run.stats.Accesses() == expected.Accesses();
+        for (size_t i = 0; i < ShardL1::kLevels; ++i) {
+            ok &= run.stats.Level(i).hits == expected.Level(i).hits &&
+                  run.stats.Level(i).total_latency ==
+                      expected.Level(i).total_latency;
+        }
+        ok &= run.log_history.size() == expected_log.size();
+        for (size_t i = 0; ok && i < expected_log.size(); ++i) {
+            ok = run.log_history[i].hit_level == expected_log[i].hit_level &&
+                 run.log_addrs[i] == ops[i].addr;
+        }
+    }
+
+    if (ok) {
+        fmt::print("[PASS] Sharded Simulation\n");
+    } else {
+        fmt::print("[FAIL] Sharded Simulation\n");
+    }
+    return ok;
+}
+
+// The batched entry points must give exactly the per-access results.
+bool TestAccessBatch() {
+    using Hierarchy = Cache<"L1", ShardL2, 8, 4, 64, SRRIPPolicy, 4>;
+    auto ops = LoadAllTestTraces();
+    std::vector<uint64_t> addrs;
+    for (const auto& op : ops) addrs.push_back(op.addr);
+
+    auto serial = std::make_unique<Hierarchy>(100);
+    auto batched = std::make_unique<Hierarchy>(100);
+    auto loads = std::make_unique<Hierarchy>(100);
+    std::vector<AccessResult> results(ops.size());
+    std::vector<AccessResult> load_results(ops.size());
+    batched->AccessBatch(ops, results);
+    loads->LoadBatch(addrs, load_results);
+
+    auto loads_serial = std::make_unique<Hierarchy>(100);
+    bool ok = true;
+    for (size_t i = 0; ok && i < ops.size(); ++i) {
+        auto expected = ops[i].type == 'L' ? serial->Load(ops[i].addr)
+                                           : serial->Store(ops[i].addr);
+        auto expected_load = loads_serial->Load(addrs[i]);
+        ok = results[i].hit_level == expected.hit_level &&
+             results[i].total_cycles == expected.total_cycles &&
+             load_results[i].hit_level == expected_load.hit_level &&
+             load_results[i].total_cycles == expected_load.total_cycles;
+    }
+
+    if (ok) {
+        fmt::print("[PASS] Access Batch\n");
+    } else {
+        fmt::print("[FAIL] Access Batch\n");
+    }
+    return ok;
+}
+
+template <typename Hierarchy>
+std::vector<AccessResult> Replay(Hierarchy& cache,
+                                 std::span<const TraceOp> ops) {
+    std::vector<AccessResult> results;
+    for (const auto& op : ops) {
+        results.push_back(op.type == 'L' ? cache.Load(op.addr)
+                                         : cache.Store(op.addr));
+    }
+    return results;
+}
+
+bool SameResults(const std::vector<AccessResult>& a,
+                 const std::vector<AccessResult>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](const AccessResult& x, const AccessResult& y) {
+                          return x.hit_level == y.hit_level &&
+                                 x.total_cycles == y.total_cycles;
+                      });
+}
+
+// Warm on a prefix, snapshot, and check that every way of getting the
+// warm state back (in memory, from disk, after Reset) replays the suffix
+// identically.
+template <typename Hierarchy>
+bool CheckSnapshot(const std::vector<TraceOp>& ops) {
+    const auto warmup = std::span(ops).first(ops.size() / 2);
+    const auto rest = std::span(ops).subspan(ops.size() / 2);
+    const std::string path = "unit_test_snapshot.bin";
+
+    auto cache = std::make_unique<Hierarchy>(100);
+    Replay(*cache, warmup);
+    const CacheSnapshot snapshot = cache->Snapshot();
+    const auto expected = Replay(*cache, rest);
+
+    bool ok = cache->Restore(snapshot);
+    ok &= SameResults(Replay(*cache, rest), expected);
+
+    ok &= SaveSnapshot(snapshot, path);
+    auto loaded = LoadSnapshot(path);
+    std::remove(path.c_str());
+    auto restored = std::make_unique<Hierarchy>(100);
+    ok &= loaded.has_value() && restored->Restore(*loaded);
+    ok &= SameResults(Replay(*restored, rest), expected);
+
+    // Reset must be indistinguishable from a fresh hierarchy (except for
+    // RandomPolicy, which reseeds like a fresh one would).
+    if constexpr (!std::is_same_v<typename Hierarchy::Policy, RandomPolicy>) {
+        auto fresh = std::make_unique<Hierarchy>(100);
+        cache->Reset();
+        ok &= SameResults(Replay(*cache, ops), Replay(*fresh, ops));
+    }
+    return ok;
+}
+
+bool TestSnapshot() {
+    using RandomFifo =
+        Cache<"L1", Cache<"L2", ShardL3, 64, 8, 64, FIFOPolicy, 10>, 8, 4, 64,
+              RandomPolicy, 4>;
+    using Dueling = Cache<"L1", ShardL2, 8, 4, 64, DRRIPPolicy, 4>;
+    auto ops = LoadAllTestTraces();
+
+    bool ok = CheckSnapshot<ShardL1>(ops) && CheckSnapshot<RandomFifo>(ops) &&
+              CheckSnapshot<Dueling>(ops);
+
+    // Mismatched configurations and truncated payloads are rejected.
+    auto l1 = std::make_unique<ShardL1>(100);
+    auto dueling = std::make_unique<Dueling>(100);
+    CacheSnapshot truncated = l1->Snapshot();
+    truncated.payload.pop_back();
+    ok &= !dueling->Restore(l1->Snapshot()) && !l1->Restore(truncated);
+    // Same geometry and policy state size, different policy.
+    using Static = Cache<"L1", ShardL2, 8, 4, 64, SRRIPPolicy, 4>;
+    using Bimodal = Cache<"L1", ShardL2, 8, 4, 64, BRRIPPolicy, 4>;
+    static_assert(Static::kArenaBytes == Bimodal::kArenaBytes);
+    auto bimodal = std::make_unique<Bimodal>(100);
+    ok &= !bimodal->Restore(std::make_unique<Static>(100)->Snapshot()) &&
+          !bimodal->Restore(dueling->Snapshot());
+
+    // A header claiming more payload than the file holds is rejected
+    // without allocating for it.
+    const std::string path = "unit_test_bad_snapshot.bin";
+    for (uint64_t size : {uint64_t{1} << 62, uint64_t{9}}) {
+        SnapshotFileHeader header;
+        header.payload_size = size;
+        std::ofstream(path, std::ios::binary)
+            .write(reinterpret_cast<const char*>(&header), sizeof(header))
+            .write("12345678", 8);
+        ok &= !LoadSnapshot(path).has_value();
+    }
+    std::remove(path.c_str());
+
+    if (ok) {
+        fmt::print("[PASS] Snapshot\n");
+    } else {
+        fmt::print("[FAIL] Snapshot\n");
+    }
+    return ok;
+}
+
+// Sampled replay measures exactly the accesses of its windows, with the
+// same results a full run gives at those positions under functional
+// warming.
+bool TestSampledSimulation() {
+    using Hierarchy = PolicyHierarchy<LRUPolicy>;
+    constexpr size_t kLevels = Hierarchy::kLevels;
+    auto ops = LoadAllTestTraces();
+    bool ok = true;
+
+    auto full = std::make_unique<Hierarchy>(100);
+    const auto expected = Replay(*full, ops);
+
+    // Windows [period - interval, period) of every period.
+    const auto schedule = SampleSchedule::Periodic(100, 30, 10);
+    SimulationStats<kLevels> windowed;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        if (i % 100 >= 70) windowed.Record(ops[i], expected[i]);
+    }
+    {
+        auto cache = std::make_unique<Hierarchy>(100);
+        SpanTraceReader reader(ops);
+        auto run = SimulateSampled(reader, *cache, schedule);
+        ok &= run.total_ops == ops.size() && run.simulated_ops == ops.size();
+        ok &= run.windows.size() == (ops.size() + 99) / 100;
+        ok &= run.measured.Accesses() == windowed.Accesses();
+        for (size_t i = 0; i < kLevels; ++i) {
+            ok &= run.measured.Level(i).hits == windowed.Level(i).hits &&
+                  run.measured.Level(i).total_latency ==
+                      windowed.Level(i).total_latency;
+        }
+        ok &= std::isfinite(run.Amat().half_width) &&
+              run.HitRate(0).mean > 0.0 && run.HitRate(0).mean <= 1.0;
+    }
+
+    // SimPoint windows without functional warming simulate only the
+    // windows and their warmup, and stop reading after the last one.
+    const std::string simpoints = "unit_test.simpoints";
+    const std::string weights = "unit_test.weights";
+    std::ofstream(simpoints) << "3 0\n1 1\n";
+    std::ofstream(weights) << "0.75 0\n0.25 1\n";
+    auto simpoint = LoadSimPointSchedule(simpoints, weights, 50, 20,
+                                         /*functional_warming=*/false);
+    std::remove(simpoints.c_str());
+    std::remove(weights.c_str());
+    ok &= simpoint.has_value();
+    if (simpoint) {
+        auto cache = std::make_unique<Hierarchy>(100);
+        SpanTraceReader reader(ops);
+        auto run = SimulateSampled(reader, *cache, *simpoint);
+        ok &= run.windows.size() == 2 && run.measured.Accesses() == 100 &&
+              run.simulated_ops == 140 && run.weights[0] == 0.25 &&
+              run.weights[1] == 0.75;
+    }
+
+    const std::vector<double> values = {1.0, 2.0, 3.0, 4.0};
+    const std::vector<double> equal = {1.0, 1.0, 1.0, 1.0};
+    const auto e = EstimateMean(values, equal);
+    ok &= std::abs(e.mean - 2.5) < 1e-9 &&
+          std::abs(e.half_width - 1.959964 * std::sqrt(5.0 / 12.0)) < 1e-6;
+
+    if (ok) {
+        fmt::print("[PASS] Sampled Simulation\n");
+    } else {
+        fmt::print("[FAIL] Sampled Simulation\n");
+    }
+    return ok;
+}
+
+template <size_t Ways>
+size_t LruHits(const std::vector<TraceOp>& ops) {
+    auto cache =
+        std::make_unique<Cache<"L1", MainMemory<"M">, 8, Ways, 64>>(100);
+    size_t hits = 0;
+    for (const auto& r : Replay(*cache, ops)) hits += r.hit_level == 0;
+    return hits;
+}
+
+// One stack-distance pass must reproduce LRUPolicy's hits at every
+// associativity, including across Fenwick tree compactions.
+bool TestStackDistance() {
+    auto ops = LoadAllTestTraces();
+    StackDistanceProfile profile(64, 8, 16);
+    profile.AccessBatch(ops);
+    bool ok = profile.Accesses() == ops.size() &&
+              profile.Hits(1) == LruHits<1>(ops) &&
+              profile.Hits(2) == LruHits<2>(ops) &&
+              profile.Hits(4) == LruHits<4>(ops) &&
+              profile.Hits(16) == LruHits<16>(ops);
+
+    // Fully associative, small initial tree: distances across compactions.
+    LruStack stack(2);
+    for (uint64_t round = 0; round < 3; ++round) {
+        for (uint64_t block = 0; block < 5; ++block) {
+            const uint64_t d = stack.Access(block);
+            ok &= round == 0 ? d == LruStack::kColdMiss : d == 4;
+        }
+    }
+    ok &= stack.Access(4) == 0 && stack.Access(0) == 4 &&
+          stack.DistinctBlocks() == 5;
+
+    // Set sampling only tracks every other set.
+    StackDistanceProfile sampled(64, 8, 4, /*max_sampled_sets=*/4);
+    sampled.AccessBatch(ops);
+    ok &= sampled.Sampled() && sampled.Accesses() < ops.size();
+
+    if (ok) {
+        fmt::print("[PASS] Stack Distance\n");
+    } else {
+        fmt::print("[FAIL] Stack Distance\n");
+    }
+    return ok;
+}
+
+static_assert(std::is_empty_v<LevelCounters<false>>);
+
+// Per-level counters walk the whole chain and stay consistent with each
+// other; interval dumps add up to the totals.
+bool TestInstrumentation() {
+    using L2 = Cache<"L2", MainMemory<"M">, 16, 4, 64, LRUPolicy, 10>;
+    using L1 = Cache<"L1", L2, 4, 2, 64, LRUPolicy, 4>;
+    auto ops = LoadAllTestTraces();
+    auto cache = std::make_unique<L1>(100);
+
+    std::FILE* csv = std::tmpfile();
+    std::FILE* json = std::tmpfile();
+    IntervalStatsDumper csv_dump(*cache, csv, 100, StatsDumpFormat::kCsv);
+    IntervalStatsDumper json_dump(*cache, json, 100, StatsDumpFormat::kJson);
+    SpanTraceReader reader(ops);
+    ReplayTrace(reader, *cache, [&](const TraceOp&, const AccessResult&) {
+        csv_dump.Tick();
+        json_dump.Tick();
+    });
+    csv_dump.Finish();
+    json_dump.Finish();
+
+    auto read_all = [](std::FILE* f) {
+        std::string text;
+        std::rewind(f);
+        for (int c; (c = std::fgetc(f)) != EOF;) text.push_back(char(c));
+        std::fclose(f);
+        return text;
+    };
+    const std::string csv_text = read_all(csv);
+    const std::string json_text = read_all(json);
+    const size_t intervals = (ops.size() + 99) / 100;
+
+    bool ok = true;
+    if constexpr (kInstrumentation) {
+        const auto stats = CollectLevelStats(*cache);
+        ok &= stats.size() == 2 && stats[0].name == "L1";
+        ok &= stats[0].hits + stats[0].misses == ops.size() &&
+              stats[0].latency.Count() == ops.size();
+        ok &= stats[1].writebacks == stats[0].evictions &&
+              stats[1].hits + stats[1].misses ==
+                  stats[0].misses + stats[0].evictions;
+
+        // Sum the L1 hit column of the CSV intervals.
+        uint64_t csv_hits = 0;
+        size_t pos = csv_text.find('\n') + 1;
+        while (pos < csv_text.size()) {
+            const size_t end = csv_text.find('\n', pos);
+            const std::string row = csv_text.substr(pos, end - pos);
+            if (row.find(",L1,") != std::string::npos) {
+                csv_hits += std::stoull(row.substr(row.find(",L1,") + 4));
+            }
+            pos = end + 1;
+        }
+        ok &= csv_hits == stats[0].hits;
+    }
+    const auto lines = [](const std::string& text) {
+        return static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+    };
+    ok &= lines(csv_text) == 1 + 2 * intervals &&
+          lines(json_text) == intervals &&
+          json_text.starts_with(
+              "{\"accesses\":100,\"levels\":[{\"name\":\"L1\"");
+
+    if (ok) {
+        fmt::print("[PASS] Instrumentation\n");
+    } else {
+        fmt::print("[FAIL] Instrumentation\n");
+    }
+    return ok;
+}
+
+// Log-linear buckets are exact for small values, tight for large ones,
+// and merged histograms answer like one built from all the values.
+bool TestLatencyHistogram() {
+    using H = LogLinearHistogram<>;
+    bool ok = true;
+    for (uint64_t v = 0; v < 64; ++v) {
+        ok &= H::BucketFloor(H::BucketIndex(v)) == v &&
+              H::BucketCeil(H::BucketIndex(v)) == v;
+    }
+    for (uint64_t v = 64; v < (uint64_t{1} << 20); v = v * 5 / 4 + 1) {
+        const size_t b = H::BucketIndex(v);
+        ok &= H::BucketFloor(b) <= v && v <= H::BucketCeil(b) &&
+              H::BucketCeil(b) - H::BucketFloor(b) < v / 32 + 1;
+    }
+    ok &= H::BucketIndex(~uint64_t{0}) == H::kBuckets - 1;
+
+    H low;
+    H high;
+    H all;
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        (v <= 500 ? low : high).Record(v);
+        all.Record(v);
+    }
+    H merged = low;
+    merged.Merge(high);
+    ok &= merged.Count() == 1000 && merged.Min() == 1 && merged.Max() == 1000;
+    const uint64_t p50 = merged.Percentile(50);
+    ok &= p50 >= 500 && p50 <= 500 + 500 / 32 &&
+          merged.Percentile(99.9) <= 1000 && merged.Percentile(100) == 1000 &&
+          merged.Percentile(50) == all.Percentile(50);
+    ok &= all.Since(low).Count() == 500 &&
+          all.Since(low).Min() >= 500 - 500 / 32;
+
+    // Per-type and per-level histograms partition every access, and a
+    // two-way split merges back to the serial distribution.
+    auto ops = LoadAllTestTraces();
+    auto cache = std::make_unique<ShardL1>(100);
+    const auto results = Replay(*cache, ops);
+    SimulationStats<ShardL1::kLevels> serial;
+    SimulationStats<ShardL1::kLevels> halves[2];
+    for (size_t i = 0; i < ops.size(); ++i) {
+        serial.Record(ops[i], results[i]);
+        halves[i % 2].Record(ops[i], results[i]);
+    }
+    halves[0].Merge(halves[1]);
+    size_t by_level = 0;
+    for (size_t i = 0; i < ShardL1::kLevels; ++i) {
+        by_level += serial.LevelLatency(i).Count();
+    }
+    ok &= by_level == ops.size() &&
+          serial.TypeLatency(AccessType::kLoad).Count() +
+                  serial.TypeLatency(AccessType::kStore).Count() ==
+              ops.size();
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        ok &= halves[0].Latency().Percentile(p) ==
+              serial.Latency().Percentile(p);
+    }
+
+    if (ok) {
+        fmt::print("[PASS] Latency Histogram\n");
+    } else {
+        fmt::print("[FAIL] Latency Histogram\n");
+    }
+    return ok;
+}
+
+// Replaying the L1 miss stream into the lower levels reproduces the full
+// hierarchy: per-level stats, and the lower levels' own counters.
+bool TestPrefilter() {
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    const std::vector<SweepTrace> traces = {
+        {"Random", data_dir + "random.txt"},
+        {"Temporal", data_dir + "temporal.txt"},
+        {"Spatial", data_dir + "spatial.txt"}};
+    using Lower = SweepList<SweepConfig<"l2", ShardL2>>;
+    const auto filtered = RunFilteredSweep<ShardL1>(Lower{}, traces, 2);
+
+    bool ok = filtered.size() == traces.size();
+    for (size_t t = 0; ok && t < traces.size(); ++t) {
+        const auto ops = ParseTraceFileMapped(traces[t].path);
+        auto full = std::make_unique<ShardL1>(100);
+        const auto results = Replay(*full, ops);
+        SimulationStats<ShardL1::kLevels> stats;
+        for (size_t i = 0; i < ops.size(); ++i) {
+            stats.Record(ops[i], results[i]);
+        }
+
+        ok &= filtered[t].accesses == ops.size() &&
+              filtered[t].levels.size() == ShardL1::kLevels &&
+              filtered[t].levels[0].name == "L1";
+        for (size_t i = 0; ok && i < ShardL1::kLevels; ++i) {
+            const CacheStats a = filtered[t].levels[i].stats;
+            const CacheStats b = stats.Level(i);
+            ok &= a.hits == b.hits && a.misses == b.misses &&
+                  a.total_latency == b.total_latency;
+        }
+
+        SpanTraceReader reader(ops);
+        const FilteredTrace stream = FilterTraceToMemory<ShardL1>(reader);
+        auto lower = std::make_unique<ShardL2>(100);
+        const auto run = RunFiltered(stream, *lower);
+        ok &= stream.l1.hits == stats.Level(0).hits &&
+              std::abs(run.Amat() - filtered[t].Amat()) < 1e-9;
+
+        // A stream filtered to a file replays later with its stored stats.
+        const std::string path = "unit_test_filter.bin";
+        SpanTraceReader file_reader(ops);
+        ok &= FilterTraceToFile<ShardL1>(file_reader, path).has_value();
+        auto later = std::make_unique<ShardL2>(100);
+        const auto from_file = RunFilteredFile(path, *later);
+        ok &= from_file.has_value() && from_file->l1.name == "L1" &&
+              from_file->l1.accesses == ops.size() &&
+              std::abs(from_file->Amat() - run.Amat()) < 1e-9;
+        // Stats of another pass do not fit the stream.
+        FilterStats other = stream.l1;
+        other.misses++;
+        ok &= SaveFilterStats(other, FilterStatsPath(path)) &&
+              !RunFilteredFile(path, *later).has_value();
+        std::remove(path.c_str());
+        std::remove(FilterStatsPath(path).c_str());
+        if constexpr (kInstrumentation) {
+            const auto want = CollectLevelStats(*full->GetNext());
+            const auto got = CollectLevelStats(*lower);
+            for (size_t i = 0; ok && i < want.size(); ++i) {
+                ok &= got[i].hits == want[i].hits &&
+                      got[i].misses == want[i].misses &&
+                      got[i].evictions == want[i].evictions &&
+                      got[i].writebacks == want[i].writebacks;
+            }
+            ok &= stream.l1.writebacks == full->Stats().evictions;
+        }
+        // temporal: 5 hot blocks; spatial: 8 accesses per block.
+        if (traces[t].name != "Random") ok &= stream.l1.Reduction() >= 8.0;
+    }
+
+    if (ok) {
+        fmt::print("[PASS] Prefilter\n");
+    } else {
+        fmt::print("[FAIL] Prefilter\n");
+    }
+    return ok;
+}
+
+// Stride and stream detection on synthetic block sequences, and prefetch
+// fills that never count as demand accesses anywhere in the hierarchy.
+template <typename Prefetcher>
+std::vector<uint64_t> PrefetchesFor(const std::vector<uint64_t>& misses) {
+    Prefetcher prefetcher;
+    std::vector<uint64_t> issued;
+    for (uint64_t block : misses) {
+        prefetcher.OnAccess(block, false, false,
+                            [&](uint64_t b) { issued.push_back(b); });
+    }
+    return issued;
+}
+
+using PrefetchL2 =
+    Cache<"L2", MainMemory<"MainMemory">, 512, 8, 64, LRUPolicy, 64>;
+template <typename Prefetcher>
+using PrefetchHierarchy =
+    Cache<"L1", PrefetchL2, 64, 8, 64, LRUPolicy, 4, Prefetcher>;
+
+bool TestPrefetchers() {
+    bool ok = PrefetchesFor<NextLinePrefetcher<2>>({10}) ==
+              std::vector<uint64_t>{11, 12};
+    // Stride 3 is confirmed on the third access; an access to another
+    // region does not disturb it.
+    ok &= PrefetchesFor<StridePrefetcher<64, 64, 2>>({0, 3, 6, 100, 9}) ==
+          std::vector<uint64_t>{9, 12, 12, 15};
+    // A descending stream is confirmed on its third miss.
+    ok &= PrefetchesFor<StreamPrefetcher<4, 4, 2>>({50, 49, 48}) ==
+          std::vector<uint64_t>{47, 46};
+
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    for (const char* name : {"sequential.txt", "largeloop.txt"}) {
+        const auto ops = ParseTraceFileMapped(data_dir + name);
+        using Next = PrefetchHierarchy<NextLinePrefetcher<>>;
+        using Stride = PrefetchHierarchy<StridePrefetcher<>>;
+        using Stream = PrefetchHierarchy<StreamPrefetcher<>>;
+        auto base = std::make_unique<PrefetchHierarchy<NoPrefetcher>>(100);
+        auto next = std::make_unique<Next>(100);
+        auto stride = std::make_unique<Stride>(100);
+        auto stream = std::make_unique<Stream>(100);
+        const auto base_results = Replay(*base, ops);
+        size_t base_l1_hits = 0;
+        for (const auto& r : base_results) base_l1_hits += r.hit_level == 0;
+        for (const auto& results :
+             {Replay(*next, ops), Replay(*stride, ops), Replay(*stream, ops)}) {
+            size_t l1_hits = 0;
+            for (const auto& r : results) l1_hits += r.hit_level == 0;
+            ok &= l1_hits > base_l1_hits + ops.size() / 2;
+        }
+        if constexpr (kInstrumentation) {
+            for (const auto& stats : {CollectLevelStats(*next),
+                                      CollectLevelStats(*stride),
+                                      CollectLevelStats(*stream)}) {
+                const LevelStats& l1 = stats[0];
+                const LevelStats& l2 = stats[1];
+                ok &= l1.hits + l1.misses == ops.size() &&
+                      l1.prefetch_hits <= l1.prefetches &&
+                      l1.prefetch_hits + l1.prefetch_unused <= l1.prefetches &&
+                      l1.PrefetchAccuracy() > 0.9 &&
+                      l1.PrefetchCoverage() > 0.9;
+                // Only demand misses and writebacks reach L2 as accesses.
+                ok &= l2.hits + l2.misses == l1.misses + l1.evictions;
+            }
+        }
+    }
+
+    auto ops = LoadAllTestTraces();
+    ok &= CheckSnapshot<PrefetchHierarchy<StreamPrefetcher<>>>(ops) &&
+          CheckSnapshot<PrefetchHierarchy<StridePrefetcher<>>>(ops);
+    static_assert(
+        !HierarchyIsSetLocal<PrefetchHierarchy<NextLinePrefetcher<>>>());
+    static_assert(HierarchyIsSetLocal<PrefetchHierarchy<NoPrefetcher>>());
+
+    if (ok) {
+        fmt::print("[PASS] Prefetchers\n");
     } else {
-        fmt::print("[FAIL] Eviction Logic. Expected 'MainMemory', got '{}'\n", res.hit_level);
-        return 1;
+        fmt::print("[FAIL] Prefetchers\n");
+    }
+    return ok;
+}
+
+// Private L1 (with a prefetcher) and L2 per core over one shared L3: the
+// batched multi-core run must match accessing one shared L3 op by op.
+using MultiL3 = Cache<"L3", MainMemory<"MainMemory">, 256, 16, 64, LRUPolicy,
+                      40>;
+using MultiCore =
+    Cache<"L1", Cache<"L2", SharedLevel<MultiL3>, 64, 8, 64, LRUPolicy, 10>,
+          16, 4, 64, LRUPolicy, 4, NextLinePrefetcher<>>;
+static_assert(MultiCore::kLevels == 4 &&
+              MultiCoreSystem<MultiCore>::kPrivateLevels == 2 &&
+              HierarchyNames<MultiCore>()[2] == "L3");
+
+bool TestMultiCore() {
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    std::vector<std::vector<TraceOp>> traces;
+    for (const char* name : {"sequential.txt", "random.txt", "temporal.txt",
+                             "largeloop.txt"}) {
+        traces.push_back(ParseTraceFileMapped(data_dir + name));
+    }
+    constexpr size_t kQuantum = 3;
+
+    // Reference: the same interleaving, one access at a time.
+    auto l3 = std::make_unique<MultiL3>(100);
+    std::vector<std::unique_ptr<MultiCore>> cores;
+    for (size_t c = 0; c < traces.size(); ++c) {
+        cores.push_back(std::make_unique<MultiCore>(*l3));
     }
+    std::vector<size_t> pos(traces.size(), 0);
+    std::vector<CoreTraceOp> order;
+    std::vector<AccessResult> expected;
+    for (bool more = true; more;) {
+        more = false;
+        for (size_t c = 0; c < traces.size(); ++c) {
+            for (size_t q = 0; q < kQuantum && pos[c] < traces[c].size();
+                 ++q) {
+                const TraceOp& op = traces[c][pos[c]++];
+                order.push_back({op, static_cast<uint32_t>(c)});
+                expected.push_back(op.type == 'L' ? cores[c]->Load(op.addr)
+                                                  : cores[c]->Store(op.addr));
+                more = true;
+            }
+        }
+    }
+
+    bool ok = true;
+    for (size_t threads : {1, 4}) {
+        std::vector<std::unique_ptr<SpanTraceReader>> readers;
+        for (const auto& trace : traces) {
+            readers.push_back(std::make_unique<SpanTraceReader>(trace));
+        }
+        RoundRobinInterleaver<SpanTraceReader> interleaver(std::move(readers),
+                                                           kQuantum);
+        std::vector<CoreTraceOp> merged;
+        std::vector<CoreTraceOp> batch;
+        while (interleaver.ReadBatch(batch, 1000) > 0) {
+            merged.insert(merged.end(), batch.begin(), batch.end());
+        }
+        ok &= merged.size() == order.size();
+        for (size_t i = 0; ok && i < merged.size(); ++i) {
+            ok &= merged[i].core == order[i].core &&
+                  merged[i].op.addr == order[i].op.addr;
+        }
+
+        MultiCoreSystem<MultiCore> system(traces.size());
+        std::vector<AccessResult> results(merged.size());
+        system.AccessBatch(merged, results, threads);
+        for (size_t i = 0; ok && i < results.size(); ++i) {
+            ok &= results[i].hit_level == expected[i].hit_level &&
+                  results[i].total_cycles == expected[i].total_cycles;
+        }
+        if constexpr (kInstrumentation) {
+            const LevelStats want = l3->Stats();
+            const LevelStats got = system.SharedLevels().Stats();
+            ok &= got.hits == want.hits && got.misses == want.misses &&
+                  got.writebacks == want.writebacks &&
+                  got.prefetches == want.prefetches;
+            ok &= system.Core(0).Stats().prefetches > 0;
+        }
+    }
+
+    // Timestamp merge: ties go to the lower core; a line without a
+    // timestamp repeats the previous one.
+    const std::string path0 = "unit_test_core0.txt";
+    const std::string path1 = "unit_test_core1.txt";
+    std::ofstream(path0) << "L 0x0 1\nL 0x40 4\nS 0x80 9\n";
+    std::ofstream(path1) << "L 0x1000 2\nL 0x1040\nL 0x1080 10\n";
+    {
+        std::vector<std::unique_ptr<TimestampedTraceReader>> readers;
+        readers.push_back(std::make_unique<TimestampedTraceReader>(path0));
+        readers.push_back(std::make_unique<TimestampedTraceReader>(path1));
+        TimestampInterleaver interleaver(std::move(readers));
+        std::vector<CoreTraceOp> batch;
+        interleaver.ReadBatch(batch);
+        std::vector<uint64_t> addrs;
+        for (const auto& op : batch) addrs.push_back(op.op.addr);
+        ok &= addrs == std::vector<uint64_t>{0x0, 0x1000, 0x1040, 0x40, 0x80,
+                                             0x1080} &&
+              batch[4].op.type == 'S' && batch[5].core == 1;
+    }
+    std::remove(path0.c_str());
+    std::remove(path1.c_str());
+
+    if (ok) {
+        fmt::print("[PASS] MultiCore\n");
+    } else {
+        fmt::print("[FAIL] MultiCore\n");
+    }
+    return ok;
+}
+
+// MSI/MESI transitions on a write-shared block, directory evictions, and a
+// directory that never fires on disjoint per-core address spaces.
+using CohL3 = Cache<"L3", MainMemory<"MainMemory">, 64, 8, 64, LRUPolicy, 20>;
+using CohCore = Cache<"L1", SharedLevel<CohL3>, 16, 4, 64, LRUPolicy, 2>;
+
+template <CoherenceProtocol Protocol>
+CoherenceStats PingPong() {
+    MultiCoreSystem<CohCore, DirectoryFor<CohL3, Protocol>> system(2);
+    system.Load(0, 0x1000);
+    system.Store(0, 0x1000);  // E -> M silently under MESI
+    system.Load(1, 0x1000);   // downgrades core 0, flushing its data
+    system.Store(1, 0x1000);  // upgrade, invalidates core 0
+    // A coherence miss, served by L3 after core 1's copy is flushed.
+    if (system.Load(0, 0x1000).hit_level != 1) return {};
+    return system.Coherence().Stats();
+}
+
+bool TestCoherence() {
+    const CoherenceStats mesi = PingPong<CoherenceProtocol::kMESI>();
+    const CoherenceStats msi = PingPong<CoherenceProtocol::kMSI>();
+    bool ok = mesi.upgrades == 1 && mesi.downgrades == 2 &&
+              mesi.invalidations == 1 && mesi.flushes == 2 &&
+              mesi.coherence_misses == 1 && mesi.back_invalidations == 0;
+    ok &= msi.upgrades == 2 && msi.downgrades == 2 &&
+          msi.invalidations == 1 && msi.flushes == 2 &&
+          msi.coherence_misses == 1;
+
+    {
+        // A 2-entry directory evicts core 0's first block and takes it
+        // back from its L1.
+        MultiCoreSystem<CohCore, CoherenceDirectory<1, 2, 64>> system(2);
+        for (uint64_t addr : {0x0, 0x40, 0x80}) system.Load(0, addr);
+        ok &= system.Coherence().Stats().back_invalidations == 1 &&
+              system.Load(0, 0x0).hit_level == 1 &&
+              system.Load(0, 0x80).hit_level == 0;
+    }
+
+    // Disjoint address spaces: a large directory never probes anyone, so
+    // results match the non-coherent system.
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    std::vector<CoreTraceOp> ops;
+    uint32_t core = 0;
+    for (const char* name : {"sequential.txt", "random.txt", "temporal.txt",
+                             "largeloop.txt"}) {
+        for (TraceOp op : ParseTraceFileMapped(data_dir + name)) {
+            op.addr += uint64_t{core + 1} << 36;
+            ops.push_back({op, core});
+        }
+        core++;
+    }
+    std::stable_sort(ops.begin(), ops.end(), [](const auto& a, const auto& b) {
+        return a.op.addr % 7 < b.op.addr % 7;
+    });
+    MultiCoreSystem<MultiCore> plain(4);
+    MultiCoreSystem<MultiCore, CoherenceDirectory<4096, 16, 64>> coherent(4);
+    std::vector<AccessResult> want(ops.size());
+    std::vector<AccessResult> got(ops.size());
+    plain.AccessBatch(ops, want, 4);
+    coherent.AccessBatch(ops, got);
+    for (size_t i = 0; ok && i < ops.size(); ++i) {
+        ok &= want[i].hit_level == got[i].hit_level &&
+              want[i].total_cycles == got[i].total_cycles;
+    }
+    const CoherenceStats none = coherent.Coherence().Stats();
+    ok &= none.invalidations == 0 && none.downgrades == 0 &&
+          none.back_invalidations == 0 && none.coherence_misses == 0;
+
+    // Four cores on one Gaussian trace share and write its hot blocks.
+    const auto gaussian = ParseTraceFileMapped(data_dir + "gaussian.txt");
+    ops.clear();
+    for (const TraceOp& op : gaussian) {
+        for (uint32_t c = 0; c < 4; ++c) ops.push_back({op, c});
+    }
+    got.resize(ops.size());
+    coherent.Reset();
+    coherent.AccessBatch(ops, got);
+    ok &= coherent.Coherence().Stats().invalidations > 0 &&
+          coherent.Coherence().Stats().coherence_misses > 0;
+
+    if (ok) {
+        fmt::print("[PASS] Coherence\n");
+    } else {
+        fmt::print("[FAIL] Coherence\n");
+    }
+    return ok;
+}
+
+// Inclusive back-invalidation, exclusive victim caching, write-through and
+// no-write-allocate on tiny fully associative levels, then snapshots and
+// set-sharded runs of each.
+template <typename Write, typename Inclusion>
+using TinyL2 = Cache<"L2", MainMemory<"MainMemory">, 1, 2, 64, LRUPolicy, 10,
+                     NoPrefetcher, Write, Inclusion>;
+template <size_t Ways, typename L2, typename Write = WriteBackPolicy>
+using TinyL1 = Cache<"L1", L2, 1, Ways, 64, LRUPolicy, 1, NoPrefetcher, Write>;
+
+// A NINE L2 over a 4-line exclusive L3, and over an inclusive one.
+template <typename Inclusion>
+using TinyL3 = Cache<"L3", MainMemory<"MainMemory">, 1, 4, 64, LRUPolicy, 20,
+                     NoPrefetcher, WriteBackPolicy, Inclusion>;
+template <typename Inclusion>
+using TinyNineL2 = Cache<"L2", TinyL3<Inclusion>, 1, 2, 64, LRUPolicy, 10>;
+
+// Replays `ops` through an L1 over a plain Lower, over SharedLevel<Lower>
+// and through a one-core MultiCoreSystem; all three must agree.
+template <typename Lower, size_t L1Ways, typename Write = WriteBackPolicy>
+bool SharedMatchesPlain(const std::vector<TraceOp>& ops) {
+    using Private = TinyL1<L1Ways, SharedLevel<Lower>, Write>;
+    auto plain = std::make_unique<TinyL1<L1Ways, Lower, Write>>(100);
+    auto lower = std::make_unique<Lower>(100);
+    auto shared = std::make_unique<Private>(*lower);
+    const auto expected = Replay(*plain, ops);
+
+    MultiCoreSystem<Private> system(1);
+    std::vector<CoreTraceOp> batch;
+    for (const TraceOp& op : ops) batch.push_back({op, 0});
+    std::vector<AccessResult> batched(ops.size());
+    system.AccessBatch(batch, batched, 1);
+    return SameResults(Replay(*shared, ops), expected) &&
+           SameResults(batched, expected);
+}
+
+template <typename ShardableL2>
+using PolicyL1 = Cache<"L1", ShardableL2, 64, 8, 64, TreePLRUPolicy, 4>;
+template <typename Inclusion>
+using PolicyL2 = Cache<"L2", ShardL3, 512, 4, 128, PackedLRUPolicy, 10,
+                       NoPrefetcher, WriteBackPolicy, Inclusion>;
+
+bool TestLevelPolicies() {
+    constexpr uint64_t A = 0x0, B = 0x40, C = 0x80, D = 0xC0, E = 0x100;
+    using Inclusive = TinyL2<WriteBackPolicy, InclusivePolicy>;
+    using Exclusive = TinyL2<WriteBackPolicy, ExclusivePolicy>;
+    using Nine = TinyL2<WriteBackPolicy, NonInclusivePolicy>;
+
+    // Evicting A from the 2-line inclusive L2 takes it out of L1 too.
+    auto inclusive = std::make_unique<TinyL1<4, Inclusive>>(100);
+    auto nine = std::make_unique<TinyL1<4, Nine>>(100);
+    for (uint64_t addr : {A, B, C}) {
+        inclusive->Load(addr);
+        nine->Load(addr);
+    }
+    bool ok = inclusive->Load(A).hit_level == 2 && nine->Load(A).hit_level == 0;
+    inclusive->Reset();
+    inclusive->Store(A);
+    for (uint64_t addr : {B, C}) inclusive->Load(addr);
+    if constexpr (kInstrumentation) {
+        // L1's dirty copy leaves with the L2 victim.
+        const LevelStats l2 = inclusive->GetNext()->Stats();
+        ok &= l2.back_invalidations == 1 && l2.evictions == 1;
+    }
+
+    // A 2-line L1 over a 2-line exclusive L2 holds a 4-block loop.
+    auto exclusive = std::make_unique<TinyL1<2, Exclusive>>(100);
+    size_t memory = 0;
+    for (size_t round = 0; round < 4; ++round) {
+        for (uint64_t addr : {A, B, C, D}) {
+            memory += exclusive->Load(addr).hit_level == 2;
+        }
+    }
+    ok &= memory == 4;
+    exclusive->Reset();
+    // A dirty line moves down, back up and down again as dirty data.
+    exclusive->Store(A);
+    for (uint64_t addr : {B, C, A, D, E}) exclusive->Load(addr);
+    if constexpr (kInstrumentation) {
+        ok &= exclusive->Stats().evictions == 2 &&
+              exclusive->GetNext()->Stats().writebacks == 2;
+    }
+
+    // Write-through: every store reaches L2, and L1 never holds dirt.
+    auto through = std::make_unique<
+        TinyL1<2, Nine, WriteThroughPolicy>>(100);
+    for (uint64_t addr : {A, A, B, C}) through->Store(addr);
+    if constexpr (kInstrumentation) {
+        const LevelStats l2 = through->GetNext()->Stats();
+        // 4 posted stores + 3 allocating fetches
+        ok &= l2.hits + l2.misses == 7 && through->Stats().evictions == 0;
+    }
+
+    // No-write-allocate: a store miss leaves L1 alone.
+    auto no_alloc = std::make_unique<
+        TinyL1<2, Nine, WriteBackNoAllocatePolicy>>(100);
+    ok &= no_alloc->Store(A).hit_level == 2 && no_alloc->Load(A).hit_level == 1;
+
+    auto ops = LoadAllTestTraces();
+
+    // Only NINE levels with no inclusive level below can be shared; an
+    // exclusive level further down the shared hierarchy is fine.
+    static_assert(kSharableLevel<Nine> &&
+                  kSharableLevel<MainMemory<"MainMemory">> &&
+                  kSharableLevel<TinyNineL2<ExclusivePolicy>>);
+    static_assert(!kSharableLevel<Exclusive> && !kSharableLevel<Inclusive> &&
+                  !kSharableLevel<TinyNineL2<InclusivePolicy>>);
+    std::vector<TraceOp> aba = {{'L', A}, {'L', B}, {'L', A}};
+    for (const auto* trace : {&aba, &ops}) {
+        ok &= SharedMatchesPlain<Nine, 1>(*trace) &&
+              SharedMatchesPlain<Nine, 2, WriteThroughPolicy>(*trace) &&
+              SharedMatchesPlain<TinyNineL2<ExclusivePolicy>, 1>(*trace) &&
+              SharedMatchesPlain<MainMemory<"MainMemory">, 2>(*trace);
+    }
+
+    ok &= CheckSnapshot<PolicyL1<PolicyL2<InclusivePolicy>>>(ops) &&
+          CheckSnapshot<PolicyL1<PolicyL2<ExclusivePolicy>>>(ops) &&
+          CheckSnapshot<TinyL1<2, Exclusive, WriteThroughPolicy>>(ops);
+    using InclusiveShard = PolicyL1<PolicyL2<InclusivePolicy>>;
+    using ExclusiveShard = PolicyL1<PolicyL2<ExclusivePolicy>>;
+    static_assert(HierarchyIsSetLocal<InclusiveShard>() &&
+                  HierarchyIsSetLocal<ExclusiveShard>());
+    auto check_sharded = [&](auto serial) {
+        using Hierarchy = typename decltype(serial)::element_type;
+        const auto expected = Replay(*serial, ops);
+        SpanTraceReader reader(ops);
+        const auto run = SimulateSharded<Hierarchy>(reader, 4, 100);
+        for (size_t i = 0; i < Hierarchy::kLevels; ++i) {
+            size_t hits = 0;
+            for (const auto& r : expected) hits += r.hit_level == i;
+            if (run.stats.Level(i).hits != hits) return false;
+        }
+        return true;
+    };
+    ok &= check_sharded(std::make_unique<InclusiveShard>(100)) &&
+          check_sharded(std::make_unique<ExclusiveShard>(100));
+
+    if (ok) {
+        fmt::print("[PASS] Level Policies\n");
+    } else {
+        fmt::print("[FAIL] Level Policies\n");
+    }
+    return ok;
+}
+
+// Timed replay overlaps misses on streaming traces, merges misses to
+// in-flight blocks, and with one access in flight and uniform DRAM
+// latency reproduces the functional latencies exactly.
+using TimedL2 =
+    Cache<"L2", MainMemory<"MainMemory">, 512, 8, 64, LRUPolicy, 10>;
+using TimedL1 = Cache<"L1", TimedL2, 64, 8, 64, LRUPolicy, 4>;
+
+template <typename Hierarchy>
+TimingStats<Hierarchy::kLevels - 1> TimeTrace(
+    const std::vector<TraceOp>& ops,
+    const typename TimingModel<Hierarchy>::Config& config,
+    std::vector<AccessResult>* functional = nullptr,
+    std::vector<AccessResult>* timed = nullptr) {
+    auto system = std::make_unique<Hierarchy>(100);
+    TimingModel<Hierarchy> timing(config);
+    for (const TraceOp& op : ops) {
+        const AccessResult res = op.type == 'L' ? system->Load(op.addr)
+                                                : system->Store(op.addr);
+        const AccessResult t = timing.Time(op, res);
+        if (functional) functional->push_back(res);
+        if (timed) timed->push_back(t);
+    }
+    return timing.Stats();
+}
+
+bool TestTiming() {
+    bool ok = true;
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    const auto sequential = ParseTraceFileMapped(data_dir + "sequential.txt");
+    const auto spatial = ParseTraceFileMapped(data_dir + "spatial.txt");
+    const auto random = ParseTraceFileMapped(data_dir + "random.txt");
+
+    // Window of one, stores blocking, uniform DRAM: fully serialized.
+    TimingModel<TimedL1>::Config serial;
+    serial.core.window = 1;
+    serial.core.stores_block = true;
+    serial.dram.row_hit_cycles = 100;
+    serial.dram.row_miss_cycles = 100;
+    serial.dram.burst_cycles = 0;
+    for (const auto* ops : {&sequential, &random}) {
+        std::vector<AccessResult> functional, timed;
+        TimeTrace<TimedL1>(*ops, serial, &functional, &timed);
+        for (size_t i = 0; ok && i < functional.size(); ++i) {
+            ok &= functional[i].hit_level == timed[i].hit_level &&
+                  functional[i].total_cycles == timed[i].total_cycles;
+        }
+    }
+
+    // Streaming misses overlap (queueing on the MSHRs, so each one takes
+    // longer than alone) and mostly hit open DRAM rows.
+    std::vector<AccessResult> functional;
+    const auto stream = TimeTrace<TimedL1>(sequential, {}, &functional);
+    size_t functional_cycles = 0;
+    for (const auto& r : functional) functional_cycles += r.total_cycles;
+    ok &= stream.cycles * 4 < functional_cycles && stream.Mlp() > 1.0 &&
+          stream.dram.row_hits > stream.dram.row_misses;
+
+    // Neighbouring accesses wait on fills already in flight.
+    const auto nearby = TimeTrace<TimedL1>(spatial, {});
+    ok &= nearby.levels[0].pending_hits + nearby.levels[0].mshr_merges > 0;
+
+    // A single L1 MSHR serializes the misses.
+    TimingModel<TimedL1>::Config one_mshr;
+    one_mshr.levels[0].mshrs = 1;
+    const auto starved = TimeTrace<TimedL1>(sequential, one_mshr);
+    ok &= starved.levels[0].mshr_stalls > 0 && starved.cycles > stream.cycles;
+
+    // A row miss cheaper than a row hit is raised to it.
+    TimingModel<TimedL1>::Config inverted, flat;
+    inverted.dram.row_hit_cycles = flat.dram.row_hit_cycles = 100;
+    inverted.dram.row_miss_cycles = 40;
+    flat.dram.row_miss_cycles = 100;
+    ok &= TimeTrace<TimedL1>(random, inverted).cycles ==
+          TimeTrace<TimedL1>(random, flat).cycles;
+
+    if (ok) {
+        fmt::print("[PASS] Timing\n");
+    } else {
+        fmt::print("[FAIL] Timing\n");
+    }
+    return ok;
+}
+
+// Hierarchies read from scripts/experiments.sexp at run time match the
+// Cache<...> chains config.rkt generates for them, per access and through
+// a sweep, also with odd geometries; bad configs are rejected.
+template <typename Policy>
+using DslThreeLevel = Cache<
+    "L1",
+    Cache<"L2", Cache<"L3", MainMemory<"MainMemory">, 8192, 16, 64, Policy, 64>,
+          512, 8, 64, Policy, 64>,
+    64, 8, 64, Policy, 4>;
+using OddL2 = Cache<"L2", MainMemory<"MainMemory">, 300, 20, 128, SRRIPPolicy,
+                    12>;
+using OddL1 = Cache<"L1", OddL2, 48, 12, 32, DRRIPPolicy, 2>;
+
+bool TestDynamicCache() {
+    bool ok = true;
+    const std::string root = STRATUM_ROOT;
+    const auto configs =
+        LoadHierarchyConfigs(root + "/scripts/experiments.sexp");
+    ok &= configs.size() == 4 && configs[0].name == "case_001" &&
+          configs[1].levels.size() == 2 && configs[3].levels[0].ways == 8;
+
+    const auto ops = ParseTraceFileMapped(root + "/test/data/gaussian.txt");
+    auto matches = [&](auto compiled, const DynamicHierarchyConfig& config) {
+        DynamicCache dynamic(config, 100);
+        for (const TraceOp& op : ops) {
+            const bool load = op.type == 'L';
+            const AccessResult want =
+                load ? compiled->Load(op.addr) : compiled->Store(op.addr);
+            const AccessResult got =
+                load ? dynamic.Load(op.addr) : dynamic.Store(op.addr);
+            if (want.hit_level != got.hit_level ||
+                want.total_cycles != got.total_cycles) {
+                return false;
+            }
+        }
+        return dynamic.Levels() == config.levels.size() + 1;
+    };
+    ok &= matches(std::make_unique<DslThreeLevel<LRUPolicy>>(100), configs[0]);
+    ok &= matches(std::make_unique<DslThreeLevel<FIFOPolicy>>(100), configs[2]);
+    const auto odd = ParseHierarchyConfigs(
+        "[odd (L1 48 12 2 DRRIPPolicy L2 32)\n"
+        "     (L2 300 20 12 SRRIPPolicy MainMemory 128)]  ; comment\n");
+    ok &= odd.size() == 1 && matches(std::make_unique<OddL1>(100), odd[0]);
+    // Level names are the cache's own, not views of its config.
+    const DynamicCache owned(
+        ParseHierarchyConfigs("(c (L1 64 8 4 LRUPolicy MainMemory))")[0]);
+    ok &= owned.LevelName(0) == "L1" && owned.LevelName(1) == "MainMemory";
+
+    // The runtime sweep reports what the compiled sweep does.
+    const std::vector<SweepTrace> traces = {
+        {"Gaussian", root + "/test/data/gaussian.txt"},
+        {"Spatial", root + "/test/data/spatial.txt"}};
+    const auto want = RunSweep(
+        SweepList<SweepConfig<"case_001", DslThreeLevel<LRUPolicy>>,
+                  SweepConfig<"case_003_fifo", DslThreeLevel<FIFOPolicy>>>{},
+        traces, 2);
+    const std::vector<DynamicHierarchyConfig> swept = {configs[0],
+                                                       configs[2]};
+    const auto got = RunDynamicSweep(swept, traces, 2);
+    ok &= want.size() == got.size();
+    for (size_t i = 0; ok && i < want.size(); ++i) {
+        ok &= want[i].config == got[i].config &&
+              want[i].trace == got[i].trace &&
+              want[i].total_cycles == got[i].total_cycles &&
+              want[i].levels.size() == got[i].levels.size() &&
+              want[i].levels[0].stats.hits == got[i].levels[0].stats.hits;
+    }
+
+    for (const char* bad : {"(c (L1 64 12 4 TreePLRUPolicy MainMemory))",
+                            "(c (L1 64 8 4 LRUPolicy L2))",
+                            "(c (L1 64 8 4 LRUPolicy))",
+                            "(c (L1 64 eight 4 LRUPolicy MainMemory))",
+                            "(c (L1 64 8 4 LRUPolicy MainMemory)"}) {
+        try {
+            ParseHierarchyConfigs(bad);
+            ok = false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+
+    if (ok) {
+        fmt::print("[PASS] Dynamic Cache\n");
+    } else {
+        fmt::print("[FAIL] Dynamic Cache\n");
+    }
+    return ok;
+}
+
+// 64-set L2 behind an 8-set L1, optionally set-sampled.
+template <typename Sampler>
+using SampledL1 =
+    Cache<"L1",
+          Cache<"L2", MainMemory<>, 64, 4, 64, LRUPolicy, 10, NoPrefetcher,
+                WriteBackPolicy, NonInclusivePolicy, Sampler>,
+          8, 2, 64, LRUPolicy, 1>;
+
+bool TestSetSampling() {
+    // Samplers keep Sets / Ratio sets, and SetOf inverts Slot on them.
+    auto check_sampler = [](auto sampler) {
+        using Sampler = decltype(sampler);
+        size_t kept = 0;
+        for (uint64_t set = 0; set < 64; ++set) {
+            const uint64_t slot = Sampler::template Slot<64>(set);
+            if (slot == kUnsampledSet) continue;
+            ++kept;
+            if (slot >= Sampler::template SampledSets<64>() ||
+                Sampler::template SetOf<64>(slot) != set) {
+                return false;
+            }
+        }
+        return kept == Sampler::template SampledSets<64>();
+    };
+    bool ok = check_sampler(ModuloSetSampling<4, 1>{}) &&
+              check_sampler(HashSetSampling<8>{});
+
+    // Loads only, so every L2 access is visible as an AccessResult.
+    std::vector<TraceOp> loads;
+    for (const TraceOp& op : LoadAllTestTraces()) {
+        if (op.type == 'L') loads.push_back(op);
+    }
+    auto full = std::make_unique<SampledL1<NoSetSampling>>(100);
+    const auto expected = Replay(*full, loads);
+
+    // Sampling every set changes nothing and estimates exactly.
+    auto all = std::make_unique<SampledL1<ModuloSetSampling<1>>>(100);
+    ok &= SameResults(Replay(*all, loads), expected);
+    const SetSampledStats exact = all->GetNext()->SampledStats();
+    size_t l2_accesses = 0;
+    size_t l2_misses = 0;
+    for (const auto& r : expected) {
+        l2_accesses += r.hit_level >= 1;
+        l2_misses += r.hit_level == 2;
+    }
+    ok &= exact.sampled_accesses == l2_accesses &&
+          exact.sampled_misses == l2_misses && exact.miss_ratio.half_width == 0;
+
+    // A quarter of the sets: L1 is untouched, the sampled sets behave as in
+    // the full run, and other L2 accesses go straight to memory.
+    using Hashed = SampledL1<HashSetSampling<4>>;
+    static_assert(Hashed::kArenaBytes < SampledL1<NoSetSampling>::kArenaBytes);
+    auto hashed = std::make_unique<Hashed>(100);
+    const auto got = Replay(*hashed, loads);
+    size_t sampled_accesses = 0;
+    size_t sampled_misses = 0;
+    for (size_t i = 0; i < loads.size(); ++i) {
+        const uint64_t set = (loads[i].addr / 64) % 64;
+        const bool sampled =
+            HashSetSampling<4>::Slot<64>(set) != kUnsampledSet;
+        if (expected[i].hit_level == 0 || sampled) {
+            ok &= got[i].hit_level == expected[i].hit_level;
+        } else {
+            ok &= got[i].hit_level == 2;
+        }
+        sampled_accesses += sampled && expected[i].hit_level >= 1;
+        sampled_misses += sampled && expected[i].hit_level == 2;
+    }
+    const SetSampledStats est = hashed->GetNext()->SampledStats();
+    const double true_ratio = static_cast<double>(l2_misses) / l2_accesses;
+    ok &= est.sampled_sets == 16 && est.sets == 64 && est.scale == 4.0 &&
+          est.sampled_accesses == sampled_accesses &&
+          est.sampled_misses == sampled_misses &&
+          std::abs(est.miss_ratio.value - true_ratio) <=
+              2 * est.miss_ratio.half_width &&
+          std::abs(est.accesses.value - l2_accesses) <=
+              2 * est.accesses.half_width;
+
+    // Snapshots cover the compact arrays, and never cross samplers.
+    ok &= CheckSnapshot<Hashed>(LoadAllTestTraces()) &&
+          Hashed::Signature() != SampledL1<NoSetSampling>::Signature() &&
+          Hashed::Signature() != SampledL1<HashSetSampling<8>>::Signature();
+
+    if (ok) {
+        fmt::print("[PASS] Set Sampling\n");
+    } else {
+        fmt::print("[FAIL] Set Sampling\n");
+    }
+    return ok;
+}
+
+bool TestProgress() {
+    using Hierarchy = SampledL1<NoSetSampling>;
+    const auto ops = LoadAllTestTraces();
+    const std::string path = "unit_test_progress.jsonl";
+    std::remove(path.c_str());
+
+    // One report per millisecond while replaying, then the final totals.
+    auto cache = std::make_unique<Hierarchy>(100);
+    SimulationStats<Hierarchy::kLevels> stats;
+    ProgressCounters<Hierarchy::kLevels> counters;
+    {
+        ProgressReporter<Hierarchy::kLevels> reporter(
+            counters, "All \"test\" traces", HierarchyNames<Hierarchy>(),
+            {std::chrono::milliseconds(1), path});
+        SpanTraceReader reader(ops);
+        ReplayTrace(
+            reader, *cache,
+            [&](const TraceOp& op, const AccessResult& res) {
+                stats.Record(op, res);
+            },
+            [&] { counters.Publish(stats, ReaderProgress(reader)); });
+    }
+    bool ok = counters.ops.load() == ops.size() &&
+              counters.done.load() == ops.size() &&
+              counters.served[2].load() == stats.Level(2).hits;
+
+    std::ifstream in(path);
+    std::string line;
+    std::string last;
+    size_t lines = 0;
+    while (std::getline(in, line)) {
+        last = line;
+        ++lines;
+    }
+    in.close();
+    std::remove(path.c_str());
+    const std::string misses =
+        fmt::format("\"misses\":{}", stats.Level(0).misses);
+    ok &= lines >= 1 &&
+          last.find("\"trace\":\"All \\\"test\\\" traces\"") == 1 &&
+          last.find(fmt::format("\"ops\":{},", ops.size())) !=
+              std::string::npos &&
+          last.find("\"fraction\":1.0000") != std::string::npos &&
+          last.find(misses) != std::string::npos &&
+          last.find("\"final\":true}") != std::string::npos;
+
+    // Readers without Progress() give no ETA, and reporting is off unless
+    // an interval is set.
+    TraceReader text(std::string(STRATUM_ROOT) + "/test/data/temporal.txt");
+    ok &= ReaderProgress(text).total == 0 && !ProgressOptions{}.Enabled();
+
+    if (ok) {
+        fmt::print("[PASS] Progress\n");
+    } else {
+        fmt::print("[FAIL] Progress\n");
+    }
+    return ok;
+}
+
+int main() {
+    fmt::print("Running Unit Tests...\n");
+
+    bool ok = true;
+    ok &= TestEvictionLogic();
+    ok &= TestWriteMissDirtyFill();
+    ok &= TestMatchTags();
+    ok &= TestPackedPolicies();
+    ok &= TestRRIP();
+    ok &= TestMappedParser();
+    ok &= TestBinaryTraceRoundTrip();
+    ok &= TestSweep();
+    ok &= TestShardedSimulation();
+    ok &= TestAccessBatch();
+    ok &= TestSnapshot();
+    ok &= TestSampledSimulation();
+    ok &= TestStackDistance();
+    ok &= TestInstrumentation();
+    ok &= TestLatencyHistogram();
+    ok &= TestPrefilter();
+    ok &= TestPrefetchers();
+    ok &= TestMultiCore();
+    ok &= TestCoherence();
+    ok &= TestLevelPolicies();
+    ok &= TestTiming();
+    ok &= TestDynamicCache();
+    ok &= TestSetSampling();
+    ok &= TestProgress();
 
-    return 0;
+    return ok ? 0 : 1;
 }
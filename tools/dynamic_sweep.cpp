@@ -0,0 +1,101 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+// Sweeps hierarchies read from a config file at run time (see
+// dynamic_cache.hpp), so new geometries need neither the Racket codegen
+// nor a rebuild.
+//
+// Usage: stratum_dsweep [options] <config> [trace...]
+//                                         (default: test/data/*.txt)
+//   --threads=N        Worker threads (default: one per hardware thread)
+//   --mem-latency=N    Main memory latency in cycles (default: 100)
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stratum/dynamic_cache.hpp"
+#include "stratum/sweep.hpp"
+
+using namespace stratum;
+
+namespace {
+
+struct Options {
+  size_t threads = 0;
+  size_t mem_latency = 100;
+  std::string config;
+  std::vector<std::string> traces;
+};
+
+void PrintUsage(const char* argv0) {
+  fmt::print(stderr,
+             "Usage: {} [options] <config> [trace...]\n"
+             "  --threads=N        Worker threads "
+             "(default: one per hardware thread)\n"
+             "  --mem-latency=N    Main memory latency in cycles "
+             "(default: 100)\n",
+             argv0);
+}
+
+bool ParseOptions(int argc, char** argv, Options& opts) {
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg.starts_with("--threads=")) {
+      opts.threads = std::strtoull(arg.data() + 10, nullptr, 10);
+    } else if (arg.starts_with("--mem-latency=")) {
+      opts.mem_latency = std::strtoull(arg.data() + 14, nullptr, 10);
+    } else if (arg.starts_with("--")) {
+      return false;
+    } else if (opts.config.empty()) {
+      opts.config = arg;
+    } else {
+      opts.traces.emplace_back(arg);
+    }
+  }
+  return !opts.config.empty();
+}
+
+// Trace name for the report: the file name without directory or extension.
+std::string TraceName(const std::string& path) {
+  const size_t slash = path.find_last_of('/');
+  std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+  const size_t dot = name.find_last_of('.');
+  return dot == 0 || dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!ParseOptions(argc, argv, opts)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  if (opts.traces.empty()) {
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    for (const char* name : {"sequential.txt", "random.txt", "temporal.txt",
+                             "spatial.txt", "largeloop.txt", "gaussian.txt"}) {
+      opts.traces.push_back(data_dir + name);
+    }
+  }
+
+  std::vector<DynamicHierarchyConfig> configs;
+  try {
+    configs = LoadHierarchyConfigs(opts.config);
+  } catch (const std::exception& e) {
+    fmt::print(stderr, "Error: {}\n", e.what());
+    return 1;
+  }
+
+  std::vector<SweepTrace> traces;
+  for (const auto& path : opts.traces) {
+    traces.push_back({TraceName(path), path});
+  }
+  PrintSweepTable(
+      RunDynamicSweep(configs, traces, opts.threads, opts.mem_latency));
+  return 0;
+}
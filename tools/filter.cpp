@@ -0,0 +1,126 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+// L1 pre-filter: runs a trace once through the L1 of scripts/config.rkt
+// (64 sets x 8 ways x 64 B, LRU, 4 cycles) and writes the requests it sends
+// to L2 (demand fetches as L, dirty victims as S) as a binary trace, with
+// the L1 stats in <output>.l1, so sweeps over the lower levels replay only
+// that stream (see prefilter.hpp).
+//
+// Usage: stratum_filter [options] <input> <output>
+//        stratum_filter --replay <output>
+//   --encoding=delta|packed   Binary record encoding (default: delta)
+//   --report                  Also replay the stream into the config.rkt
+//                             L2/L3 and print the full-hierarchy report
+//   --replay                  Only do that, for a stream filtered earlier
+
+#include <fmt/core.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/cache_sim.hpp"
+#include "stratum/prefilter.hpp"
+#include "stratum/trace_parser.hpp"
+
+using namespace stratum;
+
+namespace {
+
+using MemType = MainMemory<"MainMemory">;
+using L1Type = Cache<"L1", MemType, 64, 8, 64, LRUPolicy, 4>;
+using LowerType =
+    Cache<"L2", Cache<"L3", MemType, 8192, 16, 64, LRUPolicy, 64>, 512, 8, 64,
+          LRUPolicy, 64>;
+
+struct Options {
+  TraceEncoding encoding = TraceEncoding::kDeltaVarint;
+  bool report = false;
+  bool replay = false;
+  std::string input;
+  std::string output;
+};
+
+void PrintUsage(const char* argv0) {
+  fmt::print(stderr,
+             "Usage: {0} [options] <input> <output>\n"
+             "       {0} --replay <output>\n"
+             "  --encoding=delta|packed   Binary record encoding "
+             "(default: delta)\n"
+             "  --report                  Also replay the stream into the "
+             "config.rkt L2/L3\n"
+             "  --replay                  Only do that, for a stream "
+             "filtered earlier\n",
+             argv0);
+}
+
+bool ParseOptions(int argc, char** argv, Options& opts) {
+  std::vector<std::string_view> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--encoding=delta") {
+      opts.encoding = TraceEncoding::kDeltaVarint;
+    } else if (arg == "--encoding=packed") {
+      opts.encoding = TraceEncoding::kPacked;
+    } else if (arg == "--report") {
+      opts.report = true;
+    } else if (arg == "--replay") {
+      opts.replay = true;
+    } else if (arg.starts_with("--")) {
+      return false;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+  if (opts.replay) {
+    if (positional.size() != 1) return false;
+    opts.output = positional[0];
+    return true;
+  }
+  if (positional.size() != 2) return false;
+  opts.input = positional[0];
+  opts.output = positional[1];
+  return true;
+}
+
+// Replays the stream at `path` (and its stored L1 stats) into the config.rkt
+// L2/L3 and prints the full-hierarchy report.
+bool Report(const std::string& path) {
+  auto lower = std::make_unique<LowerType>(100);
+  const auto run = RunFilteredFile(path, *lower);
+  if (!run) return false;
+  PrintFilteredReport(*run, HierarchyNames<LowerType>());
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!ParseOptions(argc, argv, opts)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  if (opts.replay) return Report(opts.output) ? 0 : 1;
+
+  std::optional<FilterStats> l1;
+  if (IsBinaryTraceFile(opts.input)) {
+    BinaryTraceReader reader(opts.input);
+    if (!reader.IsOpen()) return 1;
+    l1 = FilterTraceToFile<L1Type>(reader, opts.output, opts.encoding);
+  } else {
+    MappedTraceReader reader(opts.input);
+    if (!reader.IsOpen()) return 1;
+    l1 = FilterTraceToFile<L1Type>(reader, opts.output, opts.encoding);
+  }
+  if (!l1) return 1;
+  if (!opts.report) {
+    PrintFilterStats(*l1);
+    return 0;
+  }
+  return Report(opts.output) ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+// Miss-ratio curves from one pass of stack-distance analysis per trace.
+//
+// For each set count every associativity up to --max-ways is profiled at
+// once, so the whole (sets x ways) grid of LRU caches costs a single replay
+// instead of one simulation per geometry.
+//
+// Usage: stratum_mrc [options] [trace...]   (default: test/data/*.txt)
+//   --block-size=N     Block size in bytes (default: 64)
+//   --sets=A,B,...     Set counts to profile (default: 1,16,64,256,1024)
+//   --max-ways=N       Largest associativity (default: 16)
+//   --sample-sets=N    Track at most N sets per set count (default: all)
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/stack_distance.hpp"
+#include "stratum/trace_parser.hpp"
+
+using namespace stratum;
+
+namespace {
+
+struct Options {
+  size_t block_size = 64;
+  std::vector<size_t> sets = {1, 16, 64, 256, 1024};
+  size_t max_ways = 16;
+  size_t sample_sets = 0;
+  std::vector<std::string> traces;
+};
+
+void PrintUsage(const char* argv0) {
+  fmt::print(stderr,
+             "Usage: {} [options] [trace...]\n"
+             "  --block-size=N     Block size in bytes (default: 64)\n"
+             "  --sets=A,B,...     Set counts to profile "
+             "(default: 1,16,64,256,1024)\n"
+             "  --max-ways=N       Largest associativity (default: 16)\n"
+             "  --sample-sets=N    Track at most N sets per set count "
+             "(default: all)\n",
+             argv0);
+}
+
+bool ParseSize(std::string_view arg, std::string_view prefix, size_t& out) {
+  out = std::strtoull(arg.data() + prefix.size(), nullptr, 10);
+  return out > 0;
+}
+
+bool ParseOptions(int argc, char** argv, Options& opts) {
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg.starts_with("--block-size=")) {
+      if (!ParseSize(arg, "--block-size=", opts.block_size)) return false;
+    } else if (arg.starts_with("--max-ways=")) {
+      if (!ParseSize(arg, "--max-ways=", opts.max_ways)) return false;
+    } else if (arg.starts_with("--sample-sets=")) {
+      if (!ParseSize(arg, "--sample-sets=", opts.sample_sets)) return false;
+    } else if (arg.starts_with("--sets=")) {
+      opts.sets.clear();
+      const char* p = argv[i] + std::strlen("--sets=");
+      while (*p != '\0') {
+        char* end;
+        const size_t sets = std::strtoull(p, &end, 10);
+        if (sets == 0 || end == p) return false;
+        opts.sets.push_back(sets);
+        p = *end == ',' ? end + 1 : end;
+      }
+      if (opts.sets.empty()) return false;
+    } else if (arg.starts_with("--")) {
+      return false;
+    } else {
+      opts.traces.emplace_back(arg);
+    }
+  }
+  return true;
+}
+
+template <typename Reader>
+void PrintCurve(const std::string& path, Reader& reader, const Options& opts) {
+  auto curve = MissRatioCurve(reader, opts.block_size, opts.sets,
+                              opts.max_ways, opts.sample_sets);
+  fmt::print("\n=== Miss-Ratio Curve: {} ===\n", path);
+  fmt::print("{:>12} {:>8} {:>6} {:>10}\n", "Capacity", "Sets", "Ways",
+             "Miss %");
+  for (const auto& p : curve) {
+    fmt::print("{:>10} B {:>8} {:>6} {:>10.2f}\n", p.capacity_bytes, p.sets,
+               p.ways, p.miss_ratio * 100.0);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!ParseOptions(argc, argv, opts)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  if (opts.traces.empty()) {
+    const std::string data_dir = std::string(STRATUM_ROOT) + "/test/data/";
+    for (const char* name : {"sequential.txt", "random.txt", "temporal.txt",
+                             "spatial.txt", "largeloop.txt", "gaussian.txt"}) {
+      opts.traces.push_back(data_dir + name);
+    }
+  }
+
+  for (const auto& path : opts.traces) {
+    if (IsBinaryTraceFile(path)) {
+      BinaryTraceReader reader(path);
+      if (!reader.IsOpen()) return 1;
+      PrintCurve(path, reader, opts);
+    } else {
+      MappedTraceReader reader(path);
+      if (!reader.IsOpen()) return 1;
+      PrintCurve(path, reader, opts);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,287 @@
+// Copyright 2025 Yi-Ping Pan (Cloudlet)
+
+// Trace converter: Valgrind lackey / Stratum text / Stratum binary.
+//
+// Replaces the perl pipeline in scripts/convert_lackey.sh:
+//   valgrind --tool=lackey --trace-mem=yes ./prog 2>&1 |
+//     stratum_convert - trace.bin
+//
+// Usage: stratum_convert [options] <input|-> <output|->
+//   --from=auto|lackey|text|binary   Input format (default: auto)
+//   --to=binary|text                 Output format (default: binary)
+//   --block-size=N                   Address granularity (default: 64)
+//   --encoding=delta|packed          Binary record encoding (default: delta)
+
+#include <fmt/core.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stratum/binary_trace.hpp"
+#include "stratum/trace_parser.hpp"
+
+using namespace stratum;
+
+namespace {
+
+enum class Format { kAuto, kLackey, kText, kBinary };
+
+struct Options {
+  Format from = Format::kAuto;
+  bool to_text = false;
+  uint32_t block_size = 64;
+  TraceEncoding encoding = TraceEncoding::kDeltaVarint;
+  std::string input;
+  std::string output;
+};
+
+void PrintUsage(const char* argv0) {
+  fmt::print(stderr,
+             "Usage: {} [options] <input|-> <output|->\n"
+             "  --from=auto|lackey|text|binary   Input format (default: auto)\n"
+             "  --to=binary|text                 Output format (default: "
+             "binary)\n"
+             "  --block-size=N                   Address granularity "
+             "(default: 64)\n"
+             "  --encoding=delta|packed          Binary record encoding "
+             "(default: delta)\n",
+             argv0);
+}
+
+bool ParseOptions(int argc, char** argv, Options& opts) {
+  std::vector<std::string_view> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--from=auto") {
+      opts.from = Format::kAuto;
+    } else if (arg == "--from=lackey") {
+      opts.from = Format::kLackey;
+    } else if (arg == "--from=text") {
+      opts.from = Format::kText;
+    } else if (arg == "--from=binary") {
+      opts.from = Format::kBinary;
+    } else if (arg == "--to=binary") {
+      opts.to_text = false;
+    } else if (arg == "--to=text") {
+      opts.to_text = true;
+    } else if (arg.starts_with("--block-size=")) {
+      opts.block_size = static_cast<uint32_t>(
+          std::strtoul(argv[i] + std::strlen("--block-size="), nullptr, 10));
+      if (opts.block_size == 0) return false;
+    } else if (arg == "--encoding=delta") {
+      opts.encoding = TraceEncoding::kDeltaVarint;
+    } else if (arg == "--encoding=packed") {
+      opts.encoding = TraceEncoding::kPacked;
+    } else if (arg.starts_with("--")) {
+      return false;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+  if (positional.size() != 2) return false;
+  opts.input = positional[0];
+  opts.output = positional[1];
+  return true;
+}
+
+// Parses one lackey line (" L 04222cac,4"); instruction fetches are skipped.
+// Modify (M) accesses are recorded as stores, as in convert_lackey.sh.
+bool ParseLackeyLine(std::string_view line, TraceOp& op) {
+  if (line.size() < 3 || line[0] != ' ') return false;
+  const char kind = line[1];
+  if (kind != 'L' && kind != 'S' && kind != 'M') return false;
+
+  const char* p = line.data() + 2;
+  const char* end = line.data() + line.size();
+  while (p < end && (*p == ' ' || *p == '\t')) ++p;
+  if (end - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) p += 2;
+
+  uint64_t addr;
+  if (!detail::ParseHex(p, end, addr)) return false;
+  op.type = kind == 'L' ? 'L' : 'S';
+  op.addr = addr;
+  return true;
+}
+
+// Reads a FILE* in large chunks and hands out complete lines.
+class LineSource {
+  std::FILE* file_;
+  std::vector<char> buffer_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+  bool eof_ = false;
+
+  static constexpr size_t kChunk = 1 << 20;
+
+ public:
+  explicit LineSource(std::FILE* file) : file_(file), buffer_(kChunk) {}
+
+  // Returns the first bytes of the input without consuming them.
+  std::string_view Peek() {
+    if (end_ == begin_) Refill();
+    return {buffer_.data() + begin_, end_ - begin_};
+  }
+
+  bool Next(std::string_view& line) {
+    while (true) {
+      const char* start = buffer_.data() + begin_;
+      const void* nl = std::memchr(start, '\n', end_ - begin_);
+      if (nl != nullptr) {
+        size_t len = static_cast<const char*>(nl) - start;
+        line = {start, len};
+        begin_ += len + 1;
+        return true;
+      }
+      if (eof_) {
+        if (begin_ == end_) return false;
+        line = {start, end_ - begin_};
+        begin_ = end_;
+        return true;
+      }
+      Refill();
+    }
+  }
+
+ private:
+  void Refill() {
+    // Keep the partial line, grow if a single line exceeds the buffer.
+    size_t pending = end_ - begin_;
+    std::memmove(buffer_.data(), buffer_.data() + begin_, pending);
+    begin_ = 0;
+    end_ = pending;
+    if (buffer_.size() - end_ < kChunk / 2) buffer_.resize(buffer_.size() * 2);
+    size_t n = std::fread(buffer_.data() + end_, 1, buffer_.size() - end_,
+                          file_);
+    end_ += n;
+    if (n == 0) eof_ = true;
+  }
+};
+
+// Lackey output carries valgrind banners ("==123==") and instruction lines.
+Format DetectTextFormat(std::string_view head) {
+  size_t pos = 0;
+  while (pos < head.size()) {
+    size_t nl = head.find('\n', pos);
+    std::string_view line = head.substr(pos, nl - pos);
+    if (line.starts_with("==") || line.starts_with("I  ") ||
+        line.starts_with(" L ") || line.starts_with(" S ") ||
+        line.starts_with(" M ")) {
+      return Format::kLackey;
+    }
+    if (nl == std::string_view::npos) break;
+    pos = nl + 1;
+  }
+  return Format::kText;
+}
+
+// Output sink: binary writer or Stratum text.
+class Sink {
+  std::unique_ptr<BinaryTraceWriter> binary_;
+  std::FILE* text_ = nullptr;
+  uint64_t block_size_;
+  uint64_t count_ = 0;
+
+ public:
+  explicit Sink(const Options& opts) : block_size_(opts.block_size) {
+    if (!opts.to_text) {
+      binary_ = std::make_unique<BinaryTraceWriter>(
+          opts.output, opts.block_size, opts.encoding);
+      return;
+    }
+    text_ = opts.output == "-" ? stdout : std::fopen(opts.output.c_str(), "w");
+    if (text_ != nullptr) std::fputs("# Type  Addr\n", text_);
+  }
+
+  ~Sink() { Close(); }
+
+  bool IsOpen() const { return binary_ ? binary_->IsOpen() : text_ != nullptr; }
+  uint64_t Count() const { return count_; }
+
+  void Append(const TraceOp& op) {
+    count_++;
+    if (binary_) {
+      binary_->Append(op);
+    } else {
+      fmt::print(text_, "{}       0x{:X}\n", op.type,
+                 op.addr / block_size_ * block_size_);
+    }
+  }
+
+  // Finishes the output. Returns false if any of it could not be written.
+  bool Close() {
+    if (binary_) return binary_->Close();
+    if (text_ == nullptr) return true;
+    bool ok = std::ferror(text_) == 0;
+    ok &= (text_ == stdout ? std::fflush(text_) : std::fclose(text_)) == 0;
+    text_ = nullptr;
+    return ok;
+  }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!ParseOptions(argc, argv, opts)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  if (!opts.to_text && opts.output == "-") {
+    fmt::print(stderr, "Error: binary output needs a file (header rewrite)\n");
+    return 1;
+  }
+
+  if (opts.from == Format::kAuto && opts.input != "-" &&
+      IsBinaryTraceFile(opts.input)) {
+    opts.from = Format::kBinary;
+  }
+
+  Sink sink(opts);
+  if (!sink.IsOpen()) return 1;
+
+  if (opts.from == Format::kBinary) {
+    BinaryTraceReader reader(opts.input);
+    if (!reader.IsOpen()) return 1;
+    std::vector<TraceOp> batch;
+    while (reader.ReadBatch(batch) > 0) {
+      for (const auto& op : batch) sink.Append(op);
+    }
+  } else {
+    std::FILE* in =
+        opts.input == "-" ? stdin : std::fopen(opts.input.c_str(), "rb");
+    if (in == nullptr) {
+      fmt::print(stderr, "Error: Could not open {}\n", opts.input);
+      return 1;
+    }
+
+    LineSource source(in);
+    if (opts.from == Format::kAuto) opts.from = DetectTextFormat(source.Peek());
+
+    std::string_view line;
+    TraceOp op;
+    while (source.Next(line)) {
+      bool ok;
+      if (opts.from == Format::kLackey) {
+        ok = ParseLackeyLine(line, op);
+      } else {
+        const char* p = line.data();
+        ok = NextTraceOp(p, line.data() + line.size(), op);
+      }
+      if (ok) sink.Append(op);
+    }
+    if (in != stdin) std::fclose(in);
+  }
+  if (!sink.Close()) {
+    fmt::print(stderr, "Error: Could not write {}\n", opts.output);
+    return 1;
+  }
+
+  fmt::print(stderr, "Converted {} -> {} ({} ops)\n", opts.input, opts.output,
+             sink.Count());
+  return 0;
+}